@@ -12,9 +12,12 @@
 
 #include <config.h>
 #include "store-application.h"
+#include "store-trace.h"
 
 int main (int argc, char **argv)
 {
+    store_trace_init ();
+
     setlocale (LC_ALL, "");
 
     bindtextdomain (GETTEXT_PACKAGE, LOCALEDIR);
@@ -11,16 +11,27 @@
 
 #include "store-app-tile.h"
 
-struct _StoreAppGrid
-{
-    GtkGrid parent_instance;
+#define SPACING 20
 
-    GtkGrid *app_grid;
+/* A tile and the index of the app it is showing, or -1 if spare */
+typedef struct
+{
+    GtkWidget *tile;
+    gint index;
+} Slot;
 
+typedef struct
+{
+    GPtrArray *apps;
+    guint grow_slots_id;
     StoreModel *model;
-};
+    guint n_columns;
+    gint row_height;
+    GPtrArray *slots;
+    GtkAdjustment *vadjustment;
+} StoreAppGridPrivate;
 
-G_DEFINE_TYPE (StoreAppGrid, store_app_grid, GTK_TYPE_GRID)
+G_DEFINE_TYPE_WITH_PRIVATE (StoreAppGrid, store_app_grid, GTK_TYPE_CONTAINER)
 
 enum
 {
@@ -31,27 +42,406 @@ enum
 static guint signals[SIGNAL_LAST] = { 0, };
 
 static void
-app_activated_cb (StoreAppGrid *self, StoreAppTile *tile)
+tile_activated_cb (StoreAppGrid *self, GtkWidget *tile)
+{
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    for (guint i = 0; i < priv->slots->len; i++) {
+        Slot *slot = g_ptr_array_index (priv->slots, i);
+        if (slot->tile == tile && slot->index >= 0) {
+            g_signal_emit (self, signals[SIGNAL_APP_ACTIVATED], 0, g_ptr_array_index (priv->apps, slot->index));
+            return;
+        }
+    }
+}
+
+static guint
+get_n_apps (StoreAppGrid *self)
+{
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+    return priv->apps->len;
+}
+
+static guint
+get_n_rows (StoreAppGrid *self)
+{
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+    return (get_n_apps (self) + priv->n_columns - 1) / priv->n_columns;
+}
+
+static Slot *
+add_slot (StoreAppGrid *self)
+{
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    Slot *slot = g_new0 (Slot, 1);
+    slot->tile = STORE_APP_GRID_GET_CLASS (self)->create_tile (self);
+    slot->index = -1;
+    gtk_widget_show (slot->tile);
+    gtk_widget_set_child_visible (slot->tile, FALSE);
+    g_signal_connect_object (slot->tile, "activated", G_CALLBACK (tile_activated_cb), self, G_CONNECT_SWAPPED);
+    STORE_APP_GRID_GET_CLASS (self)->set_tile_model (self, slot->tile, priv->model);
+    g_ptr_array_add (priv->slots, slot);
+    gtk_widget_set_parent (slot->tile, GTK_WIDGET (self));
+
+    return slot;
+}
+
+static void
+assign_slot (StoreAppGrid *self, Slot *slot, gint index)
+{
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    StoreApp *app = index >= 0 ? g_ptr_array_index (priv->apps, index) : NULL;
+    slot->index = index;
+    STORE_APP_GRID_GET_CLASS (self)->set_tile_app (self, slot->tile, app);
+    gtk_widget_set_child_visible (slot->tile, app != NULL);
+}
+
+/* Rows are all the same height, the tallest tile seen so far so it doesn't jump around when scrolling */
+static gint
+get_row_height (StoreAppGrid *self)
+{
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    for (guint i = 0; i < priv->slots->len; i++) {
+        Slot *slot = g_ptr_array_index (priv->slots, i);
+        if (slot->index < 0)
+            continue;
+
+        gint height;
+        gtk_widget_get_preferred_height (slot->tile, NULL, &height);
+        priv->row_height = MAX (priv->row_height, height);
+    }
+
+    return priv->row_height;
+}
+
+/* Tiles are assigned when allocated, so only the ones near the viewport are made.
+ * Need one showing an app to know how big the rows are */
+static void
+ensure_row_height (StoreAppGrid *self)
 {
-    g_signal_emit (self, signals[SIGNAL_APP_ACTIVATED], 0, store_app_tile_get_app (tile));
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    if (get_n_apps (self) == 0)
+        return;
+
+    for (guint i = 0; i < priv->slots->len; i++) {
+        Slot *slot = g_ptr_array_index (priv->slots, i);
+        if (slot->index >= 0)
+            return;
+    }
+
+    assign_slot (self, priv->slots->len > 0 ? g_ptr_array_index (priv->slots, 0) : add_slot (self), 0);
+}
+
+/* Rows in the viewport, plus a page either side so tiles are ready before they are scrolled to */
+static void
+get_visible_rows (StoreAppGrid *self, guint *first_row, guint *last_row)
+{
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    guint n_rows = get_n_rows (self);
+    gint stride = priv->row_height + SPACING;
+
+    /* Until a row has been measured there's no telling how many fit, so only make the first */
+    *first_row = 0;
+    *last_row = MIN (n_rows, 1);
+    if (priv->row_height == 0)
+        return;
+
+    /* Without a scrolled window everything is visible */
+    *last_row = n_rows;
+    GtkWidget *scrolled_window = gtk_widget_get_ancestor (GTK_WIDGET (self), GTK_TYPE_SCROLLED_WINDOW);
+    if (scrolled_window == NULL)
+        return;
+
+    gint x, y;
+    if (!gtk_widget_translate_coordinates (GTK_WIDGET (self), scrolled_window, 0, 0, &x, &y))
+        return;
+    GtkAdjustment *vadjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (scrolled_window));
+    gint page_size = gtk_adjustment_get_page_size (vadjustment);
+    gint top = -y - page_size;
+    gint bottom = -y + 2 * page_size;
+
+    *first_row = top > 0 ? MIN (top / stride, n_rows) : 0;
+    *last_row = bottom > 0 ? MIN (bottom / stride + 1, n_rows) : 0;
+    if (*last_row < *first_row)
+        *last_row = *first_row;
+}
+
+/* Indexes of the apps in range */
+static void
+get_visible_range (StoreAppGrid *self, guint *start, guint *end)
+{
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    guint first_row, last_row;
+    get_visible_rows (self, &first_row, &last_row);
+    *start = MIN (first_row * priv->n_columns, get_n_apps (self));
+    *end = MIN (last_row * priv->n_columns, get_n_apps (self));
+}
+
+/* Give each app in range a tile, reusing the ones that have gone out of range.
+ * Returns the number of tiles the range needs, which may be more than there are */
+static guint
+update_slots (StoreAppGrid *self)
+{
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    guint start, end;
+    get_visible_range (self, &start, &end);
+
+    /* Keep tiles that are still in range so they don't need rebinding */
+    g_autofree gboolean *assigned = g_new0 (gboolean, end > start ? end - start : 1);
+    for (guint i = 0; i < priv->slots->len; i++) {
+        Slot *slot = g_ptr_array_index (priv->slots, i);
+        if (slot->index >= (gint) start && slot->index < (gint) end)
+            assigned[slot->index - start] = TRUE;
+        else if (slot->index >= 0)
+            assign_slot (self, slot, -1);
+    }
+
+    guint next_slot = 0;
+    for (guint index = start; index < end; index++) {
+        if (assigned[index - start])
+            continue;
+
+        Slot *slot = NULL;
+        while (next_slot < priv->slots->len && slot == NULL) {
+            Slot *s = g_ptr_array_index (priv->slots, next_slot);
+            if (s->index < 0)
+                slot = s;
+            next_slot++;
+        }
+        if (slot == NULL)
+            break;
+        assign_slot (self, slot, index);
+    }
+
+    return end - start;
+}
+
+static gboolean
+grow_slots_cb (GtkWidget *widget, GdkFrameClock *clock G_GNUC_UNUSED, gpointer user_data G_GNUC_UNUSED)
+{
+    StoreAppGrid *self = STORE_APP_GRID (widget);
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    priv->grow_slots_id = 0;
+
+    guint start, end;
+    get_visible_range (self, &start, &end);
+    while (priv->slots->len < end - start)
+        add_slot (self);
+    gtk_widget_queue_allocate (widget);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+adjustment_changed_cb (StoreAppGrid *self)
+{
+    gtk_widget_queue_allocate (GTK_WIDGET (self));
+}
+
+static void
+disconnect_adjustment (StoreAppGrid *self)
+{
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    if (priv->vadjustment != NULL)
+        g_signal_handlers_disconnect_by_func (priv->vadjustment, adjustment_changed_cb, self);
+    g_clear_object (&priv->vadjustment);
 }
 
 static void
 store_app_grid_dispose (GObject *object)
 {
     StoreAppGrid *self = STORE_APP_GRID (object);
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
 
-    g_clear_object (&self->model);
+    disconnect_adjustment (self);
+    if (priv->grow_slots_id != 0)
+        gtk_widget_remove_tick_callback (GTK_WIDGET (self), priv->grow_slots_id);
+    priv->grow_slots_id = 0;
+    g_clear_object (&priv->model);
 
     G_OBJECT_CLASS (store_app_grid_parent_class)->dispose (object);
 }
 
+static void
+store_app_grid_finalize (GObject *object)
+{
+    StoreAppGrid *self = STORE_APP_GRID (object);
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    g_clear_pointer (&priv->apps, g_ptr_array_unref);
+    g_clear_pointer (&priv->slots, g_ptr_array_unref);
+
+    G_OBJECT_CLASS (store_app_grid_parent_class)->finalize (object);
+}
+
+static void
+store_app_grid_get_preferred_width (GtkWidget *widget, gint *minimum, gint *natural)
+{
+    StoreAppGrid *self = STORE_APP_GRID (widget);
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    gint tile_minimum = 0, tile_natural = 0;
+    for (guint i = 0; i < priv->slots->len; i++) {
+        Slot *slot = g_ptr_array_index (priv->slots, i);
+        gint min, nat;
+        gtk_widget_get_preferred_width (slot->tile, &min, &nat);
+        tile_minimum = MAX (tile_minimum, min);
+        tile_natural = MAX (tile_natural, nat);
+    }
+
+    *minimum = tile_minimum * priv->n_columns + SPACING * (priv->n_columns - 1);
+    *natural = tile_natural * priv->n_columns + SPACING * (priv->n_columns - 1);
+}
+
+static void
+store_app_grid_get_preferred_height (GtkWidget *widget, gint *minimum, gint *natural)
+{
+    StoreAppGrid *self = STORE_APP_GRID (widget);
+
+    guint n_rows = get_n_rows (self);
+    gint height = n_rows > 0 ? n_rows * get_row_height (self) + (n_rows - 1) * SPACING : 0;
+    *minimum = *natural = height;
+}
+
+static void
+store_app_grid_size_allocate (GtkWidget *widget, GtkAllocation *allocation)
+{
+    StoreAppGrid *self = STORE_APP_GRID (widget);
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    gtk_widget_set_allocation (widget, allocation);
+
+    /* Adding tiles here would change the widget tree while it is being allocated,
+     * so any more that are needed are made before the next frame */
+    guint n_slots = update_slots (self);
+    if (n_slots > priv->slots->len && priv->grow_slots_id == 0)
+        priv->grow_slots_id = gtk_widget_add_tick_callback (widget, grow_slots_cb, NULL, NULL);
+
+    /* Newly shown tiles might be taller than any seen before */
+    gint old_row_height = priv->row_height;
+    gint row_height = get_row_height (self);
+    if (row_height != old_row_height)
+        gtk_widget_queue_resize (widget);
+
+    gint column_width = MAX ((allocation->width - SPACING * ((gint) priv->n_columns - 1)) / (gint) priv->n_columns, 0);
+    for (guint i = 0; i < priv->slots->len; i++) {
+        Slot *slot = g_ptr_array_index (priv->slots, i);
+        if (slot->index < 0)
+            continue;
+
+        gtk_widget_get_preferred_width (slot->tile, NULL, NULL);
+        GtkAllocation child_allocation;
+        child_allocation.x = allocation->x + (slot->index % (gint) priv->n_columns) * (column_width + SPACING);
+        child_allocation.y = allocation->y + (slot->index / (gint) priv->n_columns) * (row_height + SPACING);
+        child_allocation.width = column_width;
+        child_allocation.height = row_height;
+        gtk_widget_size_allocate (slot->tile, &child_allocation);
+    }
+}
+
+static void
+store_app_grid_map (GtkWidget *widget)
+{
+    StoreAppGrid *self = STORE_APP_GRID (widget);
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    /* Follow scrolling so tiles can be moved to the rows coming into view */
+    disconnect_adjustment (self);
+    GtkWidget *scrolled_window = gtk_widget_get_ancestor (widget, GTK_TYPE_SCROLLED_WINDOW);
+    if (scrolled_window != NULL) {
+        priv->vadjustment = g_object_ref (gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (scrolled_window)));
+        g_signal_connect_swapped (priv->vadjustment, "value-changed", G_CALLBACK (adjustment_changed_cb), self);
+        g_signal_connect_swapped (priv->vadjustment, "changed", G_CALLBACK (adjustment_changed_cb), self);
+    }
+
+    GTK_WIDGET_CLASS (store_app_grid_parent_class)->map (widget);
+
+    /* The viewport may have moved while unmapped */
+    gtk_widget_queue_allocate (widget);
+}
+
+static void
+store_app_grid_unmap (GtkWidget *widget)
+{
+    StoreAppGrid *self = STORE_APP_GRID (widget);
+
+    disconnect_adjustment (self);
+
+    GTK_WIDGET_CLASS (store_app_grid_parent_class)->unmap (widget);
+}
+
+static void
+store_app_grid_forall (GtkContainer *container, gboolean include_internals, GtkCallback callback, gpointer callback_data)
+{
+    StoreAppGrid *self = STORE_APP_GRID (container);
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    /* Backwards as the callback may remove the tile */
+    for (guint i = priv->slots->len; i > 0; i--) {
+        Slot *slot = g_ptr_array_index (priv->slots, i - 1);
+        callback (slot->tile, callback_data);
+    }
+}
+
+static void
+store_app_grid_remove (GtkContainer *container, GtkWidget *child)
+{
+    StoreAppGrid *self = STORE_APP_GRID (container);
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    for (guint i = 0; i < priv->slots->len; i++) {
+        Slot *slot = g_ptr_array_index (priv->slots, i);
+        if (slot->tile == child) {
+            gtk_widget_unparent (child);
+            g_ptr_array_remove_index (priv->slots, i);
+            return;
+        }
+    }
+}
+
+static GtkWidget *
+store_app_grid_real_create_tile (StoreAppGrid *self G_GNUC_UNUSED)
+{
+    return GTK_WIDGET (store_app_tile_new ());
+}
+
+static void
+store_app_grid_real_set_tile_app (StoreAppGrid *self G_GNUC_UNUSED, GtkWidget *tile, StoreApp *app)
+{
+    store_app_tile_set_app (STORE_APP_TILE (tile), app);
+}
+
+static void
+store_app_grid_real_set_tile_model (StoreAppGrid *self G_GNUC_UNUSED, GtkWidget *tile, StoreModel *model)
+{
+    store_app_tile_set_model (STORE_APP_TILE (tile), model);
+}
+
 static void
 store_app_grid_class_init (StoreAppGridClass *klass)
 {
     G_OBJECT_CLASS (klass)->dispose = store_app_grid_dispose;
+    G_OBJECT_CLASS (klass)->finalize = store_app_grid_finalize;
+    GTK_WIDGET_CLASS (klass)->get_preferred_width = store_app_grid_get_preferred_width;
+    GTK_WIDGET_CLASS (klass)->get_preferred_height = store_app_grid_get_preferred_height;
+    GTK_WIDGET_CLASS (klass)->size_allocate = store_app_grid_size_allocate;
+    GTK_WIDGET_CLASS (klass)->map = store_app_grid_map;
+    GTK_WIDGET_CLASS (klass)->unmap = store_app_grid_unmap;
+    GTK_CONTAINER_CLASS (klass)->forall = store_app_grid_forall;
+    GTK_CONTAINER_CLASS (klass)->remove = store_app_grid_remove;
 
-    gtk_widget_class_set_template_from_resource (GTK_WIDGET_CLASS (klass), "/io/snapcraft/Store/store-app-grid.ui");
+    klass->create_tile = store_app_grid_real_create_tile;
+    klass->set_tile_app = store_app_grid_real_set_tile_app;
+    klass->set_tile_model = store_app_grid_real_set_tile_model;
 
     signals[SIGNAL_APP_ACTIVATED] = g_signal_new ("app-activated",
                                                   G_TYPE_FROM_CLASS (G_OBJECT_CLASS (klass)),
@@ -66,7 +456,13 @@ store_app_grid_class_init (StoreAppGridClass *klass)
 static void
 store_app_grid_init (StoreAppGrid *self)
 {
-    gtk_widget_init_template (GTK_WIDGET (self));
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    gtk_widget_set_has_window (GTK_WIDGET (self), FALSE);
+
+    priv->apps = g_ptr_array_new_with_free_func (g_object_unref);
+    priv->n_columns = 3;
+    priv->slots = g_ptr_array_new_with_free_func (g_free);
 }
 
 StoreAppGrid *
@@ -75,48 +471,124 @@ store_app_grid_new (void)
     return g_object_new (store_app_grid_get_type (), NULL);
 }
 
+void
+store_app_grid_set_n_columns (StoreAppGrid *self, guint n_columns)
+{
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    g_return_if_fail (STORE_IS_APP_GRID (self));
+    g_return_if_fail (n_columns > 0);
+
+    priv->n_columns = n_columns;
+    gtk_widget_queue_resize (GTK_WIDGET (self));
+}
+
 void
 store_app_grid_set_apps (StoreAppGrid *self, GPtrArray *apps)
 {
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
     g_return_if_fail (STORE_IS_APP_GRID (self));
 
-    /* Ensure correct number of app tiles */
-    // FIXME: Make a new widget that does this
-    g_autoptr(GList) children = gtk_container_get_children (GTK_CONTAINER (self));
-    guint n_tiles = g_list_length (children);
-    while (n_tiles < apps->len) {
-        StoreAppTile *tile = store_app_tile_new ();
-        gtk_widget_show (GTK_WIDGET (tile));
-        g_signal_connect_object (tile, "activated", G_CALLBACK (app_activated_cb), self, G_CONNECT_SWAPPED);
-        store_app_tile_set_model (tile, self->model);
-        gtk_grid_attach (GTK_GRID (self), GTK_WIDGET (tile), n_tiles % 3, n_tiles / 3, 1, 1);
-        n_tiles++;
+    /* Keep a copy so the grid can be updated a change at a time */
+    g_ptr_array_set_size (priv->apps, 0);
+    for (guint i = 0; apps != NULL && i < apps->len; i++)
+        g_ptr_array_add (priv->apps, g_object_ref (g_ptr_array_index (apps, i)));
+
+    /* Tiles keep their position and show whatever app is there now */
+    for (guint i = 0; i < priv->slots->len; i++) {
+        Slot *slot = g_ptr_array_index (priv->slots, i);
+        if (slot->index >= (gint) get_n_apps (self))
+            assign_slot (self, slot, -1);
+        else if (slot->index >= 0)
+            assign_slot (self, slot, slot->index);
     }
-    for (GList *link = children; link != NULL; link = link->next) {
-        GtkWidget *child = link->data;
-        int left_attach, top_attach;
-        gtk_container_child_get (GTK_CONTAINER (self), child, "left-attach", &left_attach, "top-attach", &top_attach, NULL);
-        guint index = top_attach * 3 + left_attach;
-        if (index >= apps->len)
-            gtk_container_remove (GTK_CONTAINER (self), child);
+    ensure_row_height (self);
+
+    gtk_widget_queue_resize (GTK_WIDGET (self));
+}
+
+void
+store_app_grid_insert_app (StoreAppGrid *self, guint position, StoreApp *app)
+{
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    g_return_if_fail (STORE_IS_APP_GRID (self));
+    g_return_if_fail (position <= get_n_apps (self));
+
+    g_ptr_array_insert (priv->apps, position, g_object_ref (app));
+
+    /* Tiles after the change keep their app and just move, the new app gets a tile when allocated */
+    for (guint i = 0; i < priv->slots->len; i++) {
+        Slot *slot = g_ptr_array_index (priv->slots, i);
+        if (slot->index >= (gint) position)
+            slot->index++;
+    }
+    ensure_row_height (self);
+
+    gtk_widget_queue_resize (GTK_WIDGET (self));
+}
+
+void
+store_app_grid_move_app (StoreAppGrid *self, guint from, guint to)
+{
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    g_return_if_fail (STORE_IS_APP_GRID (self));
+    g_return_if_fail (from < get_n_apps (self));
+    g_return_if_fail (to < get_n_apps (self));
+
+    gpointer app = g_object_ref (g_ptr_array_index (priv->apps, from));
+    g_ptr_array_remove_index (priv->apps, from);
+    g_ptr_array_insert (priv->apps, to, app);
+
+    /* The moved tile and the ones it passes keep their app and just move */
+    for (guint i = 0; i < priv->slots->len; i++) {
+        Slot *slot = g_ptr_array_index (priv->slots, i);
+        if (slot->index == (gint) from)
+            slot->index = to;
+        else if (from < to && slot->index > (gint) from && slot->index <= (gint) to)
+            slot->index--;
+        else if (to < from && slot->index >= (gint) to && slot->index < (gint) from)
+            slot->index++;
     }
 
-    for (guint i = 0; i < apps->len; i++) {
-        StoreApp *app = g_ptr_array_index (apps, i);
-        StoreAppTile *tile = STORE_APP_TILE (gtk_grid_get_child_at (GTK_GRID (self), i % 3, i / 3));
-        store_app_tile_set_app (tile, app);
+    gtk_widget_queue_allocate (GTK_WIDGET (self));
+}
+
+void
+store_app_grid_remove_app (StoreAppGrid *self, guint position)
+{
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
+    g_return_if_fail (STORE_IS_APP_GRID (self));
+    g_return_if_fail (position < get_n_apps (self));
+
+    /* Tiles after the change keep their app and just move */
+    for (guint i = 0; i < priv->slots->len; i++) {
+        Slot *slot = g_ptr_array_index (priv->slots, i);
+        if (slot->index == (gint) position)
+            assign_slot (self, slot, -1);
+        else if (slot->index > (gint) position)
+            slot->index--;
     }
+
+    g_ptr_array_remove_index (priv->apps, position);
+    ensure_row_height (self);
+
+    gtk_widget_queue_resize (GTK_WIDGET (self));
 }
 
 void
 store_app_grid_set_model (StoreAppGrid *self, StoreModel *model)
 {
+    StoreAppGridPrivate *priv = store_app_grid_get_instance_private (self);
+
     g_return_if_fail (STORE_IS_APP_GRID (self));
 
-    g_set_object (&self->model, model);
-    g_autoptr(GList) children = gtk_container_get_children (GTK_CONTAINER (self));
-    for (GList *link = children; link != NULL; link = link->next) {
-        StoreAppTile *tile = link->data;
-        store_app_tile_set_model (tile, model);
+    g_set_object (&priv->model, model);
+    for (guint i = 0; i < priv->slots->len; i++) {
+        Slot *slot = g_ptr_array_index (priv->slots, i);
+        STORE_APP_GRID_GET_CLASS (self)->set_tile_model (self, slot->tile, model);
     }
 }
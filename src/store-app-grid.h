@@ -16,12 +16,30 @@
 
 G_BEGIN_DECLS
 
-G_DECLARE_FINAL_TYPE (StoreAppGrid, store_app_grid, STORE, APP_GRID, GtkGrid)
+G_DECLARE_DERIVABLE_TYPE (StoreAppGrid, store_app_grid, STORE, APP_GRID, GtkContainer)
 
-StoreAppGrid *store_app_grid_new       (void);
+struct _StoreAppGridClass
+{
+    GtkContainerClass parent_class;
 
-void          store_app_grid_set_apps  (StoreAppGrid *grid, GPtrArray *apps);
+    /* Tiles are recycled, so set_tile_app is called again each time a tile shows a different app */
+    GtkWidget *(*create_tile)    (StoreAppGrid *grid);
+    void       (*set_tile_app)   (StoreAppGrid *grid, GtkWidget *tile, StoreApp *app);
+    void       (*set_tile_model) (StoreAppGrid *grid, GtkWidget *tile, StoreModel *model);
+};
 
-void          store_app_grid_set_model (StoreAppGrid *grid, StoreModel *model);
+StoreAppGrid *store_app_grid_new           (void);
+
+void          store_app_grid_set_n_columns (StoreAppGrid *grid, guint n_columns);
+
+void          store_app_grid_set_apps      (StoreAppGrid *grid, GPtrArray *apps);
+
+void          store_app_grid_insert_app    (StoreAppGrid *grid, guint position, StoreApp *app);
+
+void          store_app_grid_move_app      (StoreAppGrid *grid, guint from, guint to);
+
+void          store_app_grid_remove_app    (StoreAppGrid *grid, guint position);
+
+void          store_app_grid_set_model     (StoreAppGrid *grid, StoreModel *model);
 
 G_END_DECLS
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "store-app-installed-list.h"
+
+#include "store-app-installed-tile.h"
+
+/* A single column app grid of installed tiles, following a list model */
+struct _StoreAppInstalledList
+{
+    StoreAppGrid parent_instance;
+
+    GListModel *apps;
+};
+
+G_DEFINE_TYPE (StoreAppInstalledList, store_app_installed_list, store_app_grid_get_type ())
+
+static void
+items_changed_cb (StoreAppInstalledList *self, guint position, guint removed, guint added)
+{
+    /* Tiles after the change keep their app and just move, only the changed rows need new ones */
+    for (guint i = 0; i < removed; i++)
+        store_app_grid_remove_app (STORE_APP_GRID (self), position);
+    for (guint i = 0; i < added; i++) {
+        g_autoptr(StoreApp) app = g_list_model_get_item (self->apps, position + i);
+        store_app_grid_insert_app (STORE_APP_GRID (self), position + i, app);
+    }
+}
+
+static void
+store_app_installed_list_dispose (GObject *object)
+{
+    StoreAppInstalledList *self = STORE_APP_INSTALLED_LIST (object);
+
+    if (self->apps != NULL)
+        g_signal_handlers_disconnect_by_func (self->apps, items_changed_cb, self);
+    g_clear_object (&self->apps);
+
+    G_OBJECT_CLASS (store_app_installed_list_parent_class)->dispose (object);
+}
+
+static GtkWidget *
+store_app_installed_list_create_tile (StoreAppGrid *grid G_GNUC_UNUSED)
+{
+    return GTK_WIDGET (store_app_installed_tile_new ());
+}
+
+static void
+store_app_installed_list_set_tile_app (StoreAppGrid *grid G_GNUC_UNUSED, GtkWidget *tile, StoreApp *app)
+{
+    store_app_installed_tile_set_app (STORE_APP_INSTALLED_TILE (tile), app);
+}
+
+static void
+store_app_installed_list_set_tile_model (StoreAppGrid *grid G_GNUC_UNUSED, GtkWidget *tile, StoreModel *model)
+{
+    store_app_installed_tile_set_model (STORE_APP_INSTALLED_TILE (tile), model);
+}
+
+static void
+store_app_installed_list_class_init (StoreAppInstalledListClass *klass)
+{
+    G_OBJECT_CLASS (klass)->dispose = store_app_installed_list_dispose;
+    STORE_APP_GRID_CLASS (klass)->create_tile = store_app_installed_list_create_tile;
+    STORE_APP_GRID_CLASS (klass)->set_tile_app = store_app_installed_list_set_tile_app;
+    STORE_APP_GRID_CLASS (klass)->set_tile_model = store_app_installed_list_set_tile_model;
+}
+
+static void
+store_app_installed_list_init (StoreAppInstalledList *self)
+{
+    store_app_grid_set_n_columns (STORE_APP_GRID (self), 1);
+}
+
+StoreAppInstalledList *
+store_app_installed_list_new (void)
+{
+    return g_object_new (store_app_installed_list_get_type (), NULL);
+}
+
+void
+store_app_installed_list_set_apps (StoreAppInstalledList *self, GListModel *apps)
+{
+    g_return_if_fail (STORE_IS_APP_INSTALLED_LIST (self));
+
+    if (self->apps == apps)
+        return;
+
+    if (self->apps != NULL)
+        g_signal_handlers_disconnect_by_func (self->apps, items_changed_cb, self);
+    store_app_grid_set_apps (STORE_APP_GRID (self), NULL);
+    g_set_object (&self->apps, apps);
+    if (self->apps != NULL) {
+        g_signal_connect_object (self->apps, "items-changed", G_CALLBACK (items_changed_cb), self, G_CONNECT_SWAPPED);
+        items_changed_cb (self, 0, 0, g_list_model_get_n_items (self->apps));
+    }
+}
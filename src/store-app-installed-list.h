@@ -0,0 +1,24 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+#include "store-app-grid.h"
+
+G_BEGIN_DECLS
+
+G_DECLARE_FINAL_TYPE (StoreAppInstalledList, store_app_installed_list, STORE, APP_INSTALLED_LIST, StoreAppGrid)
+
+StoreAppInstalledList *store_app_installed_list_new      (void);
+
+void                   store_app_installed_list_set_apps (StoreAppInstalledList *list, GListModel *apps);
+
+G_END_DECLS
@@ -12,12 +12,14 @@
 
 #include "store-app-page.h"
 
+#include "store-cancellable.h"
 #include "store-channel-combo.h"
 #include "store-image.h"
 #include "store-rating-label.h"
 #include "store-review-summary.h"
 #include "store-review-view.h"
 #include "store-screenshot-view.h"
+#include "store-trace.h"
 
 struct _StoreAppPage
 {
@@ -34,6 +36,7 @@ struct _StoreAppPage
     StoreImage *icon_image;
     GtkButton *install_button;
     GtkButton *launch_button;
+    GtkButton *more_reviews_button;
     GtkLabel *publisher_label;
     GtkImage *publisher_validated_image;
     StoreRatingLabel *rating_label;
@@ -48,6 +51,7 @@ struct _StoreAppPage
 
     StoreApp *app;
     GCancellable *cancellable;
+    GPtrArray *reviews;
 };
 
 enum
@@ -121,17 +125,71 @@ refresh_cb (GObject *object, GAsyncResult *result, gpointer user_data G_GNUC_UNU
         g_warning ("Failed to refresh app: %s", error->message);
         return;
     }
+
+    store_trace_mark ("app-refreshed");
+}
+
+static void
+update_more_reviews_button (StoreAppPage *self)
+{
+    StoreModel *model = store_page_get_model (STORE_PAGE (self));
+    gtk_widget_set_visible (GTK_WIDGET (self->more_reviews_button), self->app != NULL && store_model_get_has_more_reviews (model, self->app));
+    gtk_widget_set_sensitive (GTK_WIDGET (self->more_reviews_button), TRUE);
+}
+
+static void
+reviews_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    StoreAppPage *self = user_data;
+
+    g_autoptr(GError) error = NULL;
+    if (!store_model_update_reviews_finish (STORE_MODEL (object), result, &error)) {
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            return;
+        g_warning ("Failed to get reviews: %s", error->message);
+    }
+
+    update_more_reviews_button (self);
+}
+
+static void
+more_reviews_loaded_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    StoreAppPage *self = user_data;
+
+    g_autoptr(GError) error = NULL;
+    if (!store_model_load_more_reviews_finish (STORE_MODEL (object), result, &error)) {
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            return;
+        g_warning ("Failed to get more reviews: %s", error->message);
+    }
+
+    update_more_reviews_button (self);
 }
 
 static void
 store_app_page_set_reviews (StoreAppPage *self, GPtrArray *reviews)
 {
-    g_autoptr(GList) children = gtk_container_get_children (GTK_CONTAINER (self->reviews_box));
-    for (GList *link = children; link != NULL; link = link->next) {
-        GtkWidget *child = link->data;
-        gtk_container_remove (GTK_CONTAINER (self->reviews_box), child);
+    /* Only add the new reviews if more were loaded */
+    guint n_shown = 0;
+    if (self->reviews != NULL && reviews->len >= self->reviews->len) {
+        n_shown = self->reviews->len;
+        for (guint i = 0; i < self->reviews->len; i++) {
+            if (g_ptr_array_index (reviews, i) != g_ptr_array_index (self->reviews, i)) {
+                n_shown = 0;
+                break;
+            }
+        }
     }
-    for (guint i = 0; i < reviews->len; i++) {
+
+    if (n_shown == 0) {
+        g_autoptr(GList) children = gtk_container_get_children (GTK_CONTAINER (self->reviews_box));
+        for (GList *link = children; link != NULL; link = link->next) {
+            GtkWidget *child = link->data;
+            gtk_container_remove (GTK_CONTAINER (self->reviews_box), child);
+        }
+    }
+    for (guint i = n_shown; i < reviews->len; i++) {
         StoreOdrsReview *review = g_ptr_array_index (reviews, i);
         StoreReviewView *view = store_review_view_new ();
         gtk_widget_show (GTK_WIDGET (view));
@@ -139,6 +197,9 @@ store_app_page_set_reviews (StoreAppPage *self, GPtrArray *reviews)
         gtk_container_add (GTK_CONTAINER (self->reviews_box), GTK_WIDGET (view));
     }
     gtk_widget_set_visible (GTK_WIDGET (self->reviews_box), reviews->len > 0);
+
+    g_clear_pointer (&self->reviews, g_ptr_array_unref);
+    self->reviews = g_ptr_array_ref (reviews);
 }
 
 static void
@@ -163,6 +224,13 @@ launch_cb (StoreAppPage *self)
         g_warning ("Failed to launch app: %s", error->message); // FIXME: Show graphically
 }
 
+static void
+more_reviews_cb (StoreAppPage *self)
+{
+    gtk_widget_set_sensitive (GTK_WIDGET (self->more_reviews_button), FALSE);
+    store_model_load_more_reviews_async (store_page_get_model (STORE_PAGE (self)), self->app, self->cancellable, more_reviews_loaded_cb, self);
+}
+
 static void
 remove_cb (StoreAppPage *self)
 {
@@ -177,6 +245,7 @@ store_app_page_dispose (GObject *object)
     g_clear_object (&self->app);
     g_cancellable_cancel (self->cancellable);
     g_clear_object (&self->cancellable);
+    g_clear_pointer (&self->reviews, g_ptr_array_unref);
 
     G_OBJECT_CLASS (store_app_page_parent_class)->dispose (object);
 }
@@ -240,6 +309,7 @@ store_app_page_class_init (StoreAppPageClass *klass)
     gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreAppPage, icon_image);
     gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreAppPage, install_button);
     gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreAppPage, launch_button);
+    gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreAppPage, more_reviews_button);
     gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreAppPage, publisher_label);
     gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreAppPage, publisher_validated_image);
     gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreAppPage, rating_label);
@@ -255,6 +325,7 @@ store_app_page_class_init (StoreAppPageClass *klass)
     gtk_widget_class_bind_template_callback (GTK_WIDGET_CLASS (klass), contact_link_cb);
     gtk_widget_class_bind_template_callback (GTK_WIDGET_CLASS (klass), install_cb);
     gtk_widget_class_bind_template_callback (GTK_WIDGET_CLASS (klass), launch_cb);
+    gtk_widget_class_bind_template_callback (GTK_WIDGET_CLASS (klass), more_reviews_cb);
     gtk_widget_class_bind_template_callback (GTK_WIDGET_CLASS (klass), remove_cb);
 }
 
@@ -275,13 +346,15 @@ store_app_page_set_app (StoreAppPage *self, StoreApp *app)
 {
     g_return_if_fail (STORE_IS_APP_PAGE (self));
 
-    if (self->app == app)
+    /* Reload if the page was left before it finished loading */
+    if (self->app == app && !g_cancellable_is_cancelled (self->cancellable))
         return;
 
     g_set_object (&self->app, app);
 
     g_cancellable_cancel (self->cancellable);
-    self->cancellable = g_cancellable_new ();
+    g_clear_object (&self->cancellable);
+    self->cancellable = store_cancellable_new_child (store_page_get_cancellable (STORE_PAGE (self)));
     store_app_refresh_async (app, self->cancellable, refresh_cb, self);
 
     g_object_bind_property (app, "title", self->title_label, "label", G_BINDING_SYNC_CREATE);
@@ -325,8 +398,9 @@ store_app_page_set_app (StoreAppPage *self, StoreApp *app)
     g_object_bind_property (app, "installed", self->install_button, "visible", G_BINDING_SYNC_CREATE | G_BINDING_INVERT_BOOLEAN);
 
     gtk_widget_hide (GTK_WIDGET (self->reviews_box));
+    gtk_widget_hide (GTK_WIDGET (self->more_reviews_button));
 
-    store_model_update_reviews_async (store_page_get_model (STORE_PAGE (self)), app, self->cancellable, NULL, NULL);
+    store_model_update_reviews_async (store_page_get_model (STORE_PAGE (self)), app, self->cancellable, reviews_cb, self);
 
     store_screenshot_view_set_app (self->screenshot_view, app);
     GPtrArray *screenshots = store_app_get_screenshots (app);
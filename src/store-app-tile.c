@@ -24,6 +24,7 @@ struct _StoreAppTile
     GtkLabel *title_label;
 
     StoreApp *app;
+    GPtrArray *bindings;
 };
 
 G_DEFINE_TYPE (StoreAppTile, store_app_tile, GTK_TYPE_EVENT_BOX)
@@ -43,11 +44,22 @@ button_release_event_cb (StoreAppTile *self)
     return TRUE;
 }
 
+static void
+unbind_app (StoreAppTile *self)
+{
+    for (guint i = 0; i < self->bindings->len; i++)
+        g_binding_unbind (g_ptr_array_index (self->bindings, i));
+    g_ptr_array_set_size (self->bindings, 0);
+}
+
 static void
 store_app_tile_dispose (GObject *object)
 {
     StoreAppTile *self = STORE_APP_TILE (object);
 
+    if (self->bindings != NULL)
+        unbind_app (self);
+    g_clear_pointer (&self->bindings, g_ptr_array_unref);
     g_clear_object (&self->app);
 
     G_OBJECT_CLASS (store_app_tile_parent_class)->dispose (object);
@@ -85,6 +97,8 @@ store_app_tile_init (StoreAppTile *self)
     store_image_get_type ();
     store_rating_label_get_type ();
     gtk_widget_init_template (GTK_WIDGET (self));
+
+    self->bindings = g_ptr_array_new ();
 }
 
 StoreAppTile *
@@ -108,16 +122,19 @@ store_app_tile_set_app (StoreAppTile *self, StoreApp *app)
     if (self->app == app)
         return;
 
+    /* Tiles are recycled, so stop following the previous app */
+    unbind_app (self);
     g_clear_object (&self->app);
-    if (app != NULL)
-        self->app = g_object_ref (app);
-
-    g_object_bind_property (app, "icon", self->icon_image, "media", G_BINDING_SYNC_CREATE);
-    g_object_bind_property (app, "publisher", self->publisher_label, "label", G_BINDING_SYNC_CREATE);
-    g_object_bind_property (app, "publisher-validated", self->publisher_validated_image, "visible", G_BINDING_SYNC_CREATE);
-    g_object_bind_property (app, "review-average", self->rating_label, "rating", G_BINDING_SYNC_CREATE);
-    g_object_bind_property (app, "summary", self->summary_label, "label", G_BINDING_SYNC_CREATE);
-    g_object_bind_property (app, "title", self->title_label, "label", G_BINDING_SYNC_CREATE);
+    if (app == NULL)
+        return;
+    self->app = g_object_ref (app);
+
+    g_ptr_array_add (self->bindings, g_object_bind_property (app, "icon", self->icon_image, "media", G_BINDING_SYNC_CREATE));
+    g_ptr_array_add (self->bindings, g_object_bind_property (app, "publisher", self->publisher_label, "label", G_BINDING_SYNC_CREATE));
+    g_ptr_array_add (self->bindings, g_object_bind_property (app, "publisher-validated", self->publisher_validated_image, "visible", G_BINDING_SYNC_CREATE));
+    g_ptr_array_add (self->bindings, g_object_bind_property (app, "review-average", self->rating_label, "rating", G_BINDING_SYNC_CREATE));
+    g_ptr_array_add (self->bindings, g_object_bind_property (app, "summary", self->summary_label, "label", G_BINDING_SYNC_CREATE));
+    g_ptr_array_add (self->bindings, g_object_bind_property (app, "title", self->title_label, "label", G_BINDING_SYNC_CREATE));
 }
 
 StoreApp *
@@ -10,6 +10,7 @@
 #include <math.h>
 
 #include "store-app.h"
+#include "store-odrs-review.h"
 
 typedef struct
 {
@@ -70,6 +71,32 @@ enum
 
 G_DEFINE_TYPE_WITH_PRIVATE (StoreApp, store_app, G_TYPE_OBJECT)
 
+static gboolean
+array_equal (GPtrArray *a, GPtrArray *b, GEqualFunc equal)
+{
+    guint a_len = a != NULL ? a->len : 0;
+    guint b_len = b != NULL ? b->len : 0;
+
+    if (a == b)
+        return TRUE;
+    if (a_len != b_len)
+        return FALSE;
+
+    for (guint i = 0; i < a_len; i++)
+        if (!equal (g_ptr_array_index (a, i), g_ptr_array_index (b, i)))
+            return FALSE;
+
+    return TRUE;
+}
+
+static gboolean
+date_equal (GDateTime *a, GDateTime *b)
+{
+    if (a == NULL || b == NULL)
+        return a == b;
+    return g_date_time_equal (a, b);
+}
+
 static void
 store_app_dispose (GObject *object)
 {
@@ -413,7 +440,11 @@ void
 store_app_update_from_cache (StoreApp *self, StoreCache *cache)
 {
     g_return_if_fail (STORE_IS_APP (self));
+
+    /* Emit a single notify per changed property once all fields are loaded */
+    g_object_freeze_notify (G_OBJECT (self));
     STORE_APP_GET_CLASS (self)->update_from_cache (self, cache);
+    g_object_thaw_notify (G_OBJECT (self));
 }
 
 void
@@ -423,6 +454,9 @@ store_app_set_appstream_id (StoreApp *self, const gchar *appstream_id)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (g_strcmp0 (priv->appstream_id, appstream_id) == 0)
+        return;
+
     g_clear_pointer (&priv->appstream_id, g_free);
     priv->appstream_id = g_strdup (appstream_id);
 }
@@ -444,6 +478,9 @@ store_app_set_banner (StoreApp *self, StoreMedia *banner)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (store_media_equal (priv->banner, banner))
+        return;
+
     g_clear_object (&priv->banner);
     if (banner != NULL)
         priv->banner = g_object_ref (banner);
@@ -468,6 +505,9 @@ store_app_set_channels (StoreApp *self, GPtrArray *channels)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (array_equal (priv->channels, channels, (GEqualFunc) store_channel_equal))
+        return;
+
     g_clear_pointer (&priv->channels, g_ptr_array_unref);
     if (channels != NULL)
         priv->channels = g_ptr_array_ref (channels);
@@ -492,6 +532,9 @@ store_app_set_contact (StoreApp *self, const gchar *contact)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (g_strcmp0 (priv->contact, contact) == 0)
+        return;
+
     g_clear_pointer (&priv->contact, g_free);
     priv->contact = g_strdup (contact);
 
@@ -515,6 +558,9 @@ store_app_set_description (StoreApp *self, const gchar *description)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (g_strcmp0 (priv->description, description) == 0)
+        return;
+
     g_clear_pointer (&priv->description, g_free);
     priv->description = g_strdup (description);
 
@@ -538,6 +584,9 @@ store_app_set_icon (StoreApp *self, StoreMedia *icon)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (store_media_equal (priv->icon, icon))
+        return;
+
     g_clear_object (&priv->icon);
     if (icon != NULL)
         priv->icon = g_object_ref (icon);
@@ -562,6 +611,9 @@ store_app_set_installed (StoreApp *self, gboolean installed)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (priv->installed == installed)
+        return;
+
     priv->installed = installed;
 
     g_object_notify (G_OBJECT (self), "installed");
@@ -584,6 +636,9 @@ store_app_set_installed_size (StoreApp *self, gint64 size)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (priv->installed_size == size)
+        return;
+
     priv->installed_size = size;
 
     g_object_notify (G_OBJECT (self), "installed-size");
@@ -606,6 +661,9 @@ store_app_set_license (StoreApp *self, const gchar *license)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (g_strcmp0 (priv->license, license) == 0)
+        return;
+
     g_clear_pointer (&priv->license, g_free);
     priv->license = g_strdup (license);
 
@@ -629,6 +687,9 @@ store_app_set_name (StoreApp *self, const gchar *name)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (g_strcmp0 (priv->name, name) == 0)
+        return;
+
     g_clear_pointer (&priv->name, g_free);
     priv->name = g_strdup (name);
 
@@ -652,6 +713,9 @@ store_app_set_publisher (StoreApp *self, const gchar *publisher)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (g_strcmp0 (priv->publisher, publisher) == 0)
+        return;
+
     g_clear_pointer (&priv->publisher, g_free);
     priv->publisher = g_strdup (publisher);
 
@@ -675,7 +739,12 @@ store_app_set_publisher_validated (StoreApp *self, gboolean validated)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (priv->publisher_validated == validated)
+        return;
+
     priv->publisher_validated = validated;
+
+    g_object_notify (G_OBJECT (self), "publisher-validated");
 }
 
 gboolean
@@ -765,6 +834,9 @@ store_app_set_review_count_one_star (StoreApp *self, gint64 count)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (priv->review_count_one_star == count)
+        return;
+
     priv->review_count_one_star = count;
 
     g_object_notify (G_OBJECT (self), "review-count-one-star");
@@ -779,6 +851,9 @@ store_app_set_review_count_two_star (StoreApp *self, gint64 count)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (priv->review_count_two_star == count)
+        return;
+
     priv->review_count_two_star = count;
 
     g_object_notify (G_OBJECT (self), "review-count-two-star");
@@ -793,6 +868,9 @@ store_app_set_review_count_three_star (StoreApp *self, gint64 count)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (priv->review_count_three_star == count)
+        return;
+
     priv->review_count_three_star = count;
 
     g_object_notify (G_OBJECT (self), "review-count-three-star");
@@ -807,6 +885,9 @@ store_app_set_review_count_four_star (StoreApp *self, gint64 count)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (priv->review_count_four_star == count)
+        return;
+
     priv->review_count_four_star = count;
 
     g_object_notify (G_OBJECT (self), "review-count-four-star");
@@ -821,6 +902,9 @@ store_app_set_review_count_five_star (StoreApp *self, gint64 count)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (priv->review_count_five_star == count)
+        return;
+
     priv->review_count_five_star = count;
 
     g_object_notify (G_OBJECT (self), "review-count-five-star");
@@ -835,6 +919,9 @@ store_app_set_reviews (StoreApp *self, GPtrArray *reviews)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (array_equal (priv->reviews, reviews, (GEqualFunc) store_odrs_review_equal))
+        return;
+
     g_clear_pointer (&priv->reviews, g_ptr_array_unref);
     if (reviews != NULL)
         priv->reviews = g_ptr_array_ref (reviews);
@@ -859,6 +946,9 @@ store_app_set_screenshots (StoreApp *self, GPtrArray *screenshots)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (array_equal (priv->screenshots, screenshots, (GEqualFunc) store_media_equal))
+        return;
+
     g_clear_pointer (&priv->screenshots, g_ptr_array_unref);
     if (screenshots != NULL)
         priv->screenshots = g_ptr_array_ref (screenshots);
@@ -883,6 +973,9 @@ store_app_set_summary (StoreApp *self, const gchar *summary)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (g_strcmp0 (priv->summary, summary) == 0)
+        return;
+
     g_clear_pointer (&priv->summary, g_free);
     priv->summary = g_strdup (summary);
 
@@ -906,6 +999,9 @@ store_app_set_title (StoreApp *self, const gchar *title)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (g_strcmp0 (priv->title, title) == 0)
+        return;
+
     g_clear_pointer (&priv->title, g_free);
     priv->title = g_strdup (title);
 
@@ -929,6 +1025,9 @@ store_app_set_updated_date (StoreApp *self, GDateTime *date)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (date_equal (priv->updated_date, date))
+        return;
+
     g_clear_pointer (&priv->updated_date, g_date_time_unref);
     if (date != NULL)
         priv->updated_date = g_date_time_ref (date);
@@ -953,6 +1052,9 @@ store_app_set_version (StoreApp *self, const gchar *version)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (g_strcmp0 (priv->version, version) == 0)
+        return;
+
     g_clear_pointer (&priv->version, g_free);
     priv->version = g_strdup (version);
 
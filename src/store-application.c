@@ -14,6 +14,8 @@
 #include "store-application.h"
 #include "store-category.h"
 #include "store-model.h"
+#include "store-search-provider.h"
+#include "store-trace.h"
 #include "store-window.h"
 
 struct _StoreApplication
@@ -24,9 +26,16 @@ struct _StoreApplication
 
     GCancellable *cancellable;
     GtkCssProvider *css_provider;
+    gboolean loaded;
     StoreModel *model;
+    guint32 present_time;
+    StoreSearchProvider *search_provider;
+    gboolean show_window;
 };
 
+/* How long to keep running when started by the search provider */
+#define INACTIVITY_TIMEOUT 30000
+
 G_DEFINE_TYPE (StoreApplication, store_application, GTK_TYPE_APPLICATION)
 
 static void
@@ -38,6 +47,7 @@ store_application_dispose (GObject *object)
     g_clear_object (&self->cancellable);
     g_clear_object (&self->css_provider);
     g_clear_object (&self->model);
+    g_clear_object (&self->search_provider);
 
     G_OBJECT_CLASS (store_application_parent_class)->dispose (object);
 }
@@ -48,15 +58,100 @@ theme_changed_cb (StoreApplication *self)
     gtk_css_provider_load_from_resource (self->css_provider, "/io/snapcraft/Store/gtk-style.css");
 }
 
+static void
+load_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    StoreApplication *self = user_data;
+
+    g_autoptr(GError) error = NULL;
+    if (!store_model_load_finish (STORE_MODEL (object), result, &error)) {
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            return;
+        g_warning ("Failed to load cache: %s", error->message);
+    }
+
+    /* Show once the home page has something to paint */
+    self->loaded = TRUE;
+    if (self->show_window && self->window != NULL) {
+        gtk_window_present_with_time (GTK_WINDOW (self->window), self->present_time);
+        store_trace_mark ("window-presented");
+    }
+
+    /* Refresh after loading so only stale data is fetched */
+    store_model_start_refresh (self->model);
+}
+
+static void
+window_destroy_cb (StoreApplication *self)
+{
+    self->window = NULL;
+    self->show_window = FALSE;
+}
+
+static void
+ensure_window (StoreApplication *self)
+{
+    if (self->window != NULL)
+        return;
+
+    if (!self->loaded)
+        store_model_load_async (self->model, self->cancellable, load_cb, self);
+
+    self->window = store_window_new (self);
+    g_signal_connect_object (self->window, "destroy", G_CALLBACK (window_destroy_cb), self, G_CONNECT_SWAPPED);
+    store_window_set_model (self->window, self->model);
+    gint64 window_start_time = store_trace_begin ();
+    store_window_load (self->window);
+    store_trace_end ("window-load", window_start_time);
+}
+
+static void
+present_window (StoreApplication *self, guint32 timestamp)
+{
+    ensure_window (self);
+
+    self->show_window = TRUE;
+    self->present_time = timestamp;
+    if (self->loaded)
+        gtk_window_present_with_time (GTK_WINDOW (self->window), timestamp);
+}
+
+static void
+activate_result_cb (StoreApplication *self, const gchar *name, guint32 timestamp)
+{
+    present_window (self, timestamp);
+
+    g_autoptr(StoreSnapApp) app = store_model_get_snap (self->model, name);
+    store_window_show_app (self->window, STORE_APP (app));
+}
+
+static void
+launch_search_cb (StoreApplication *self, const gchar *query, guint32 timestamp)
+{
+    present_window (self, timestamp);
+
+    store_window_search (self->window, query);
+}
+
 static int
 store_application_command_line (GApplication *application, GApplicationCommandLine *command_line)
 {
     StoreApplication *self = STORE_APPLICATION (application);
 
+    gint64 start_time = store_trace_begin ();
+
     GVariantDict *options = g_application_command_line_get_options_dict (command_line);
 
-    if (g_variant_dict_contains (options, "no-cache"))
+    if (g_variant_dict_contains (options, "trace-startup")) {
+        const gchar *path;
+        g_variant_dict_lookup (options, "trace-startup", "^&ay", &path);
+        store_trace_set_output (path);
+    }
+
+    if (g_variant_dict_contains (options, "no-cache")) {
         store_model_set_cache (self->model, NULL);
+        store_search_provider_set_cache (self->search_provider, NULL);
+    }
 
     if (g_variant_dict_contains (options, "odrs-server")) {
         const gchar *uri;
@@ -70,17 +165,20 @@ store_application_command_line (GApplication *application, GApplicationCommandLi
         store_model_set_snapd_socket_path (self->model, path);
     }
 
+    if (g_variant_dict_contains (options, "record")) {
+        const gchar *path;
+        g_variant_dict_lookup (options, "record", "^&ay", &path);
+        g_autoptr(GError) error = NULL;
+        if (!store_model_start_recording (self->model, path, &error))
+            g_warning ("Failed to start recording: %s", error->message);
+    }
+
     if (g_variant_dict_contains (options, "version")) {
         g_print ("snap-store " VERSION "\n");
         return 0;
     }
 
-    store_model_load (self->model);
-    store_model_update_ratings_async (self->model, NULL, NULL, NULL);
-
-    self->window = store_window_new (self);
-    store_window_set_model (self->window, self->model);
-    store_window_load (self->window);
+    present_window (self, GDK_CURRENT_TIME);
 
     int args_length;
     g_auto(GStrv) args = g_application_command_line_get_arguments (command_line, &args_length);
@@ -107,7 +205,7 @@ store_application_command_line (GApplication *application, GApplicationCommandLi
         }
     }
 
-    gtk_window_present (GTK_WINDOW (self->window));
+    store_trace_end ("command-line", start_time);
 
     return -1;
 }
@@ -125,11 +223,53 @@ store_application_startup (GApplication *application)
     theme_changed_cb (self);
 }
 
+static void
+store_application_shutdown (GApplication *application)
+{
+    g_autoptr(GError) error = NULL;
+    if (!store_trace_write (&error))
+        g_warning ("Failed to write startup trace: %s", error->message);
+
+    G_APPLICATION_CLASS (store_application_parent_class)->shutdown (application);
+}
+
 static void
 store_application_activate (GApplication *application)
 {
     StoreApplication *self = STORE_APPLICATION (application);
-    gtk_window_present (GTK_WINDOW (self->window));
+    present_window (self, GDK_CURRENT_TIME);
+}
+
+static gboolean
+store_application_dbus_register (GApplication *application, GDBusConnection *connection, const gchar *object_path, GError **error)
+{
+    StoreApplication *self = STORE_APPLICATION (application);
+
+    if (!G_APPLICATION_CLASS (store_application_parent_class)->dbus_register (application, connection, object_path, error))
+        return FALSE;
+
+    g_autofree gchar *search_provider_path = g_strdup_printf ("%s/SearchProvider", object_path);
+    if (!store_search_provider_register (self->search_provider, connection, search_provider_path, error))
+        return FALSE;
+
+    /* Started by the shell to search, so have the index ready before the first
+     * query and exit again once the searches stop */
+    if ((g_application_get_flags (application) & G_APPLICATION_IS_SERVICE) != 0) {
+        store_search_provider_update_index (self->search_provider);
+        g_application_set_inactivity_timeout (application, INACTIVITY_TIMEOUT);
+    }
+
+    return TRUE;
+}
+
+static void
+store_application_dbus_unregister (GApplication *application, GDBusConnection *connection, const gchar *object_path)
+{
+    StoreApplication *self = STORE_APPLICATION (application);
+
+    store_search_provider_unregister (self->search_provider);
+
+    G_APPLICATION_CLASS (store_application_parent_class)->dbus_unregister (application, connection, object_path);
 }
 
 static void
@@ -138,7 +278,10 @@ store_application_class_init (StoreApplicationClass *klass)
     G_OBJECT_CLASS (klass)->dispose = store_application_dispose;
     G_APPLICATION_CLASS (klass)->command_line = store_application_command_line;
     G_APPLICATION_CLASS (klass)->startup = store_application_startup;
+    G_APPLICATION_CLASS (klass)->shutdown = store_application_shutdown;
     G_APPLICATION_CLASS (klass)->activate = store_application_activate;
+    G_APPLICATION_CLASS (klass)->dbus_register = store_application_dbus_register;
+    G_APPLICATION_CLASS (klass)->dbus_unregister = store_application_dbus_unregister;
 }
 
 static void
@@ -161,6 +304,16 @@ store_application_init (StoreApplication *self)
            _("Socket snapd server is using"),
            /* Help text for argument to --snapd-socket-path command line option */
            _("PATH") },
+        { "trace-startup", 0, 0, G_OPTION_ARG_FILENAME, NULL,
+           /* Help text for --trace-startup command line option */
+           _("Write startup timings to a file in Chrome trace format"),
+           /* Help text for argument to --trace-startup command line option */
+           _("FILE") },
+        { "record", 0, 0, G_OPTION_ARG_FILENAME, NULL,
+           /* Help text for --record command line option */
+           _("Record snapd and network traffic to a file for replaying"),
+           /* Help text for argument to --record command line option */
+           _("FILE") },
         { NULL }
     };
 
@@ -168,8 +321,11 @@ store_application_init (StoreApplication *self)
 
     self->cancellable = g_cancellable_new ();
     self->model = store_model_new ();
-    g_autoptr(StoreCache) cache = store_cache_new ();
-    store_model_set_cache (self->model, cache);
+
+    self->search_provider = store_search_provider_new ();
+    store_search_provider_set_cache (self->search_provider, store_model_get_cache (self->model));
+    g_signal_connect_object (self->search_provider, "activate-result", G_CALLBACK (activate_result_cb), self, G_CONNECT_SWAPPED);
+    g_signal_connect_object (self->search_provider, "launch-search", G_CALLBACK (launch_search_cb), self, G_CONNECT_SWAPPED);
 }
 
 StoreApplication *
@@ -180,3 +336,10 @@ store_application_new (void)
                          "flags", G_APPLICATION_HANDLES_COMMAND_LINE,
                          NULL);
 }
+
+StoreModel *
+store_application_get_model (StoreApplication *self)
+{
+    g_return_val_if_fail (STORE_IS_APPLICATION (self), NULL);
+    return self->model;
+}
@@ -11,10 +11,14 @@
 
 #include <gtk/gtk.h>
 
+#include "store-model.h"
+
 G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (StoreApplication, store_application, STORE, APPLICATION, GtkApplication)
 
-StoreApplication *store_application_new (void);
+StoreApplication *store_application_new       (void);
+
+StoreModel       *store_application_get_model (StoreApplication *application);
 
 G_END_DECLS
@@ -16,16 +16,23 @@ struct _StoreCache
 
 G_DEFINE_TYPE (StoreCache, store_cache, G_TYPE_OBJECT)
 
+static gchar *
+get_cache_dir (const gchar *type)
+{
+    return g_build_filename (g_get_user_cache_dir (), "snap-store", type, NULL);
+}
+
 static GFile *
 get_cache_file (const gchar *type, const gchar *name, gboolean hash)
 {
+    g_autofree gchar *dir = get_cache_dir (type);
     g_autofree gchar *filename = NULL;
     if (hash) {
         g_autofree gchar *hashed_name = g_compute_checksum_for_string (G_CHECKSUM_SHA1, name, -1);
-        filename = g_build_filename (g_get_user_cache_dir (), "snap-store", type, hashed_name, NULL);
+        filename = g_build_filename (dir, hashed_name, NULL);
     }
     else
-        filename = g_build_filename (g_get_user_cache_dir (), "snap-store", type, name, NULL);
+        filename = g_build_filename (dir, name, NULL);
     return g_file_new_for_path (filename);
 }
 
@@ -126,6 +133,43 @@ store_cache_lookup_sync (StoreCache *self, const gchar *type, const gchar *name,
     return g_bytes_new_take (g_steal_pointer (&contents), contents_length);
 }
 
+/* Names of the entries of @type, only meaningful for entries inserted without hashing */
+GStrv
+store_cache_list (StoreCache *self, const gchar *type, GCancellable *cancellable, GError **error)
+{
+    g_return_val_if_fail (STORE_IS_CACHE (self), NULL);
+
+    g_autofree gchar *path = get_cache_dir (type);
+    g_autoptr(GFile) dir = g_file_new_for_path (path);
+    g_autoptr(GPtrArray) names = g_ptr_array_new_with_free_func (g_free);
+
+    g_autoptr(GError) local_error = NULL;
+    g_autoptr(GFileEnumerator) enumerator = g_file_enumerate_children (dir, G_FILE_ATTRIBUTE_STANDARD_NAME "," G_FILE_ATTRIBUTE_STANDARD_TYPE, G_FILE_QUERY_INFO_NONE, cancellable, &local_error);
+    if (enumerator == NULL) {
+        if (!g_error_matches (local_error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND)) {
+            g_propagate_error (error, g_steal_pointer (&local_error));
+            return NULL;
+        }
+    }
+    else {
+        while (TRUE) {
+            GFileInfo *info;
+            if (!g_file_enumerator_iterate (enumerator, &info, NULL, cancellable, error))
+                return NULL;
+            if (info == NULL)
+                break;
+
+            /* Skip partially written files */
+            const gchar *name = g_file_info_get_name (info);
+            if (g_file_info_get_file_type (info) == G_FILE_TYPE_REGULAR && name[0] != '.')
+                g_ptr_array_add (names, g_strdup (name));
+        }
+    }
+    g_ptr_array_add (names, NULL);
+
+    return (GStrv) g_ptr_array_free (g_steal_pointer (&names), FALSE);
+}
+
 JsonNode *
 store_cache_lookup_json (StoreCache *self, const gchar *type, const gchar *name, gboolean hash, GCancellable *cancellable, GError **error)
 {
@@ -29,6 +29,8 @@ GBytes     *store_cache_lookup_finish (StoreCache *cache, GAsyncResult *result,
 
 GBytes     *store_cache_lookup_sync   (StoreCache *cache, const gchar *type, const gchar *name, gboolean hash, GCancellable *cancellable, GError **error);
 
+GStrv       store_cache_list          (StoreCache *cache, const gchar *type, GCancellable *cancellable, GError **error);
+
 JsonNode   *store_cache_lookup_json   (StoreCache *cache, const gchar *type, const gchar *name, gboolean hash, GCancellable *cancellable, GError **error);
 
 G_END_DECLS
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "store-cancellable.h"
+
+/* Make a cancellable for work done within the scope of another, e.g. a page */
+GCancellable *
+store_cancellable_new_child (GCancellable *parent)
+{
+    g_return_val_if_fail (parent == NULL || G_IS_CANCELLABLE (parent), NULL);
+
+    GCancellable *cancellable = g_cancellable_new ();
+    store_cancellable_link (cancellable, parent);
+    return cancellable;
+}
+
+/* Cancel @cancellable when @parent is cancelled. A cancellable can be linked to
+ * more than one parent, and the link goes away when it is destroyed. */
+void
+store_cancellable_link (GCancellable *cancellable, GCancellable *parent)
+{
+    g_return_if_fail (G_IS_CANCELLABLE (cancellable));
+    g_return_if_fail (parent == NULL || G_IS_CANCELLABLE (parent));
+
+    if (parent == NULL)
+        return;
+
+    if (g_cancellable_is_cancelled (parent)) {
+        g_cancellable_cancel (cancellable);
+        return;
+    }
+
+    /* Use the signal rather than g_cancellable_connect() so the handler is
+     * dropped automatically when the child is finalized */
+    g_signal_connect_object (parent, "cancelled", G_CALLBACK (g_cancellable_cancel), cancellable, G_CONNECT_SWAPPED);
+}
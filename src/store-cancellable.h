@@ -0,0 +1,20 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+GCancellable *store_cancellable_new_child (GCancellable *parent);
+
+void          store_cancellable_link      (GCancellable *cancellable, GCancellable *parent);
+
+G_END_DECLS
@@ -46,6 +46,59 @@ button_release_event_cb (StoreAppSmallTile *self)
     return TRUE;
 }
 
+static void
+update_tiles (StoreCategoryList *self, guint start)
+{
+    GPtrArray *apps = store_category_get_apps (self->category);
+    guint n_apps = apps->len < 5 ? apps->len : 5;
+
+    /* Changes past the visible tiles don't affect us */
+    if (start >= 5)
+        return;
+
+    /* Ensure correct number of app tiles */
+    g_autoptr(GList) children = gtk_container_get_children (GTK_CONTAINER (self->app_box));
+    guint n_tiles = g_list_length (children);
+    while (n_tiles < n_apps) {
+        StoreAppSmallTile *tile = store_app_small_tile_new ();
+        gtk_widget_show (GTK_WIDGET (tile));
+        g_signal_connect_object (tile, "activated", G_CALLBACK (app_activated_cb), self, G_CONNECT_SWAPPED);
+        store_app_small_tile_set_model (tile, self->model);
+        gtk_container_add (GTK_CONTAINER (self->app_box), GTK_WIDGET (tile));
+        n_tiles++;
+        children = g_list_append (children, tile);
+    }
+    for (GList *link = g_list_nth (children, n_apps); link != NULL; link = link->next) {
+        StoreAppSmallTile *tile = link->data;
+        gtk_container_remove (GTK_CONTAINER (self->app_box), GTK_WIDGET (tile));
+    }
+
+    /* Only tiles from the first changed position can have a different app */
+    GList *link = g_list_nth (children, start);
+    for (guint i = start; i < n_apps; i++, link = link->next) {
+        StoreApp *app = g_ptr_array_index (apps, i);
+        store_app_small_tile_set_app (link->data, app);
+    }
+}
+
+static void
+app_inserted_cb (StoreCategoryList *self, guint position)
+{
+    update_tiles (self, position);
+}
+
+static void
+app_moved_cb (StoreCategoryList *self, guint from, guint to)
+{
+    update_tiles (self, MIN (from, to));
+}
+
+static void
+app_removed_cb (StoreCategoryList *self, guint position)
+{
+    update_tiles (self, position);
+}
+
 static void
 store_category_list_dispose (GObject *object)
 {
@@ -106,36 +159,19 @@ store_category_list_set_category (StoreCategoryList *self, StoreCategory *catego
 {
     g_return_if_fail (STORE_IS_CATEGORY_LIST (self));
 
+    if (self->category == category)
+        return;
+
+    if (self->category != NULL)
+        g_signal_handlers_disconnect_by_data (self->category, self);
     g_set_object (&self->category, category);
 
     g_object_bind_property (category, "title", self->title_label, "label", G_BINDING_SYNC_CREATE);
+    g_signal_connect_object (category, "app-inserted", G_CALLBACK (app_inserted_cb), self, G_CONNECT_SWAPPED);
+    g_signal_connect_object (category, "app-moved", G_CALLBACK (app_moved_cb), self, G_CONNECT_SWAPPED);
+    g_signal_connect_object (category, "app-removed", G_CALLBACK (app_removed_cb), self, G_CONNECT_SWAPPED);
 
-    GPtrArray *apps = store_category_get_apps (category); // FIXME Update when apps updates
-
-    /* Ensure correct number of app tiles */
-    g_autoptr(GList) children = gtk_container_get_children (GTK_CONTAINER (self->app_box));
-    guint n_tiles = g_list_length (children);
-    guint n_apps = apps->len <  5 ? apps->len : 5;
-    while (n_tiles < n_apps) {
-        StoreAppSmallTile *tile = store_app_small_tile_new ();
-        gtk_widget_show (GTK_WIDGET (tile));
-        g_signal_connect_object (tile, "activated", G_CALLBACK (app_activated_cb), self, G_CONNECT_SWAPPED);
-        store_app_small_tile_set_model (tile, self->model);
-        gtk_container_add (GTK_CONTAINER (self->app_box), GTK_WIDGET (tile));
-        n_tiles++;
-        children = g_list_append (children, tile);
-    }
-    while (n_tiles > n_apps) {
-        for (GList *link = g_list_nth (children, n_apps); link != NULL; link = link->next) {
-            StoreAppSmallTile *tile = link->data;
-            gtk_container_remove (GTK_CONTAINER (self->app_box), GTK_WIDGET (tile));
-        }
-    }
-    for (guint i = 0; i < n_apps; i++) {
-        StoreApp *app = g_ptr_array_index (apps, i);
-        StoreAppSmallTile *tile = g_list_nth_data (children, i);
-        store_app_small_tile_set_app (tile, app);
-    }
+    update_tiles (self, 0);
 }
 
 StoreCategory *
@@ -9,6 +9,8 @@
 
 #include "store-category.h"
 
+#include "store-diff.h"
+
 struct _StoreCategory
 {
     GObject parent_instance;
@@ -31,6 +33,137 @@ enum
 
 G_DEFINE_TYPE (StoreCategory, store_category, G_TYPE_OBJECT)
 
+enum
+{
+    SIGNAL_APP_INSERTED,
+    SIGNAL_APP_MOVED,
+    SIGNAL_APP_REMOVED,
+    SIGNAL_LAST
+};
+
+static guint signals[SIGNAL_LAST] = { 0, };
+
+static gboolean
+apps_equal (GPtrArray *a, GPtrArray *b)
+{
+    if (a->len != b->len)
+        return FALSE;
+
+    for (guint i = 0; i < a->len; i++)
+        if (g_ptr_array_index (a, i) != g_ptr_array_index (b, i))
+            return FALSE;
+
+    return TRUE;
+}
+
+static GHashTable *
+index_apps (GPtrArray *apps)
+{
+    /* Indexes are stored offset by one so a missing app can be told apart from the first one */
+    GHashTable *indexes = g_hash_table_new (g_direct_hash, g_direct_equal);
+    for (guint i = 0; i < apps->len; i++)
+        g_hash_table_insert (indexes, g_ptr_array_index (apps, i), GUINT_TO_POINTER (i + 1));
+    return indexes;
+}
+
+static guint
+lookup_index (GHashTable *indexes, gpointer app)
+{
+    return GPOINTER_TO_UINT (g_hash_table_lookup (indexes, app)) - 1;
+}
+
+static void
+insert_app (StoreCategory *self, guint position, gpointer app)
+{
+    g_ptr_array_insert (self->apps, position, g_object_ref (app));
+    g_signal_emit (self, signals[SIGNAL_APP_INSERTED], 0, position);
+}
+
+static void
+move_app (StoreCategory *self, guint from, guint to)
+{
+    gpointer app = g_object_ref (g_ptr_array_index (self->apps, from));
+    g_ptr_array_remove_index (self->apps, from);
+    g_ptr_array_insert (self->apps, to, app);
+    g_signal_emit (self, signals[SIGNAL_APP_MOVED], 0, from, to);
+}
+
+static void
+remove_app (StoreCategory *self, guint position)
+{
+    g_ptr_array_remove_index (self->apps, position);
+    g_signal_emit (self, signals[SIGNAL_APP_REMOVED], 0, position);
+}
+
+static GHashTable *
+find_stationary_apps (StoreCategory *self, GHashTable *new_indexes)
+{
+    g_autofree guint *positions = g_new (guint, self->apps->len + 1);
+    for (guint i = 0; i < self->apps->len; i++)
+        positions[i] = lookup_index (new_indexes, g_ptr_array_index (self->apps, i));
+    g_autofree gboolean *is_stationary = store_diff_find_stationary (positions, self->apps->len);
+
+    GHashTable *stationary = g_hash_table_new (g_direct_hash, g_direct_equal);
+    for (guint i = 0; i < self->apps->len; i++) {
+        if (is_stationary[i])
+            g_hash_table_add (stationary, g_ptr_array_index (self->apps, i));
+    }
+
+    return stationary;
+}
+
+static void
+update_apps (StoreCategory *self, GPtrArray *apps)
+{
+    g_autoptr(GHashTable) old_indexes = index_apps (self->apps);
+    g_autoptr(GHashTable) new_indexes = index_apps (apps);
+
+    /* Can't diff lists with duplicate entries, so replace everything */
+    if (g_hash_table_size (old_indexes) != self->apps->len || g_hash_table_size (new_indexes) != apps->len) {
+        while (self->apps->len > 0)
+            remove_app (self, self->apps->len - 1);
+        for (guint i = 0; i < apps->len; i++)
+            insert_app (self, i, g_ptr_array_index (apps, i));
+        return;
+    }
+
+    /* Remove apps no longer in the category */
+    for (guint i = self->apps->len; i > 0; i--) {
+        if (!g_hash_table_contains (new_indexes, g_ptr_array_index (self->apps, i - 1)))
+            remove_app (self, i - 1);
+    }
+
+    /* Move each out of order app to directly after the app that precedes it in the new list */
+    g_autoptr(GHashTable) stationary = find_stationary_apps (self, new_indexes);
+    gpointer previous = NULL;
+    for (guint i = 0; i < apps->len; i++) {
+        gpointer app = g_ptr_array_index (apps, i);
+        if (!g_hash_table_contains (old_indexes, app))
+            continue;
+
+        if (!g_hash_table_contains (stationary, app)) {
+            guint from = 0, to = 0;
+            g_ptr_array_find (self->apps, app, &from);
+            if (previous != NULL) {
+                g_ptr_array_find (self->apps, previous, &to);
+                if (to < from)
+                    to++;
+            }
+            if (from != to)
+                move_app (self, from, to);
+        }
+
+        previous = app;
+    }
+
+    /* Add new apps, in order so each position is final */
+    for (guint i = 0; i < apps->len; i++) {
+        gpointer app = g_ptr_array_index (apps, i);
+        if (!g_hash_table_contains (old_indexes, app))
+            insert_app (self, i, app);
+    }
+}
+
 static void
 store_category_dispose (GObject *object)
 {
@@ -113,11 +246,39 @@ store_category_class_init (StoreCategoryClass *klass)
     g_object_class_install_property (G_OBJECT_CLASS (klass),
                                      PROP_TITLE,
                                      g_param_spec_string ("title", NULL, NULL, NULL, G_PARAM_READWRITE));
+
+    signals[SIGNAL_APP_INSERTED] = g_signal_new ("app-inserted",
+                                                 G_TYPE_FROM_CLASS (G_OBJECT_CLASS (klass)),
+                                                 G_SIGNAL_RUN_LAST,
+                                                 0,
+                                                 NULL, NULL,
+                                                 NULL,
+                                                 G_TYPE_NONE,
+                                                 1, G_TYPE_UINT);
+
+    signals[SIGNAL_APP_MOVED] = g_signal_new ("app-moved",
+                                              G_TYPE_FROM_CLASS (G_OBJECT_CLASS (klass)),
+                                              G_SIGNAL_RUN_LAST,
+                                              0,
+                                              NULL, NULL,
+                                              NULL,
+                                              G_TYPE_NONE,
+                                              2, G_TYPE_UINT, G_TYPE_UINT);
+
+    signals[SIGNAL_APP_REMOVED] = g_signal_new ("app-removed",
+                                                G_TYPE_FROM_CLASS (G_OBJECT_CLASS (klass)),
+                                                G_SIGNAL_RUN_LAST,
+                                                0,
+                                                NULL, NULL,
+                                                NULL,
+                                                G_TYPE_NONE,
+                                                1, G_TYPE_UINT);
 }
 
 static void
-store_category_init (StoreCategory *self G_GNUC_UNUSED)
+store_category_init (StoreCategory *self)
 {
+    self->apps = g_ptr_array_new_with_free_func (g_object_unref);
 }
 
 StoreCategory *
@@ -131,13 +292,12 @@ store_category_set_apps (StoreCategory *self, GPtrArray *apps)
 {
     g_return_if_fail (STORE_IS_CATEGORY (self));
 
-    if (self->apps == apps)
+    g_autoptr(GPtrArray) new_apps = apps != NULL ? g_ptr_array_ref (apps) : g_ptr_array_new ();
+    if (apps_equal (self->apps, new_apps))
         return;
-    // FIXME: Also check for arrays with same contents
 
-    g_clear_pointer (&self->apps, g_ptr_array_unref);
-    if (apps != NULL)
-        self->apps = g_ptr_array_ref (apps);
+    /* Apply the minimal set of changes so views only need to update the affected tiles */
+    update_apps (self, new_apps);
 
     g_object_notify (G_OBJECT (self), "apps");
 }
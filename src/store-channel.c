@@ -91,6 +91,24 @@ store_channel_to_json (StoreChannel *self)
     return json_builder_get_root (builder);
 }
 
+gboolean
+store_channel_equal (StoreChannel *self, StoreChannel *other)
+{
+    if (self == other)
+        return TRUE;
+    if (self == NULL || other == NULL)
+        return FALSE;
+
+    if (g_strcmp0 (self->name, other->name) != 0 ||
+        self->size != other->size ||
+        g_strcmp0 (self->version, other->version) != 0)
+        return FALSE;
+
+    if (self->release_date == NULL || other->release_date == NULL)
+        return self->release_date == other->release_date;
+    return g_date_time_equal (self->release_date, other->release_date);
+}
+
 void
 store_channel_set_name (StoreChannel *self, const gchar *name)
 {
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "store-diff.h"
+
+/* Given the new position of each entry in a list, marks the longest run of
+ * entries that are already in increasing order. These can stay where they are
+ * and everything else is moved around them. Free the result with g_free() */
+gboolean *
+store_diff_find_stationary (const guint *positions, guint n_positions)
+{
+    g_return_val_if_fail (positions != NULL || n_positions == 0, NULL);
+
+    g_autofree guint *tails = g_new (guint, n_positions + 1);
+    g_autofree guint *predecessors = g_new (guint, n_positions + 1);
+    guint length = 0;
+    for (guint i = 0; i < n_positions; i++) {
+        guint start = 0, end = length;
+        while (start < end) {
+            guint middle = (start + end) / 2;
+            if (positions[tails[middle]] < positions[i])
+                start = middle + 1;
+            else
+                end = middle;
+        }
+
+        predecessors[i] = start > 0 ? tails[start - 1] : G_MAXUINT;
+        tails[start] = i;
+        if (start == length)
+            length++;
+    }
+
+    gboolean *stationary = g_new0 (gboolean, n_positions + 1);
+    for (guint i = length > 0 ? tails[length - 1] : G_MAXUINT; i != G_MAXUINT; i = predecessors[i])
+        stationary[i] = TRUE;
+
+    return stationary;
+}
@@ -13,7 +13,9 @@
 
 #include "store-app-grid.h"
 #include "store-banner-tile.h"
+#include "store-cancellable.h"
 #include "store-category-list.h"
+#include "store-trace.h"
 
 struct _StoreHomePage
 {
@@ -35,6 +37,7 @@ struct _StoreHomePage
     StoreCategory *featured_category;
     GCancellable *search_cancellable;
     GSource *search_timeout;
+    GSource *snapshot_timeout;
 };
 
 enum
@@ -46,6 +49,12 @@ enum
 
 G_DEFINE_TYPE (StoreHomePage, store_home_page, store_page_get_type ())
 
+/* Time in milliseconds the home page needs to be unchanged before saving a snapshot */
+#define SNAPSHOT_DELAY 5000
+
+/* Number of featured apps shown as editor's picks */
+#define N_EDITORS_PICKS 6
+
 enum
 {
     SIGNAL_APP_ACTIVATED,
@@ -73,6 +82,108 @@ app_activated_cb (StoreHomePage *self, StoreApp *app)
     g_signal_emit (self, signals[SIGNAL_APP_ACTIVATED], 0, app);
 }
 
+static void
+snapshot_cb (GObject *object, GAsyncResult *result, gpointer user_data G_GNUC_UNUSED)
+{
+    g_autoptr(GError) error = NULL;
+    if (!store_model_save_snapshot_finish (STORE_MODEL (object), result, &error))
+        g_warning ("Failed to save home page snapshot: %s", error->message);
+}
+
+static gboolean
+snapshot_timeout_cb (gpointer user_data)
+{
+    StoreHomePage *self = user_data;
+
+    g_clear_pointer (&self->snapshot_timeout, g_source_unref);
+
+    g_autoptr(GPtrArray) categories = g_ptr_array_new ();
+    if (self->featured_category != NULL)
+        g_ptr_array_add (categories, self->featured_category);
+    StoreCategoryList *category_lists[] = { self->category_list1, self->category_list2, self->category_list3, self->category_list4 };
+    for (int i = 0; i < 4; i++)
+        if (gtk_widget_get_visible (GTK_WIDGET (category_lists[i])))
+            g_ptr_array_add (categories, store_category_list_get_category (category_lists[i]));
+
+    store_model_save_snapshot_async (store_page_get_model (STORE_PAGE (self)), categories, NULL, snapshot_cb, NULL);
+
+    return G_SOURCE_REMOVE;
+}
+
+/* Save once the home page has settled */
+static void
+schedule_snapshot (StoreHomePage *self)
+{
+    if (self->snapshot_timeout)
+        g_source_destroy (self->snapshot_timeout);
+    g_clear_pointer (&self->snapshot_timeout, g_source_unref);
+    self->snapshot_timeout = g_timeout_source_new (SNAPSHOT_DELAY);
+    g_source_set_callback (self->snapshot_timeout, snapshot_timeout_cb, self, NULL);
+    g_source_attach (self->snapshot_timeout, g_main_context_default ());
+}
+
+static void
+update_featured (StoreHomePage *self)
+{
+    g_autoptr(GPtrArray) featured_apps = g_ptr_array_new_with_free_func (g_object_unref);
+    GPtrArray *apps = store_category_get_apps (self->featured_category);
+    for (guint i = 0; i < apps->len && i < N_EDITORS_PICKS; i++) {
+        StoreSnapApp *app = g_ptr_array_index (apps, i);
+        g_ptr_array_add (featured_apps, g_object_ref (app));
+    }
+    store_app_grid_set_apps (self->editors_picks_grid, featured_apps);
+    schedule_snapshot (self);
+}
+
+static void
+featured_app_inserted_cb (StoreHomePage *self, guint position)
+{
+    if (position >= N_EDITORS_PICKS)
+        return;
+
+    /* Pushes the last pick out */
+    GPtrArray *apps = store_category_get_apps (self->featured_category);
+    store_app_grid_insert_app (self->editors_picks_grid, position, g_ptr_array_index (apps, position));
+    if (apps->len > N_EDITORS_PICKS)
+        store_app_grid_remove_app (self->editors_picks_grid, N_EDITORS_PICKS);
+    schedule_snapshot (self);
+}
+
+static void
+featured_app_moved_cb (StoreHomePage *self, guint from, guint to)
+{
+    GPtrArray *apps = store_category_get_apps (self->featured_category);
+    if (from < N_EDITORS_PICKS && to < N_EDITORS_PICKS)
+        store_app_grid_move_app (self->editors_picks_grid, from, to);
+    else if (from < N_EDITORS_PICKS) {
+        /* Moved out of the picks, so the next app moves up into them */
+        store_app_grid_remove_app (self->editors_picks_grid, from);
+        store_app_grid_insert_app (self->editors_picks_grid, N_EDITORS_PICKS - 1, g_ptr_array_index (apps, N_EDITORS_PICKS - 1));
+    }
+    else if (to < N_EDITORS_PICKS) {
+        /* Moved into the picks, pushing the last one out */
+        store_app_grid_insert_app (self->editors_picks_grid, to, g_ptr_array_index (apps, to));
+        store_app_grid_remove_app (self->editors_picks_grid, N_EDITORS_PICKS);
+    }
+    else
+        return;
+    schedule_snapshot (self);
+}
+
+static void
+featured_app_removed_cb (StoreHomePage *self, guint position)
+{
+    if (position >= N_EDITORS_PICKS)
+        return;
+
+    /* The next app moves up into the picks */
+    GPtrArray *apps = store_category_get_apps (self->featured_category);
+    store_app_grid_remove_app (self->editors_picks_grid, position);
+    if (apps->len >= N_EDITORS_PICKS)
+        store_app_grid_insert_app (self->editors_picks_grid, N_EDITORS_PICKS - 1, g_ptr_array_index (apps, N_EDITORS_PICKS - 1));
+    schedule_snapshot (self);
+}
+
 static void
 search_results_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 {
@@ -88,6 +199,7 @@ search_results_cb (GObject *object, GAsyncResult *result, gpointer user_data)
     }
 
     store_app_grid_set_apps (self->search_results_grid, apps);
+    store_trace_mark ("search-results");
 
     gtk_widget_hide (GTK_WIDGET (self->category_box));
     gtk_widget_hide (GTK_WIDGET (self->editors_picks_grid));
@@ -110,7 +222,7 @@ search_cb (StoreHomePage *self)
 
     g_cancellable_cancel (self->search_cancellable);
     g_clear_object (&self->search_cancellable);
-    self->search_cancellable = g_cancellable_new ();
+    self->search_cancellable = store_cancellable_new_child (store_page_get_cancellable (STORE_PAGE (self)));
     store_model_search_async (store_page_get_model (STORE_PAGE (self)), query, self->search_cancellable, search_results_cb, self);
 }
 
@@ -152,6 +264,9 @@ store_home_page_dispose (GObject *object)
     if (self->search_timeout)
         g_source_destroy (self->search_timeout);
     g_clear_pointer (&self->search_timeout, g_source_unref);
+    if (self->snapshot_timeout)
+        g_source_destroy (self->snapshot_timeout);
+    g_clear_pointer (&self->snapshot_timeout, g_source_unref);
 
     G_OBJECT_CLASS (store_home_page_parent_class)->dispose (object);
 }
@@ -266,26 +381,41 @@ store_home_page_set_categories (StoreHomePage *self, GPtrArray *categories)
 {
     g_return_if_fail (STORE_IS_HOME_PAGE (self));
 
+    if (categories->len > 0)
+        store_trace_mark ("home-page-categories");
+
     StoreCategoryList *category_lists[] = { self->category_list1, self->category_list2, self->category_list3, self->category_list4 };
 
+    /* Changes to the visible categories update the snapshot */
+    for (int i = 0; i < 4; i++) {
+        StoreCategory *old_category = store_category_list_get_category (category_lists[i]);
+        if (old_category != NULL)
+            g_signal_handlers_disconnect_by_func (old_category, G_CALLBACK (schedule_snapshot), self);
+    }
+
     guint n = 0;
-    g_clear_object (&self->featured_category);
+    gboolean have_featured = FALSE;
     for (guint i = 0; i < categories->len; i++) {
         StoreCategory *category = g_ptr_array_index (categories, i);
 
         if (g_strcmp0 (store_category_get_name (category), "featured") == 0) {
-            g_set_object (&self->featured_category, category);
-            g_autoptr(GPtrArray) featured_apps = g_ptr_array_new_with_free_func (g_object_unref);
-            GPtrArray *apps = store_category_get_apps (category);
-            for (guint i = 0; i < apps->len && i < 6; i++) {
-                StoreSnapApp *app = g_ptr_array_index (apps, i);
-                g_ptr_array_add (featured_apps, g_object_ref (app));
+            have_featured = TRUE;
+            if (self->featured_category != category) {
+                if (self->featured_category != NULL)
+                    g_signal_handlers_disconnect_by_data (self->featured_category, self);
+                g_set_object (&self->featured_category, category);
+                g_signal_connect_object (category, "app-inserted", G_CALLBACK (featured_app_inserted_cb), self, G_CONNECT_SWAPPED);
+                g_signal_connect_object (category, "app-moved", G_CALLBACK (featured_app_moved_cb), self, G_CONNECT_SWAPPED);
+                g_signal_connect_object (category, "app-removed", G_CALLBACK (featured_app_removed_cb), self, G_CONNECT_SWAPPED);
+                update_featured (self);
             }
-            store_app_grid_set_apps (self->editors_picks_grid, featured_apps);
             continue;
         }
 
         if (n < 4) {
+            g_signal_connect_object (category, "app-inserted", G_CALLBACK (schedule_snapshot), self, G_CONNECT_SWAPPED);
+            g_signal_connect_object (category, "app-moved", G_CALLBACK (schedule_snapshot), self, G_CONNECT_SWAPPED);
+            g_signal_connect_object (category, "app-removed", G_CALLBACK (schedule_snapshot), self, G_CONNECT_SWAPPED);
             gtk_widget_show (GTK_WIDGET (category_lists[n]));
             store_category_list_set_category (category_lists[n], category);
             n++;
@@ -293,13 +423,33 @@ store_home_page_set_categories (StoreHomePage *self, GPtrArray *categories)
     }
     for (; n < 4; n++)
         gtk_widget_hide (GTK_WIDGET (category_lists[n]));
+
+    if (!have_featured && self->featured_category != NULL) {
+        g_signal_handlers_disconnect_by_data (self->featured_category, self);
+        g_clear_object (&self->featured_category);
+    }
+
+    if (categories->len > 0)
+        schedule_snapshot (self);
 }
 
 void
-store_home_page_load (StoreHomePage *self)
+store_home_page_search (StoreHomePage *self, const gchar *query)
 {
-    store_model_update_categories_async (store_page_get_model (STORE_PAGE (self)), NULL, NULL, NULL);
+    g_return_if_fail (STORE_IS_HOME_PAGE (self));
+
+    gtk_entry_set_text (self->search_entry, query);
+
+    /* Search now rather than waiting for the typing delay */
+    if (self->search_timeout)
+        g_source_destroy (self->search_timeout);
+    g_clear_pointer (&self->search_timeout, g_source_unref);
+    search_cb (self);
+}
 
+void
+store_home_page_load (StoreHomePage *self)
+{
     // FIXME: Hardcoded
     g_autoptr(StoreSnapApp) app = store_model_get_snap (store_page_get_model (STORE_PAGE (self)), "telemetrytv");
     store_banner_tile_set_app (self->banner_tile, STORE_APP (app));
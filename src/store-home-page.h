@@ -17,6 +17,8 @@ G_DECLARE_FINAL_TYPE (StoreHomePage, store_home_page, STORE, HOME_PAGE, StorePag
 
 void store_home_page_load           (StoreHomePage *page);
 
+void store_home_page_search         (StoreHomePage *self, const gchar *query);
+
 void store_home_page_set_categories (StoreHomePage *self, GPtrArray *categories);
 
 G_END_DECLS
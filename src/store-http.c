@@ -0,0 +1,312 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "store-http.h"
+
+struct _StoreHttp
+{
+    GObject parent_instance;
+
+    GHashTable *host_stats;
+    StoreRecorder *recorder;
+    SoupSession *session;
+};
+
+G_DEFINE_TYPE (StoreHttp, store_http, G_TYPE_OBJECT)
+
+typedef struct
+{
+    guint n_requests;
+    guint n_errors;
+    gint64 total_latency;
+    gint64 max_latency;
+} HostStats;
+
+typedef struct
+{
+    SoupMessage *message;
+    gint64 start_time;
+} SendData;
+
+static SendData *
+send_data_new (SoupMessage *message)
+{
+    SendData *data = g_new0 (SendData, 1);
+    data->message = g_object_ref (message);
+    data->start_time = g_get_monotonic_time ();
+    return data;
+}
+
+static void
+send_data_free (SendData *data)
+{
+    g_clear_object (&data->message);
+    g_free (data);
+}
+
+static void
+record_request (StoreHttp *self, SendData *data, gboolean failed)
+{
+    const gchar *host = soup_uri_get_host (soup_message_get_uri (data->message));
+    if (host == NULL)
+        return;
+
+    HostStats *stats = g_hash_table_lookup (self->host_stats, host);
+    if (stats == NULL) {
+        stats = g_new0 (HostStats, 1);
+        g_hash_table_insert (self->host_stats, g_strdup (host), stats);
+    }
+
+    gint64 latency = g_get_monotonic_time () - data->start_time;
+    stats->n_requests++;
+    if (failed)
+        stats->n_errors++;
+    stats->total_latency += latency;
+    stats->max_latency = MAX (stats->max_latency, latency);
+
+    g_debug ("%s %s: %u in %" G_GINT64_FORMAT "ms", data->message->method, host, data->message->status_code, latency / 1000);
+}
+
+static void
+record_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    StoreHttp *self = g_task_get_source_object (task);
+    SendData *data = g_task_get_task_data (task);
+
+    g_autoptr(GError) error = NULL;
+    if (g_output_stream_splice_finish (G_OUTPUT_STREAM (object), result, &error) < 0) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+    g_autoptr(GBytes) body = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (object));
+
+    SoupURI *uri = soup_message_get_uri (data->message);
+    g_autoptr(GBytes) request_body = NULL;
+    if (data->message->request_body->length > 0) {
+        SoupBuffer *buffer = soup_message_body_flatten (data->message->request_body);
+        request_body = soup_buffer_get_as_bytes (buffer);
+        soup_buffer_free (buffer);
+    }
+    store_recorder_add (self->recorder, "http", data->message->method,
+                        soup_uri_get_host (uri), soup_uri_get_path (uri), soup_uri_get_query (uri), request_body,
+                        data->message->status_code, data->message->response_headers, body,
+                        data->start_time, g_get_monotonic_time ());
+
+    g_task_return_pointer (task, g_memory_input_stream_new_from_bytes (body), g_object_unref);
+}
+
+static void
+send_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    StoreHttp *self = g_task_get_source_object (task);
+    SendData *data = g_task_get_task_data (task);
+
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GInputStream) stream = soup_session_send_finish (SOUP_SESSION (object), result, &error);
+    record_request (self, data, stream == NULL || SOUP_STATUS_IS_SERVER_ERROR (data->message->status_code));
+    if (stream == NULL) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+
+    /* Read the whole body so it can be recorded */
+    if (self->recorder != NULL) {
+        g_autoptr(GOutputStream) body_stream = g_memory_output_stream_new_resizable ();
+        GCancellable *cancellable = g_task_get_cancellable (task);
+        g_output_stream_splice_async (body_stream, stream,
+                                      G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE | G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+                                      G_PRIORITY_DEFAULT, cancellable, record_cb, g_steal_pointer (&task));
+        return;
+    }
+
+    g_task_return_pointer (task, g_steal_pointer (&stream), g_object_unref);
+}
+
+static void
+store_http_dispose (GObject *object)
+{
+    StoreHttp *self = STORE_HTTP (object);
+
+    if (self->host_stats != NULL) {
+        GHashTableIter iter;
+        g_hash_table_iter_init (&iter, self->host_stats);
+        gpointer key, value;
+        while (g_hash_table_iter_next (&iter, &key, &value)) {
+            HostStats *stats = value;
+            g_debug ("%s: %u requests, %u errors, %" G_GINT64_FORMAT "ms average, %" G_GINT64_FORMAT "ms max",
+                     (const gchar *) key, stats->n_requests, stats->n_errors,
+                     stats->total_latency / stats->n_requests / 1000, stats->max_latency / 1000);
+        }
+    }
+
+    g_clear_pointer (&self->host_stats, g_hash_table_unref);
+    g_clear_object (&self->recorder);
+    g_clear_object (&self->session);
+
+    G_OBJECT_CLASS (store_http_parent_class)->dispose (object);
+}
+
+static void
+store_http_class_init (StoreHttpClass *klass)
+{
+    G_OBJECT_CLASS (klass)->dispose = store_http_dispose;
+}
+
+static void
+store_http_init (StoreHttp *self)
+{
+    self->host_stats = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+    /* Per-host limits and timeouts are set by the owner with the setters below */
+    self->session = soup_session_new_with_options (SOUP_SESSION_MAX_CONNS, 16,
+                                                   NULL);
+}
+
+StoreHttp *
+store_http_new (void)
+{
+    return g_object_new (store_http_get_type (), NULL);
+}
+
+void
+store_http_set_idle_timeout (StoreHttp *self, guint timeout)
+{
+    g_return_if_fail (STORE_IS_HTTP (self));
+    g_object_set (self->session, SOUP_SESSION_IDLE_TIMEOUT, timeout, NULL);
+}
+
+guint
+store_http_get_idle_timeout (StoreHttp *self)
+{
+    g_return_val_if_fail (STORE_IS_HTTP (self), 0);
+
+    guint timeout;
+    g_object_get (self->session, SOUP_SESSION_IDLE_TIMEOUT, &timeout, NULL);
+    return timeout;
+}
+
+void
+store_http_set_max_connections_per_host (StoreHttp *self, guint max_connections)
+{
+    g_return_if_fail (STORE_IS_HTTP (self));
+    g_object_set (self->session, SOUP_SESSION_MAX_CONNS_PER_HOST, (gint) max_connections, NULL);
+}
+
+guint
+store_http_get_max_connections_per_host (StoreHttp *self)
+{
+    g_return_val_if_fail (STORE_IS_HTTP (self), 0);
+
+    gint max_connections;
+    g_object_get (self->session, SOUP_SESSION_MAX_CONNS_PER_HOST, &max_connections, NULL);
+    return max_connections;
+}
+
+void
+store_http_set_timeout (StoreHttp *self, guint timeout)
+{
+    g_return_if_fail (STORE_IS_HTTP (self));
+    g_object_set (self->session, SOUP_SESSION_TIMEOUT, timeout, NULL);
+}
+
+guint
+store_http_get_timeout (StoreHttp *self)
+{
+    g_return_val_if_fail (STORE_IS_HTTP (self), 0);
+
+    guint timeout;
+    g_object_get (self->session, SOUP_SESSION_TIMEOUT, &timeout, NULL);
+    return timeout;
+}
+
+/* Responses are read in full before being returned while recording */
+void
+store_http_set_recorder (StoreHttp *self, StoreRecorder *recorder)
+{
+    g_return_if_fail (STORE_IS_HTTP (self));
+    g_set_object (&self->recorder, recorder);
+}
+
+void
+store_http_send_async (StoreHttp *self, SoupMessage *message,
+                       GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data)
+{
+    g_return_if_fail (STORE_IS_HTTP (self));
+    g_return_if_fail (SOUP_IS_MESSAGE (message));
+
+    GTask *task = g_task_new (self, cancellable, callback, callback_data);
+    g_task_set_task_data (task, send_data_new (message), (GDestroyNotify) send_data_free);
+    soup_session_send_async (self->session, message, cancellable, send_cb, task);
+}
+
+GInputStream *
+store_http_send_finish (StoreHttp *self, GAsyncResult *result, GError **error)
+{
+    g_return_val_if_fail (STORE_IS_HTTP (self), NULL);
+    g_return_val_if_fail (g_task_is_valid (G_TASK (result), self), NULL);
+
+    return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+GStrv
+store_http_get_hosts (StoreHttp *self)
+{
+    g_return_val_if_fail (STORE_IS_HTTP (self), NULL);
+
+    GStrv hosts = g_new0 (gchar *, g_hash_table_size (self->host_stats) + 1);
+    GHashTableIter iter;
+    g_hash_table_iter_init (&iter, self->host_stats);
+    gpointer key;
+    for (guint i = 0; g_hash_table_iter_next (&iter, &key, NULL); i++)
+        hosts[i] = g_strdup (key);
+
+    return hosts;
+}
+
+guint
+store_http_get_request_count (StoreHttp *self, const gchar *host)
+{
+    g_return_val_if_fail (STORE_IS_HTTP (self), 0);
+
+    HostStats *stats = g_hash_table_lookup (self->host_stats, host);
+    return stats != NULL ? stats->n_requests : 0;
+}
+
+guint
+store_http_get_error_count (StoreHttp *self, const gchar *host)
+{
+    g_return_val_if_fail (STORE_IS_HTTP (self), 0);
+
+    HostStats *stats = g_hash_table_lookup (self->host_stats, host);
+    return stats != NULL ? stats->n_errors : 0;
+}
+
+gint64
+store_http_get_average_latency (StoreHttp *self, const gchar *host)
+{
+    g_return_val_if_fail (STORE_IS_HTTP (self), 0);
+
+    HostStats *stats = g_hash_table_lookup (self->host_stats, host);
+    if (stats == NULL || stats->n_requests == 0)
+        return 0;
+    return stats->total_latency / stats->n_requests;
+}
+
+gint64
+store_http_get_max_latency (StoreHttp *self, const gchar *host)
+{
+    g_return_val_if_fail (STORE_IS_HTTP (self), 0);
+
+    HostStats *stats = g_hash_table_lookup (self->host_stats, host);
+    return stats != NULL ? stats->max_latency : 0;
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#pragma once
+
+#include <libsoup/soup.h>
+
+#include "store-recorder.h"
+
+G_BEGIN_DECLS
+
+G_DECLARE_FINAL_TYPE (StoreHttp, store_http, STORE, HTTP, GObject)
+
+StoreHttp    *store_http_new                          (void);
+
+void          store_http_set_idle_timeout             (StoreHttp *http, guint timeout);
+
+guint         store_http_get_idle_timeout             (StoreHttp *http);
+
+void          store_http_set_max_connections_per_host (StoreHttp *http, guint max_connections);
+
+guint         store_http_get_max_connections_per_host (StoreHttp *http);
+
+void          store_http_set_timeout                  (StoreHttp *http, guint timeout);
+
+guint         store_http_get_timeout                  (StoreHttp *http);
+
+void          store_http_set_recorder                 (StoreHttp *http, StoreRecorder *recorder);
+
+void          store_http_send_async                   (StoreHttp *http, SoupMessage *message,
+                                                       GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data);
+
+GInputStream *store_http_send_finish                  (StoreHttp *http, GAsyncResult *result, GError **error);
+
+GStrv         store_http_get_hosts                    (StoreHttp *http);
+
+guint         store_http_get_request_count            (StoreHttp *http, const gchar *host);
+
+guint         store_http_get_error_count              (StoreHttp *http, const gchar *host);
+
+gint64        store_http_get_average_latency          (StoreHttp *http, const gchar *host);
+
+gint64        store_http_get_max_latency              (StoreHttp *http, const gchar *host);
+
+G_END_DECLS
@@ -9,17 +9,29 @@
 
 #include "store-image.h"
 
+#include "store-cancellable.h"
 #include "store-model.h"
+#include "store-page.h"
+#include "store-trace.h"
 
 struct _StoreImage
 {
     GtkDrawingArea parent_instance;
 
+    GPtrArray *adjustments;
     GCancellable *cache_cancellable;
     GCancellable *cancellable;
+    gboolean have_image;
     guint height;
+    gint load_margin;
+    gboolean load_pending;
     StoreModel *model;
+    gboolean painted;
     GdkPixbuf *pixbuf;
+    cairo_surface_t *surface;
+    gint surface_height;
+    gint surface_scale;
+    gint surface_width;
     guint width;
     gchar *uri;
 };
@@ -28,6 +40,7 @@ enum
 {
     PROP_0,
     PROP_HEIGHT,
+    PROP_LOAD_MARGIN,
     PROP_MEDIA,
     PROP_WIDTH,
     PROP_URI,
@@ -36,10 +49,15 @@ enum
 
 G_DEFINE_TYPE (StoreImage, store_image, GTK_TYPE_DRAWING_AREA)
 
+/* Default distance in pixels outside the visible area to start loading images */
+#define DEFAULT_LOAD_MARGIN 256
+
 static void
 set_pixbuf (StoreImage *self, GdkPixbuf *pixbuf)
 {
     g_set_object (&self->pixbuf, pixbuf);
+    g_clear_pointer (&self->surface, cairo_surface_destroy);
+    self->painted = FALSE;
     gtk_widget_queue_resize (GTK_WIDGET (self));
     gtk_widget_queue_draw (GTK_WIDGET (self));
 }
@@ -55,13 +73,16 @@ image_cb (GObject *object, GAsyncResult *result, gpointer user_data)
         if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
             return;
         g_warning ("Failed to load image: %s", error->message);
+        g_clear_object (&self->cancellable);
         return;
     }
 
     /* Cancel cached image if we got there first */
     g_cancellable_cancel (self->cache_cancellable);
     g_clear_object (&self->cache_cancellable);
+    g_clear_object (&self->cancellable);
 
+    self->have_image = TRUE;
     set_pixbuf (self, pixbuf);
 }
 
@@ -77,23 +98,106 @@ cache_cb (GObject *object, GAsyncResult *result, gpointer user_data)
             return;
         if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
             g_warning ("Failed to load cached image: %s", error->message);
+        g_clear_object (&self->cache_cancellable);
         return;
     }
+    g_clear_object (&self->cache_cancellable);
 
+    self->have_image = TRUE;
     set_pixbuf (self, pixbuf);
 }
 
+static void
+cancel_load (StoreImage *self)
+{
+    g_cancellable_cancel (self->cancellable);
+    g_clear_object (&self->cancellable);
+    g_cancellable_cancel (self->cache_cancellable);
+    g_clear_object (&self->cache_cancellable);
+}
+
+static void
+start_load (StoreImage *self)
+{
+    self->load_pending = FALSE;
+
+    /* Only fetch again if changed */
+    const gchar *etag = NULL;
+    store_model_get_cached_image_metadata (self->model, self->uri, &etag, NULL, NULL);
+
+    /* Stop loading if the page we're on is left */
+    GtkWidget *page = gtk_widget_get_ancestor (GTK_WIDGET (self), store_page_get_type ());
+    GCancellable *page_cancellable = page != NULL ? store_page_get_cancellable (STORE_PAGE (page)) : NULL;
+
+    self->cancellable = store_cancellable_new_child (page_cancellable);
+    store_model_get_image_async (self->model, self->uri, etag, self->width, self->height, self->cancellable, image_cb, self);
+
+    /* Load cached version */
+    self->cache_cancellable = store_cancellable_new_child (page_cancellable);
+    store_model_get_cached_image_async (self->model, self->uri, self->width, self->height, self->cache_cancellable, cache_cb, self);
+}
+
+static GtkWidget *
+get_scrolled_window (GtkWidget *widget)
+{
+    GtkWidget *parent = gtk_widget_get_parent (widget);
+    return parent != NULL ? gtk_widget_get_ancestor (parent, GTK_TYPE_SCROLLED_WINDOW) : NULL;
+}
+
+/* Visible (or within the margin of being visible) in every scrolled window we are inside */
+static gboolean
+is_in_view (StoreImage *self)
+{
+    GtkWidget *widget = GTK_WIDGET (self);
+
+    if (!gtk_widget_get_mapped (widget))
+        return FALSE;
+
+    for (GtkWidget *scrolled_window = get_scrolled_window (widget); scrolled_window != NULL; scrolled_window = get_scrolled_window (scrolled_window)) {
+        gint x, y;
+        if (!gtk_widget_translate_coordinates (widget, scrolled_window, 0, 0, &x, &y))
+            return FALSE;
+        GdkRectangle area = { x - self->load_margin, y - self->load_margin,
+                              gtk_widget_get_allocated_width (widget) + 2 * self->load_margin,
+                              gtk_widget_get_allocated_height (widget) + 2 * self->load_margin };
+        GdkRectangle view = { 0, 0, gtk_widget_get_allocated_width (scrolled_window), gtk_widget_get_allocated_height (scrolled_window) };
+        if (!gdk_rectangle_intersect (&area, &view, NULL))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void
+update_load (StoreImage *self)
+{
+    if (self->load_pending && self->uri != NULL && is_in_view (self))
+        start_load (self);
+}
+
+static void
+disconnect_adjustments (StoreImage *self)
+{
+    for (guint i = 0; i < self->adjustments->len; i++)
+        g_signal_handlers_disconnect_by_func (g_ptr_array_index (self->adjustments, i), update_load, self);
+    g_ptr_array_set_size (self->adjustments, 0);
+}
+
 static void
 store_image_dispose (GObject *object)
 {
     StoreImage *self = STORE_IMAGE (object);
 
+    if (self->adjustments != NULL)
+        disconnect_adjustments (self);
+    g_clear_pointer (&self->adjustments, g_ptr_array_unref);
     g_cancellable_cancel (self->cache_cancellable);
     g_clear_object (&self->cache_cancellable);
     g_cancellable_cancel (self->cancellable);
     g_clear_object (&self->cancellable);
     g_clear_object (&self->model);
     g_clear_object (&self->pixbuf);
+    g_clear_pointer (&self->surface, cairo_surface_destroy);
     g_clear_pointer (&self->uri, g_free);
 
     G_OBJECT_CLASS (store_image_parent_class)->dispose (object);
@@ -109,6 +213,9 @@ store_image_get_property (GObject *object, guint prop_id, GValue *value, GParamS
     case PROP_HEIGHT:
         g_value_set_int (value, self->height);
         break;
+    case PROP_LOAD_MARGIN:
+        g_value_set_int (value, self->load_margin);
+        break;
     case PROP_WIDTH:
         g_value_set_int (value, self->width);
         break;
@@ -131,6 +238,10 @@ store_image_set_property (GObject *object, guint prop_id, const GValue *value, G
     case PROP_HEIGHT:
         self->height = g_value_get_int (value);
         break;
+    case PROP_LOAD_MARGIN:
+        self->load_margin = g_value_get_int (value);
+        update_load (self);
+        break;
     case PROP_MEDIA:
         store_image_set_media (self, g_value_get_object (value));
         break;
@@ -168,6 +279,85 @@ store_image_get_preferred_width (GtkWidget *widget, gint *minimum_width, gint *n
     *minimum_width = *natural_width = width;
 }
 
+static void
+store_image_map (GtkWidget *widget)
+{
+    StoreImage *self = STORE_IMAGE (widget);
+
+    GTK_WIDGET_CLASS (store_image_parent_class)->map (widget);
+
+    /* Try again if the page we're on was left while we were loading */
+    if (g_cancellable_is_cancelled (self->cancellable)) {
+        cancel_load (self);
+        self->load_pending = TRUE;
+    }
+
+    /* Check again when scrolled */
+    disconnect_adjustments (self);
+    for (GtkWidget *scrolled_window = get_scrolled_window (widget); scrolled_window != NULL; scrolled_window = get_scrolled_window (scrolled_window)) {
+        GtkAdjustment *adjustments[] = { gtk_scrolled_window_get_hadjustment (GTK_SCROLLED_WINDOW (scrolled_window)),
+                                         gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (scrolled_window)) };
+        for (gsize i = 0; i < G_N_ELEMENTS (adjustments); i++) {
+            g_signal_connect_swapped (adjustments[i], "value-changed", G_CALLBACK (update_load), self);
+            g_ptr_array_add (self->adjustments, g_object_ref (adjustments[i]));
+        }
+    }
+
+    update_load (self);
+}
+
+static void
+store_image_unmap (GtkWidget *widget)
+{
+    StoreImage *self = STORE_IMAGE (widget);
+
+    disconnect_adjustments (self);
+
+    /* Don't use bandwidth on images that can't be seen, load them again if shown */
+    if (self->cancellable != NULL || self->cache_cancellable != NULL) {
+        cancel_load (self);
+        self->load_pending = TRUE;
+    }
+
+    GTK_WIDGET_CLASS (store_image_parent_class)->unmap (widget);
+}
+
+static void
+store_image_size_allocate (GtkWidget *widget, GtkAllocation *allocation)
+{
+    StoreImage *self = STORE_IMAGE (widget);
+
+    GTK_WIDGET_CLASS (store_image_parent_class)->size_allocate (widget, allocation);
+
+    update_load (self);
+}
+
+/* Scaling and uploading the image is only done when the size or scale changes, not on every draw */
+static cairo_surface_t *
+get_surface (StoreImage *self)
+{
+    GtkWidget *widget = GTK_WIDGET (self);
+    gint width = gtk_widget_get_allocated_width (widget);
+    gint height = gtk_widget_get_allocated_height (widget);
+    gint scale = gtk_widget_get_scale_factor (widget);
+    if (self->surface != NULL && self->surface_width == width && self->surface_height == height && self->surface_scale == scale)
+        return self->surface;
+
+    g_clear_pointer (&self->surface, cairo_surface_destroy);
+    if (width <= 0 || height <= 0)
+        return NULL;
+
+    g_autoptr(GdkPixbuf) pixbuf = gdk_pixbuf_scale_simple (self->pixbuf, width * scale, height * scale, GDK_INTERP_BILINEAR);
+    if (pixbuf == NULL)
+        return NULL;
+    self->surface = gdk_cairo_surface_create_from_pixbuf (pixbuf, scale, gtk_widget_get_window (widget));
+    self->surface_width = width;
+    self->surface_height = height;
+    self->surface_scale = scale;
+
+    return self->surface;
+}
+
 static gboolean
 store_image_draw (GtkWidget *widget, cairo_t *cr)
 {
@@ -176,14 +366,32 @@ store_image_draw (GtkWidget *widget, cairo_t *cr)
     if (self->pixbuf == NULL)
         return FALSE;
 
-    int width = gtk_widget_get_allocated_width (widget);
-    int height = gtk_widget_get_allocated_height (widget);
-    g_autoptr(GdkPixbuf) pixbuf = gdk_pixbuf_scale_simple (self->pixbuf, width, height, GDK_INTERP_BILINEAR); // FIXME: Super inefficient
-    gtk_render_icon (gtk_widget_get_style_context (widget), cr, pixbuf, 0, 0); // FIXME: Store surface instead of sending pixbuf each time to GPU
+    cairo_surface_t *surface = get_surface (self);
+    if (surface == NULL)
+        return FALSE;
+    cairo_set_source_surface (cr, surface, 0, 0);
+    cairo_paint (cr);
+
+    /* Only the first paint of each image is of interest, not every redraw */
+    if (self->have_image && !self->painted) {
+        self->painted = TRUE;
+        store_trace_mark ("image-painted");
+    }
 
     return TRUE;
 }
 
+static void
+store_image_unrealize (GtkWidget *widget)
+{
+    StoreImage *self = STORE_IMAGE (widget);
+
+    /* The surface may belong to the window being removed */
+    g_clear_pointer (&self->surface, cairo_surface_destroy);
+
+    GTK_WIDGET_CLASS (store_image_parent_class)->unrealize (widget);
+}
+
 static void
 store_image_class_init (StoreImageClass *klass)
 {
@@ -193,11 +401,18 @@ store_image_class_init (StoreImageClass *klass)
 
     GTK_WIDGET_CLASS (klass)->get_preferred_height = store_image_get_preferred_height;
     GTK_WIDGET_CLASS (klass)->get_preferred_width = store_image_get_preferred_width;
+    GTK_WIDGET_CLASS (klass)->map = store_image_map;
+    GTK_WIDGET_CLASS (klass)->unmap = store_image_unmap;
+    GTK_WIDGET_CLASS (klass)->size_allocate = store_image_size_allocate;
     GTK_WIDGET_CLASS (klass)->draw = store_image_draw;
+    GTK_WIDGET_CLASS (klass)->unrealize = store_image_unrealize;
 
     g_object_class_install_property (G_OBJECT_CLASS (klass),
                                      PROP_HEIGHT,
                                      g_param_spec_int ("height", NULL, NULL, G_MININT, G_MAXINT, 0, G_PARAM_READWRITE));
+    g_object_class_install_property (G_OBJECT_CLASS (klass),
+                                     PROP_LOAD_MARGIN,
+                                     g_param_spec_int ("load-margin", NULL, NULL, 0, G_MAXINT, DEFAULT_LOAD_MARGIN, G_PARAM_READWRITE));
     g_object_class_install_property (G_OBJECT_CLASS (klass),
                                      PROP_MEDIA,
                                      g_param_spec_object ("media", NULL, NULL, store_media_get_type (), G_PARAM_WRITABLE));
@@ -210,8 +425,10 @@ store_image_class_init (StoreImageClass *klass)
 }
 
 static void
-store_image_init (StoreImage *self G_GNUC_UNUSED)
+store_image_init (StoreImage *self)
 {
+    self->adjustments = g_ptr_array_new_with_free_func (g_object_unref);
+    self->load_margin = DEFAULT_LOAD_MARGIN;
 }
 
 StoreImage *
@@ -251,33 +468,18 @@ store_image_set_uri (StoreImage *self, const gchar *uri)
 {
     g_return_if_fail (STORE_IS_IMAGE (self));
 
-    if (self->pixbuf != NULL && g_strcmp0 (uri, self->uri) == 0)
+    if (self->pixbuf != NULL && g_strcmp0 (uri, self->uri) == 0 && !g_cancellable_is_cancelled (self->cancellable))
         return;
-    g_free (self->uri);
+    g_autofree gchar *old_uri = g_steal_pointer (&self->uri);
     self->uri = g_strdup (uri);
 
-    /* Cancel existing operation */
-    g_cancellable_cancel (self->cancellable);
-    g_clear_object (&self->cancellable);
-    g_cancellable_cancel (self->cache_cancellable);
-    g_clear_object (&self->cache_cancellable);
+    cancel_load (self);
 
     g_autoptr(GdkPixbuf) pixbuf = gdk_pixbuf_new_from_resource_at_scale ("/io/snapcraft/Store/default-snap-icon.svg", self->width, self->height, TRUE, NULL); // FIXME: Make a property
+    self->have_image = FALSE;
     set_pixbuf (self, pixbuf);
 
-    if (uri == NULL)
-        return;
-
-    /* Load cache information */
-    g_autofree gchar *etag = NULL;
-    g_autoptr(GError) error = NULL;
-    if (!store_model_get_cached_image_metadata_sync (self->model, uri, &etag, NULL, NULL, self->cancellable, &error))
-        g_warning ("Failed to cached image metadata: %s", error->message);
-
-    self->cancellable = g_cancellable_new ();
-    store_model_get_image_async (self->model, uri, etag, self->width, self->height, self->cancellable, image_cb, self);
-
-    /* Load cached version */
-    self->cache_cancellable = g_cancellable_new ();
-    store_model_get_cached_image_async (self->model, uri, self->width, self->height, self->cache_cancellable, cache_cb, self);
+    /* Wait until we are scrolled into view before loading */
+    self->load_pending = uri != NULL;
+    update_load (self);
 }
@@ -10,27 +10,20 @@
 #include <glib/gi18n.h>
 
 #include "store-app.h"
-#include "store-app-installed-tile.h"
+#include "store-app-installed-list.h"
+#include "store-cancellable.h"
 #include "store-installed-page.h"
 
 struct _StoreInstalledPage
 {
     StorePage parent_instance;
 
-    GtkBox *app_box;
+    StoreAppInstalledList *app_list;
     GtkLabel *count_label;
 
     GCancellable *cancellable;
 };
 
-enum
-{
-    PROP_0,
-    PROP_APPS,
-    PROP_LAST
-};
-
-
 G_DEFINE_TYPE (StoreInstalledPage, store_installed_page, store_page_get_type ())
 
 enum
@@ -42,9 +35,9 @@ enum
 static guint signals[SIGNAL_LAST] = { 0, };
 
 static void
-tile_activated_cb (StoreInstalledPage *self, StoreAppInstalledTile *tile)
+app_activated_cb (StoreInstalledPage *self, StoreApp *app)
 {
-    g_signal_emit (self, signals[SIGNAL_APP_ACTIVATED], 0, store_app_installed_tile_get_app (tile));
+    g_signal_emit (self, signals[SIGNAL_APP_ACTIVATED], 0, app);
 }
 
 static void
@@ -73,36 +66,13 @@ installed_count_to_label (GBinding *binding G_GNUC_UNUSED, const GValue *from_va
 }
 
 
-static void
-store_installed_page_get_property (GObject *object, guint prop_id, GValue *value G_GNUC_UNUSED, GParamSpec *pspec)
-{
-    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
-}
-
-static void
-store_installed_page_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
-{
-    StoreInstalledPage *self = STORE_INSTALLED_PAGE (object);
-
-    switch (prop_id)
-    {
-    case PROP_APPS:
-        store_installed_page_set_apps (self, g_value_get_boxed (value));
-        break;
-    default:
-        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
-        break;
-    }
-}
-
 static void
 store_installed_page_set_model (StorePage *page, StoreModel *model)
 {
     StoreInstalledPage *self = STORE_INSTALLED_PAGE (page);
 
-    // FIXME: Should apply to children
-
-    g_object_bind_property (model, "installed", self, "apps", G_BINDING_SYNC_CREATE);
+    store_app_grid_set_model (STORE_APP_GRID (self->app_list), model);
+    store_installed_page_set_apps (self, store_model_get_installed_apps (model));
     g_object_bind_property_full (model, "installed", self->count_label, "label", G_BINDING_SYNC_CREATE, installed_count_to_label, NULL, NULL, NULL);
 
     STORE_PAGE_CLASS (store_installed_page_parent_class)->set_model (page, model);
@@ -112,19 +82,15 @@ static void
 store_installed_page_class_init (StoreInstalledPageClass *klass)
 {
     G_OBJECT_CLASS (klass)->dispose = store_installed_page_dispose;
-    G_OBJECT_CLASS (klass)->get_property = store_installed_page_get_property;
-    G_OBJECT_CLASS (klass)->set_property = store_installed_page_set_property;
     STORE_PAGE_CLASS (klass)->set_model = store_installed_page_set_model;
 
-    g_object_class_install_property (G_OBJECT_CLASS (klass),
-                                     PROP_APPS,
-                                     g_param_spec_boxed ("apps", NULL, NULL, G_TYPE_PTR_ARRAY, G_PARAM_WRITABLE));
-
     gtk_widget_class_set_template_from_resource (GTK_WIDGET_CLASS (klass), "/io/snapcraft/Store/store-installed-page.ui");
 
-    gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreInstalledPage, app_box);
+    gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreInstalledPage, app_list);
     gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreInstalledPage, count_label);
 
+    gtk_widget_class_bind_template_callback (GTK_WIDGET_CLASS (klass), app_activated_cb);
+
     signals[SIGNAL_APP_ACTIVATED] = g_signal_new ("app-activated",
                                                   G_TYPE_FROM_CLASS (G_OBJECT_CLASS (klass)),
                                                   G_SIGNAL_RUN_LAST,
@@ -138,47 +104,18 @@ store_installed_page_class_init (StoreInstalledPageClass *klass)
 static void
 store_installed_page_init (StoreInstalledPage *self)
 {
-    self->cancellable = g_cancellable_new ();
+    self->cancellable = store_cancellable_new_child (store_page_get_cancellable (STORE_PAGE (self)));
 
+    store_app_installed_list_get_type ();
     store_page_get_type ();
     gtk_widget_init_template (GTK_WIDGET (self));
 }
 
 void
-store_installed_page_load (StoreInstalledPage *self)
-{
-    g_return_if_fail (STORE_IS_INSTALLED_PAGE (self));
-
-    store_model_update_installed_async (store_page_get_model (STORE_PAGE (self)), NULL, NULL, NULL);
-}
-
-void
-store_installed_page_set_apps (StoreInstalledPage *self, GPtrArray *apps)
+store_installed_page_set_apps (StoreInstalledPage *self, GListModel *apps)
 {
     g_return_if_fail (STORE_IS_INSTALLED_PAGE (self));
 
-    /* Ensure correct number of app tiles */
-    g_autoptr(GList) children = gtk_container_get_children (GTK_CONTAINER (self->app_box));
-    guint n_tiles = g_list_length (children);
-    while (n_tiles < apps->len) {
-        StoreAppInstalledTile *tile = store_app_installed_tile_new ();
-        gtk_widget_show (GTK_WIDGET (tile));
-        g_signal_connect_object (tile, "activated", G_CALLBACK (tile_activated_cb), self, G_CONNECT_SWAPPED);
-        store_app_installed_tile_set_model (tile, store_page_get_model (STORE_PAGE (self)));
-        gtk_container_add (GTK_CONTAINER (self->app_box), GTK_WIDGET (tile));
-        n_tiles++;
-        children = g_list_append (children, tile);
-    }
-    while (n_tiles > apps->len) {
-        for (GList *link = g_list_nth (children, apps->len); link != NULL; link = link->next) {
-            StoreAppInstalledTile *tile = link->data;
-            gtk_container_remove (GTK_CONTAINER (self->app_box), GTK_WIDGET (tile));
-        }
-    }
-
-    for (guint i = 0; i < apps->len; i++) {
-        StoreSnapApp *app = g_ptr_array_index (apps, i);
-        StoreAppInstalledTile *tile = g_list_nth_data (children, i);
-        store_app_installed_tile_set_app (tile, STORE_APP (app));
-    }
+    /* The list follows changes to the model itself and only makes tiles for the rows in view */
+    store_app_installed_list_set_apps (self->app_list, apps);
 }
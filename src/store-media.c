@@ -86,6 +86,17 @@ store_media_to_json (StoreMedia *self)
     return json_builder_get_root (builder);
 }
 
+gboolean
+store_media_equal (StoreMedia *self, StoreMedia *other)
+{
+    if (self == other)
+        return TRUE;
+    if (self == NULL || other == NULL)
+        return FALSE;
+
+    return self->height == other->height && self->width == other->width && g_strcmp0 (self->uri, other->uri) == 0;
+}
+
 void
 store_media_set_height (StoreMedia *self, guint height)
 {
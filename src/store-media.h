@@ -22,6 +22,8 @@ StoreMedia  *store_media_new_from_json (JsonNode *node);
 
 JsonNode    *store_media_to_json       (StoreMedia *media);
 
+gboolean     store_media_equal         (StoreMedia *media, StoreMedia *other);
+
 void         store_media_set_height    (StoreMedia *media, guint height);
 
 guint        store_media_get_height    (StoreMedia *media);
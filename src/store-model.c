@@ -11,8 +11,11 @@
 #include <libsoup/soup.h>
 #include <snapd-glib/snapd-glib.h>
 
+#include "store-diff.h"
 #include "store-model.h"
 #include "store-odrs-client.h"
+#include "store-ready-source.h"
+#include "store-trace.h"
 
 struct _StoreModel
 {
@@ -20,11 +23,26 @@ struct _StoreModel
 
     StoreCache *cache;
     GPtrArray *categories;
+    StoreHttp *http;
+    GHashTable *hydrating;
+    GHashTable *image_metadata;
+    GSource *image_metadata_save_source;
     GPtrArray *installed;
+    GListStore *installed_apps;
+    gint64 last_activity_time;
+    gboolean loaded;
+    gboolean loading_index;
     StoreOdrsClient *odrs_client;
-    SoupSession *session;
+    StoreRecorder *recorder;
+    GCancellable *refresh_cancellable;
+    gint64 refresh_deferred_time;
+    gboolean refresh_pending;
+    GSource *refresh_source;
+    GPtrArray *refreshes;
+    GHashTable *review_pages;
     gchar *snapd_socket_path;
     GHashTable *snaps;
+    GHashTable *snapshot_icons;
 };
 
 enum
@@ -37,6 +55,41 @@ enum
 
 G_DEFINE_TYPE (StoreModel, store_model, G_TYPE_OBJECT)
 
+/* Allow images to download in parallel, keep connections open between page
+ * loads and don't let a stalled server hang requests forever (in seconds) */
+#define HTTP_MAX_CONNECTIONS_PER_HOST 6
+#define HTTP_IDLE_TIMEOUT 60
+#define HTTP_TIMEOUT 30
+
+/* Maximum time in microseconds to spend applying ratings per main loop iteration */
+#define RATINGS_TIME_SLICE 4000
+
+/* Number of reviews to fetch at a time and how long to keep them */
+#define REVIEWS_PAGE_SIZE 10
+#define REVIEWS_EXPIRY (10 * G_TIME_SPAN_MINUTE)
+
+/* How long to collect image metadata changes before writing them out, in seconds */
+#define IMAGE_METADATA_SAVE_DELAY 5
+
+/* How long data is used before it is refreshed */
+#define CATEGORIES_STALENESS (1 * G_TIME_SPAN_HOUR)
+#define INSTALLED_STALENESS (5 * G_TIME_SPAN_MINUTE)
+#define RATINGS_STALENESS (6 * G_TIME_SPAN_HOUR)
+
+/* Refreshes wait until the user has stopped interacting for this long, but
+ * are not put off for more than the maximum */
+#define REFRESH_IDLE_DELAY (3 * G_TIME_SPAN_SECOND)
+#define REFRESH_MAX_DEFERRAL (2 * G_TIME_SPAN_MINUTE)
+
+/* Range of delays before retrying a failed refresh */
+#define REFRESH_BACKOFF_MIN (30 * G_TIME_SPAN_SECOND)
+#define REFRESH_BACKOFF_MAX (30 * G_TIME_SPAN_MINUTE)
+
+/* Apps per category and icon size kept in the home page snapshot */
+#define SNAPSHOT_APPS_PER_CATEGORY 6
+#define SNAPSHOT_ICON_SIZE 72
+#define SNAPSHOT_VERSION 1
+
 typedef struct
 {
     StoreModel *self;
@@ -94,33 +147,335 @@ get_image_data_free (GetImageData *data)
     g_clear_pointer (&data, g_free);
 }
 
+typedef struct
+{
+    gchar *etag;
+    gint64 fetch_time;
+    gint64 height;
+    gint64 max_age;
+    gint64 width;
+} ImageMetadata;
+
+static void
+image_metadata_free (ImageMetadata *metadata)
+{
+    g_clear_pointer (&metadata->etag, g_free);
+    g_free (metadata);
+}
+
+static GHashTable *
+image_metadata_table_new (void)
+{
+    return g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) image_metadata_free);
+}
+
+static ImageMetadata *
+image_metadata_from_json (JsonObject *object)
+{
+    ImageMetadata *metadata = g_new0 (ImageMetadata, 1);
+    if (json_object_has_member (object, "etag"))
+        metadata->etag = g_strdup (json_object_get_string_member (object, "etag"));
+    if (json_object_has_member (object, "fetch-time"))
+        metadata->fetch_time = json_object_get_int_member (object, "fetch-time");
+    if (json_object_has_member (object, "height"))
+        metadata->height = json_object_get_int_member (object, "height");
+    if (json_object_has_member (object, "max-age"))
+        metadata->max_age = json_object_get_int_member (object, "max-age");
+    if (json_object_has_member (object, "width"))
+        metadata->width = json_object_get_int_member (object, "width");
+    return metadata;
+}
+
+/* Written as one object keyed by URI so the whole index is a single cache entry */
+static JsonNode *
+image_metadata_table_to_json (GHashTable *table)
+{
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+    json_builder_begin_object (builder);
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init (&iter, table);
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+        ImageMetadata *metadata = value;
+        json_builder_set_member_name (builder, key);
+        json_builder_begin_object (builder);
+        if (metadata->etag != NULL) {
+            json_builder_set_member_name (builder, "etag");
+            json_builder_add_string_value (builder, metadata->etag);
+        }
+        json_builder_set_member_name (builder, "fetch-time");
+        json_builder_add_int_value (builder, metadata->fetch_time);
+        json_builder_set_member_name (builder, "height");
+        json_builder_add_int_value (builder, metadata->height);
+        if (metadata->max_age != 0) {
+            json_builder_set_member_name (builder, "max-age");
+            json_builder_add_int_value (builder, metadata->max_age);
+        }
+        json_builder_set_member_name (builder, "width");
+        json_builder_add_int_value (builder, metadata->width);
+        json_builder_end_object (builder);
+    }
+    json_builder_end_object (builder);
+
+    return json_builder_get_root (builder);
+}
+
+typedef struct
+{
+    StoreCache *cache;
+    JsonNode *index;
+} SaveImageMetadataData;
+
+static SaveImageMetadataData *
+save_image_metadata_data_new (StoreCache *cache, JsonNode *index)
+{
+    SaveImageMetadataData *data = g_new0 (SaveImageMetadataData, 1);
+    data->cache = g_object_ref (cache);
+    data->index = json_node_ref (index);
+    return data;
+}
+
+static void
+save_image_metadata_data_free (SaveImageMetadataData *data)
+{
+    g_clear_object (&data->cache);
+    g_clear_pointer (&data->index, json_node_unref);
+    g_free (data);
+}
+
+typedef struct
+{
+    StoreCache *cache;
+    GHashTable *image_metadata;
+    gboolean image_metadata_migrated;
+    gchar *ratings_uri;
+    StoreOdrsRatings *ratings;
+    GStrv sections;
+    GPtrArray *remaining_sections;
+    guint n_loading;
+    gboolean returned;
+    gint64 start_time;
+} LoadData;
+
+static LoadData *
+load_data_new (StoreCache *cache, const gchar *ratings_uri)
+{
+    LoadData *data = g_new0 (LoadData, 1);
+    data->cache = g_object_ref (cache);
+    data->ratings_uri = g_strdup (ratings_uri);
+    data->start_time = store_trace_begin ();
+    return data;
+}
+
+static void
+load_data_free (LoadData *data)
+{
+    g_clear_object (&data->cache);
+    g_clear_pointer (&data->image_metadata, g_hash_table_unref);
+    g_clear_pointer (&data->ratings_uri, g_free);
+    g_clear_object (&data->ratings);
+    g_clear_pointer (&data->sections, g_strfreev);
+    g_clear_pointer (&data->remaining_sections, g_ptr_array_unref);
+    g_free (data);
+}
+
+typedef struct
+{
+    StoreCache *cache;
+    JsonNode *snapshot;
+    GHashTable *icons;
+} SnapshotData;
+
+static SnapshotData *
+snapshot_data_new (StoreCache *cache, JsonNode *snapshot)
+{
+    SnapshotData *data = g_new0 (SnapshotData, 1);
+    data->cache = g_object_ref (cache);
+    if (snapshot != NULL)
+        data->snapshot = json_node_ref (snapshot);
+    data->icons = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+    return data;
+}
+
+static void
+snapshot_data_free (SnapshotData *data)
+{
+    g_clear_object (&data->cache);
+    g_clear_pointer (&data->snapshot, json_node_unref);
+    g_clear_pointer (&data->icons, g_hash_table_unref);
+    g_free (data);
+}
+
+typedef struct
+{
+    gchar *name;
+    JsonNode *snap;
+    GPtrArray *reviews;
+} CachedApp;
+
+static void
+cached_app_free (CachedApp *app)
+{
+    g_clear_pointer (&app->name, g_free);
+    g_clear_pointer (&app->snap, json_node_unref);
+    g_clear_pointer (&app->reviews, g_ptr_array_unref);
+    g_free (app);
+}
+
+typedef struct
+{
+    StoreCache *cache;
+    gchar *section;
+    GPtrArray *apps;
+} LoadCategoryData;
+
+static LoadCategoryData *
+load_category_data_new (StoreCache *cache, const gchar *section)
+{
+    LoadCategoryData *data = g_new0 (LoadCategoryData, 1);
+    data->cache = g_object_ref (cache);
+    data->section = g_strdup (section);
+    data->apps = g_ptr_array_new_with_free_func ((GDestroyNotify) cached_app_free);
+    return data;
+}
+
+static void
+load_category_data_free (LoadCategoryData *data)
+{
+    g_clear_object (&data->cache);
+    g_clear_pointer (&data->section, g_free);
+    g_clear_pointer (&data->apps, g_ptr_array_unref);
+    g_free (data);
+}
+
+typedef struct
+{
+    StoreOdrsRatings *old_ratings;
+    GPtrArray *changed_apps;
+    guint n_applied;
+} UpdateRatingsData;
+
+static UpdateRatingsData *
+update_ratings_data_new (StoreOdrsRatings *old_ratings)
+{
+    UpdateRatingsData *data = g_new0 (UpdateRatingsData, 1);
+    if (old_ratings != NULL)
+        data->old_ratings = g_object_ref (old_ratings);
+    data->changed_apps = g_ptr_array_new_with_free_func (g_object_unref);
+    return data;
+}
+
+static void
+update_ratings_data_free (UpdateRatingsData *data)
+{
+    g_clear_object (&data->old_ratings);
+    g_clear_pointer (&data->changed_apps, g_ptr_array_unref);
+    g_free (data);
+}
+
+typedef struct
+{
+    StoreCache *cache;
+    gchar *name;
+    StoreOdrsRatings *ratings;
+} SaveRatingsData;
+
+static SaveRatingsData *
+save_ratings_data_new (StoreCache *cache, const gchar *name, StoreOdrsRatings *ratings)
+{
+    SaveRatingsData *data = g_new0 (SaveRatingsData, 1);
+    data->cache = g_object_ref (cache);
+    data->name = g_strdup (name);
+    data->ratings = g_object_ref (ratings);
+    return data;
+}
+
+static void
+save_ratings_data_free (SaveRatingsData *data)
+{
+    g_clear_object (&data->cache);
+    g_clear_pointer (&data->name, g_free);
+    g_clear_object (&data->ratings);
+    g_free (data);
+}
+
+typedef struct
+{
+    GPtrArray *reviews;
+    GPtrArray *next_page;
+    gboolean complete;
+    gboolean prefetching;
+    GPtrArray *waiting_tasks;
+    gint64 expiry_time;
+} ReviewPages;
+
+static ReviewPages *
+review_pages_new (void)
+{
+    ReviewPages *pages = g_new0 (ReviewPages, 1);
+    pages->waiting_tasks = g_ptr_array_new_with_free_func (g_object_unref);
+    return pages;
+}
+
+static void
+review_pages_free (ReviewPages *pages)
+{
+    g_clear_pointer (&pages->reviews, g_ptr_array_unref);
+    g_clear_pointer (&pages->next_page, g_ptr_array_unref);
+    g_clear_pointer (&pages->waiting_tasks, g_ptr_array_unref);
+    g_free (pages);
+}
+
+typedef void (*RefreshFunc) (StoreModel *self, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data);
+
+typedef struct
+{
+    const gchar *name;
+    GTimeSpan staleness;
+    RefreshFunc refresh;
+    gboolean persist;
+    gboolean missing;
+    gint64 last_refresh_time;
+    gint64 next_refresh_time;
+    guint n_failures;
+    gboolean refreshing;
+} RefreshState;
+
+/* Resources that persist are cached and their refresh times are kept between
+ * runs, the others are refreshed on each start */
+static RefreshState *
+refresh_state_new (const gchar *name, GTimeSpan staleness, RefreshFunc refresh, gboolean persist)
+{
+    RefreshState *state = g_new0 (RefreshState, 1);
+    state->name = name;
+    state->staleness = staleness;
+    state->refresh = refresh;
+    state->persist = persist;
+    return state;
+}
+
 static void
 set_review_counts (StoreModel *self, StoreApp *app)
 {
     if (self->odrs_client == NULL)
         return;
 
-    gint64 *ratings = NULL;
+    const guint32 *ratings = NULL;
     if (store_app_get_appstream_id (app) != NULL)
         ratings = store_odrs_client_get_ratings (self->odrs_client, store_app_get_appstream_id (app));
 
+    g_object_freeze_notify (G_OBJECT (app));
     store_app_set_review_count_one_star (app, ratings != NULL ? ratings[0] : 0);
     store_app_set_review_count_two_star (app, ratings != NULL ? ratings[1] : 0);
     store_app_set_review_count_three_star (app, ratings != NULL ? ratings[2] : 0);
     store_app_set_review_count_four_star (app, ratings != NULL ? ratings[3] : 0);
     store_app_set_review_count_five_star (app, ratings != NULL ? ratings[4] : 0);
+    g_object_thaw_notify (G_OBJECT (app));
 }
 
 static GPtrArray *
-load_cached_reviews (StoreModel *self, const gchar *name)
+reviews_from_json (JsonNode *reviews_cache)
 {
-    if (self->cache == NULL)
-        return NULL;
-
-    g_autoptr(JsonNode) reviews_cache = store_cache_lookup_json (self->cache, "reviews", name, FALSE, NULL, NULL);
-    if (reviews_cache == NULL)
-        return NULL;
-
     g_autoptr(GPtrArray) reviews = g_ptr_array_new_with_free_func (g_object_unref);
     JsonArray *array = json_node_get_array (reviews_cache);
     for (guint i = 0; i < json_array_get_length (array); i++) {
@@ -131,6 +486,19 @@ load_cached_reviews (StoreModel *self, const gchar *name)
     return g_steal_pointer (&reviews);
 }
 
+static GPtrArray *
+load_cached_reviews (StoreModel *self, const gchar *name)
+{
+    if (self->cache == NULL)
+        return NULL;
+
+    g_autoptr(JsonNode) reviews_cache = store_cache_lookup_json (self->cache, "reviews", name, FALSE, NULL, NULL);
+    if (reviews_cache == NULL)
+        return NULL;
+
+    return reviews_from_json (reviews_cache);
+}
+
 static const gchar *
 get_section_title (const gchar *name)
 {
@@ -233,35 +601,17 @@ load_cached_category_apps (StoreModel *self, const gchar *section)
     return g_steal_pointer (&apps);
 }
 
-static GPtrArray *
-load_cached_categories (StoreModel *self)
+static gboolean
+categories_equal (GPtrArray *a, GPtrArray *b)
 {
-    g_autoptr(GPtrArray) categories = g_ptr_array_new_with_free_func (g_object_unref);
-
-    if (self->cache == NULL)
-        return g_steal_pointer (&categories);
-
-    g_autoptr(JsonNode) sections_cache = store_cache_lookup_json (self->cache, "sections", "_index", FALSE, NULL, NULL);
-    if (sections_cache == NULL)
-        return g_steal_pointer (&categories);
-
-    JsonArray *array = json_node_get_array (sections_cache);
-    g_autoptr(GPtrArray) section_array = g_ptr_array_new ();
-    for (guint i = 0; i < json_array_get_length (array); i++) {
-        JsonNode *node = json_array_get_element (array, i);
-        const gchar *section = json_node_get_string (node);
-
-        StoreCategory *category = store_category_new ();
-        g_ptr_array_add (categories, category);
-        store_category_set_name (category, section);
-        store_category_set_title (category, get_section_title (section));
-        store_category_set_summary (category, get_section_summary (section));
+    if (a->len != b->len)
+        return FALSE;
 
-        g_autoptr(GPtrArray) apps = load_cached_category_apps (self, section);
-        store_category_set_apps (category, apps);
-    }
+    for (guint i = 0; i < a->len; i++)
+        if (g_ptr_array_index (a, i) != g_ptr_array_index (b, i))
+            return FALSE;
 
-    return g_steal_pointer (&categories);
+    return TRUE;
 }
 
 StoreCategory *
@@ -276,96 +626,844 @@ find_category (StoreModel *self, const gchar *section_name)
     return NULL;
 }
 
+static StoreSnapApp *
+lookup_snap (StoreModel *self, const gchar *name)
+{
+    StoreSnapApp *snap = g_hash_table_lookup (self->snaps, name);
+    if (snap == NULL) {
+        snap = store_snap_app_new ();
+        store_snap_app_set_snapd_socket_path (snap, self->snapd_socket_path);
+        store_app_set_name (STORE_APP (snap), name);
+        g_hash_table_insert (self->snaps, g_strdup (name), snap); // FIXME: Use a weak ref to clean out when no-longer used
+    }
+
+    return g_object_ref (snap);
+}
+
+static RefreshState *
+find_refresh_state (StoreModel *self, const gchar *name)
+{
+    for (guint i = 0; i < self->refreshes->len; i++) {
+        RefreshState *state = g_ptr_array_index (self->refreshes, i);
+        if (strcmp (state->name, name) == 0)
+            return state;
+    }
+
+    return NULL;
+}
+
 static void
-get_category_snaps_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+schedule_refresh (StoreModel *self)
 {
-    g_autoptr(FindSectionData) data = user_data;
-    StoreModel *self = data->self;
+    gint64 next_refresh_time = G_MAXINT64;
+    for (guint i = 0; i < self->refreshes->len; i++) {
+        RefreshState *state = g_ptr_array_index (self->refreshes, i);
+        if (!state->refreshing && state->next_refresh_time != 0 && state->next_refresh_time < next_refresh_time)
+            next_refresh_time = state->next_refresh_time;
+    }
 
-    g_autoptr(GError) error = NULL;
-    g_autoptr(GPtrArray) snaps = snapd_client_find_section_finish (SNAPD_CLIENT (object), result, NULL, &error);
-    if (snaps == NULL) {
-        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-            return;
-        g_warning ("Failed to find snaps in category: %s", error->message);
+    if (next_refresh_time == G_MAXINT64) {
+        g_source_set_ready_time (self->refresh_source, -1);
         return;
     }
 
-    g_autoptr(GPtrArray) apps = g_ptr_array_new_with_free_func (g_object_unref);
-    for (guint i = 0; i < snaps->len; i++) {
-        SnapdSnap *snap = g_ptr_array_index (snaps, i);
-        g_autoptr(StoreSnapApp) app = store_model_get_snap (self, snapd_snap_get_name (snap));
-        store_snap_app_update_from_search (app, snap);
-        if (self->cache != NULL)
-            store_app_save_to_cache (STORE_APP (app), self->cache);
-        g_ptr_array_add (apps, g_steal_pointer (&app));
-    }
+    /* Refresh times are wall clock so they can be saved, but the source runs on the monotonic clock */
+    GTimeSpan delay = MAX (next_refresh_time - g_get_real_time (), 0);
+    g_debug ("Next refresh in %" G_GINT64_FORMAT "s", delay / G_TIME_SPAN_SECOND);
+    g_source_set_ready_time (self->refresh_source, g_get_monotonic_time () + delay);
+}
 
-    StoreCategory *category = find_category (self, data->section_name);
-    if (category != NULL)
-        store_category_set_apps (category, apps);
+/* Refresh straight away if there was nothing in the cache */
+static void
+mark_missing (StoreModel *self, const gchar *name)
+{
+    RefreshState *state = find_refresh_state (self, name);
 
-    /* Save in cache */
-    if (self->cache != NULL) {
-        g_autoptr(JsonBuilder) builder = json_builder_new ();
-        json_builder_begin_array (builder);
-        for (guint i = 0; i < snaps->len; i++) {
-            SnapdSnap *snap = g_ptr_array_index (snaps, i);
-            json_builder_add_string_value (builder, snapd_snap_get_name (snap));
-        }
-        json_builder_end_array (builder);
-        g_autoptr(JsonNode) root = json_builder_get_root (builder);
-        store_cache_insert_json (self->cache, "sections", data->section_name, FALSE, root, NULL, NULL);
-    }
+    state->missing = TRUE;
+    if (state->refreshing || state->next_refresh_time == 0)
+        return;
+    state->next_refresh_time = g_get_real_time ();
+    schedule_refresh (self);
 }
 
+/* Runs in a worker thread, the index is copied on the main thread so this only writes it */
 static void
-get_sections_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+save_image_metadata_thread (GTask *task, gpointer source_object G_GNUC_UNUSED, gpointer task_data, GCancellable *cancellable)
 {
-    g_autoptr(GTask) task = user_data;
+    SaveImageMetadataData *data = task_data;
 
     g_autoptr(GError) error = NULL;
-    g_auto(GStrv) sections = snapd_client_get_sections_finish (SNAPD_CLIENT (object), result, &error);
-    if (sections == NULL) {
+    if (!store_cache_insert_json (data->cache, "image-metadata", "_index", FALSE, data->index, cancellable, &error)) {
         g_task_return_error (task, g_steal_pointer (&error));
         return;
     }
 
-    StoreModel *self = g_task_get_source_object (task);
+    g_task_return_boolean (task, TRUE);
+}
 
-    g_clear_pointer (&self->categories, g_ptr_array_unref);
-    self->categories = g_ptr_array_new_with_free_func (g_object_unref);
-    for (int i = 0; sections[i] != NULL; i++) {
-        StoreCategory *category = store_category_new ();
-        g_ptr_array_add (self->categories, category);
-        store_category_set_name (category, sections[i]);
-        store_category_set_title (category, get_section_title (sections[i]));
-        store_category_set_summary (category, get_section_summary (sections[i]));
+static void
+save_image_metadata_cb (GObject *object G_GNUC_UNUSED, GAsyncResult *result, gpointer user_data G_GNUC_UNUSED)
+{
+    g_autoptr(GError) error = NULL;
+    if (!g_task_propagate_boolean (G_TASK (result), &error))
+        g_warning ("Failed to save image metadata: %s", error->message);
+}
 
-        g_autoptr(GPtrArray) apps = load_cached_category_apps (self, sections[i]);
-        store_category_set_apps (category, apps);
+static gboolean
+image_metadata_save_cb (gpointer user_data)
+{
+    StoreModel *self = user_data;
 
-        g_autoptr(SnapdClient) client = snapd_client_new ();
-        snapd_client_set_socket_path (client, self->snapd_socket_path);
-        snapd_client_find_section_async (client, SNAPD_FIND_FLAGS_SCOPE_WIDE, sections[i], NULL, g_task_get_cancellable (task), get_category_snaps_cb, find_section_data_new (self, sections[i]));
-    }
+    g_clear_pointer (&self->image_metadata_save_source, g_source_unref);
 
-    /* Save in cache */
-    if (self->cache != NULL) {
-        g_autoptr(JsonBuilder) builder = json_builder_new ();
-        json_builder_begin_array (builder);
-        for (int i = 0; sections[i] != NULL; i++)
-            json_builder_add_string_value (builder, sections[i]);
+    if (self->cache == NULL)
+        return G_SOURCE_REMOVE;
+
+    g_autoptr(JsonNode) index = image_metadata_table_to_json (self->image_metadata);
+    g_autoptr(GTask) task = g_task_new (self, NULL, save_image_metadata_cb, NULL);
+    g_task_set_task_data (task, save_image_metadata_data_new (self->cache, index), (GDestroyNotify) save_image_metadata_data_free);
+    g_task_run_in_thread (task, save_image_metadata_thread);
+
+    return G_SOURCE_REMOVE;
+}
+
+/* Changes are batched up so fetching a page of images writes the index once */
+static void
+schedule_image_metadata_save (StoreModel *self)
+{
+    if (self->image_metadata_save_source != NULL)
+        return;
+
+    self->image_metadata_save_source = g_timeout_source_new_seconds (IMAGE_METADATA_SAVE_DELAY);
+    g_source_set_callback (self->image_metadata_save_source, image_metadata_save_cb, self, NULL);
+    g_source_attach (self->image_metadata_save_source, NULL);
+}
+
+static void
+start_refresh (StoreModel *self)
+{
+    g_autoptr(JsonNode) times = NULL;
+    if (self->cache != NULL)
+        times = store_cache_lookup_json (self->cache, "refresh", "times", FALSE, NULL, NULL);
+    JsonObject *times_object = times != NULL && json_node_get_node_type (times) == JSON_NODE_OBJECT ? json_node_get_object (times) : NULL;
+
+    gint64 now = g_get_real_time ();
+    for (guint i = 0; i < self->refreshes->len; i++) {
+        RefreshState *state = g_ptr_array_index (self->refreshes, i);
+
+        if (state->persist && times_object != NULL && json_object_has_member (times_object, state->name))
+            state->last_refresh_time = json_object_get_int_member (times_object, state->name);
+
+        /* Also refresh if the clock has gone backwards */
+        if (state->missing || state->last_refresh_time == 0 || state->last_refresh_time > now)
+            state->next_refresh_time = now;
+        else
+            state->next_refresh_time = state->last_refresh_time + state->staleness;
+    }
+
+    schedule_refresh (self);
+}
+
+static void
+index_loaded (StoreModel *self)
+{
+    self->loading_index = FALSE;
+    if (self->refresh_pending) {
+        self->refresh_pending = FALSE;
+        start_refresh (self);
+    }
+}
+
+/* Runs in a worker thread, so only touches the cache and not the model */
+static void
+load_index_thread (GTask *task, gpointer source_object G_GNUC_UNUSED, gpointer task_data, GCancellable *cancellable)
+{
+    LoadData *data = task_data;
+
+    /* Ratings first so the cached apps show their stars on first paint */
+    g_autoptr(GBytes) ratings_data = store_cache_lookup_sync (data->cache, "ratings", data->ratings_uri, TRUE, cancellable, NULL);
+    if (ratings_data != NULL) {
+        g_autoptr(GError) error = NULL;
+        data->ratings = store_odrs_ratings_new_from_bytes (ratings_data, &error);
+        if (data->ratings == NULL)
+            g_warning ("Failed to load cached ratings: %s", error->message);
+    }
+
+    g_autoptr(JsonNode) sections_cache = store_cache_lookup_json (data->cache, "sections", "_index", FALSE, cancellable, NULL);
+    GPtrArray *sections = g_ptr_array_new ();
+    if (sections_cache != NULL && json_node_get_node_type (sections_cache) == JSON_NODE_ARRAY) {
+        JsonArray *array = json_node_get_array (sections_cache);
+        for (guint i = 0; i < json_array_get_length (array); i++)
+            g_ptr_array_add (sections, g_strdup (json_array_get_string_element (array, i)));
+    }
+    g_ptr_array_add (sections, NULL);
+    data->sections = (GStrv) g_ptr_array_free (sections, FALSE);
+
+    /* Image metadata is kept in memory so showing an image doesn't need to read the cache */
+    data->image_metadata = image_metadata_table_new ();
+    g_autoptr(JsonNode) image_metadata_cache = store_cache_lookup_json (data->cache, "image-metadata", "_index", FALSE, cancellable, NULL);
+    if (image_metadata_cache != NULL && json_node_get_node_type (image_metadata_cache) == JSON_NODE_OBJECT) {
+        JsonObject *object = json_node_get_object (image_metadata_cache);
+        g_autoptr(GList) uris = json_object_get_members (object);
+        for (GList *link = uris; link != NULL; link = link->next) {
+            const gchar *uri = link->data;
+            JsonNode *node = json_object_get_member (object, uri);
+            if (json_node_get_node_type (node) == JSON_NODE_OBJECT)
+                g_hash_table_insert (data->image_metadata, g_strdup (uri), image_metadata_from_json (json_node_get_object (node)));
+        }
+    }
+    else {
+        /* Caches from before the index have an entry per image */
+        g_auto(GStrv) names = store_cache_list (data->cache, "image-metadata", cancellable, NULL);
+        for (int i = 0; names != NULL && names[i] != NULL; i++) {
+            g_autoptr(JsonNode) node = store_cache_lookup_json (data->cache, "image-metadata", names[i], FALSE, cancellable, NULL);
+            if (node == NULL || json_node_get_node_type (node) != JSON_NODE_OBJECT)
+                continue;
+            JsonObject *object = json_node_get_object (node);
+            if (!json_object_has_member (object, "uri"))
+                continue;
+            g_hash_table_insert (data->image_metadata, g_strdup (json_object_get_string_member (object, "uri")), image_metadata_from_json (object));
+            data->image_metadata_migrated = TRUE;
+        }
+    }
+
+    g_task_return_boolean (task, TRUE);
+}
+
+/* Runs in a worker thread, reads and parses everything needed to show a category */
+static void
+load_category_thread (GTask *task, gpointer source_object G_GNUC_UNUSED, gpointer task_data, GCancellable *cancellable)
+{
+    LoadCategoryData *data = task_data;
+
+    g_autoptr(JsonNode) sections_cache = store_cache_lookup_json (data->cache, "sections", data->section, FALSE, cancellable, NULL);
+    if (sections_cache == NULL || json_node_get_node_type (sections_cache) != JSON_NODE_ARRAY) {
+        g_task_return_boolean (task, TRUE);
+        return;
+    }
+
+    JsonArray *array = json_node_get_array (sections_cache);
+    for (guint i = 0; i < json_array_get_length (array); i++) {
+        if (g_task_return_error_if_cancelled (task))
+            return;
+
+        CachedApp *app = g_new0 (CachedApp, 1);
+        app->name = g_strdup (json_array_get_string_element (array, i));
+        app->snap = store_cache_lookup_json (data->cache, "snaps", app->name, FALSE, cancellable, NULL);
+        g_autoptr(JsonNode) reviews_cache = store_cache_lookup_json (data->cache, "reviews", app->name, FALSE, cancellable, NULL);
+        if (reviews_cache != NULL)
+            app->reviews = reviews_from_json (reviews_cache);
+        g_ptr_array_add (data->apps, app);
+    }
+
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+apply_cached_category (StoreModel *self, LoadCategoryData *data)
+{
+    /* Skip if the network got there first */
+    if (!g_hash_table_remove (self->hydrating, data->section))
+        return;
+
+    StoreCategory *category = find_category (self, data->section);
+    if (category == NULL)
+        return;
+
+    g_autoptr(GPtrArray) apps = g_ptr_array_new_with_free_func (g_object_unref);
+    for (guint i = 0; i < data->apps->len; i++) {
+        CachedApp *cached_app = g_ptr_array_index (data->apps, i);
+        g_autoptr(StoreSnapApp) app = lookup_snap (self, cached_app->name);
+
+        g_object_freeze_notify (G_OBJECT (app));
+        if (cached_app->snap != NULL)
+            store_snap_app_update_from_json (app, cached_app->snap);
+        set_review_counts (self, STORE_APP (app));
+        ReviewPages *pages = g_hash_table_lookup (self->review_pages, cached_app->name);
+        if (pages != NULL && pages->reviews != NULL)
+            store_app_set_reviews (STORE_APP (app), pages->reviews);
+        else if (cached_app->reviews != NULL)
+            store_app_set_reviews (STORE_APP (app), cached_app->reviews);
+        g_object_thaw_notify (G_OBJECT (app));
+
+        g_ptr_array_add (apps, g_steal_pointer (&app));
+    }
+    store_category_set_apps (category, apps);
+}
+
+static void
+load_categories (StoreModel *self, GTask *task, GPtrArray *sections, GAsyncReadyCallback callback)
+{
+    LoadData *data = g_task_get_task_data (task);
+
+    for (guint i = 0; i < sections->len; i++) {
+        const gchar *section = g_ptr_array_index (sections, i);
+
+        /* Categories load in parallel on the GTask thread pool */
+        g_autoptr(GTask) category_task = g_task_new (self, g_task_get_cancellable (task), callback, g_object_ref (task));
+        g_task_set_task_data (category_task, load_category_data_new (data->cache, section), (GDestroyNotify) load_category_data_free);
+        g_task_run_in_thread (category_task, load_category_thread);
+        data->n_loading++;
+    }
+}
+
+/* The load completes as soon as there is something to show, which is straight
+ * after the snapshot if there is one */
+static void
+return_loaded (GTask *task)
+{
+    LoadData *data = g_task_get_task_data (task);
+
+    if (data->returned)
+        return;
+    data->returned = TRUE;
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+load_category_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    StoreModel *self = STORE_MODEL (object);
+    LoadData *data = g_task_get_task_data (task);
+
+    g_autoptr(GError) error = NULL;
+    if (g_task_propagate_boolean (G_TASK (result), &error))
+        apply_cached_category (self, g_task_get_task_data (G_TASK (result)));
+    else if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_warning ("Failed to load cached category: %s", error->message);
+
+    data->n_loading--;
+    if (data->n_loading > 0)
+        return;
+    if (data->remaining_sections == NULL) {
+        store_trace_end ("model-load", data->start_time);
+        return;
+    }
+
+    /* Visible categories are ready to paint, stream in the rest */
+    store_trace_end ("model-load-visible", data->start_time);
+    g_autoptr(GPtrArray) remaining_sections = g_steal_pointer (&data->remaining_sections);
+    if (g_cancellable_is_cancelled (g_task_get_cancellable (task))) {
+        if (!data->returned)
+            g_task_return_error_if_cancelled (task);
+        return;
+    }
+    return_loaded (task);
+    load_categories (self, task, remaining_sections, load_category_cb);
+    if (data->n_loading == 0)
+        store_trace_end ("model-load", data->start_time);
+}
+
+static void
+load_index_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    StoreModel *self = STORE_MODEL (object);
+    LoadData *data = g_task_get_task_data (task);
+
+    g_autoptr(GError) error = NULL;
+    if (!g_task_propagate_boolean (G_TASK (result), &error)) {
+        index_loaded (self);
+        if (data->returned)
+            g_warning ("Failed to load cache index: %s", error->message);
+        else
+            g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+    store_trace_end ("model-load-index", data->start_time);
+
+    /* Keep anything fetched while the index was loading */
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init (&iter, self->image_metadata);
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+        g_hash_table_iter_steal (&iter);
+        g_hash_table_insert (data->image_metadata, key, value);
+    }
+    g_hash_table_unref (self->image_metadata);
+    self->image_metadata = g_steal_pointer (&data->image_metadata);
+    if (data->image_metadata_migrated)
+        schedule_image_metadata_save (self);
+
+    if (data->ratings != NULL && store_odrs_client_get_ratings_table (self->odrs_client) == NULL)
+        store_odrs_client_set_ratings_table (self->odrs_client, data->ratings);
+    if (data->ratings == NULL)
+        mark_missing (self, "ratings");
+    if (data->sections[0] == NULL && self->categories->len == 0)
+        mark_missing (self, "categories");
+    index_loaded (self);
+
+    /* Show all categories straight away and fill them in as they load, unless
+     * the snapshot or snapd already provided them */
+    if (self->categories->len == 0) {
+        g_autoptr(GPtrArray) categories = g_ptr_array_new_with_free_func (g_object_unref);
+        for (int i = 0; data->sections[i] != NULL; i++) {
+            const gchar *section = data->sections[i];
+
+            StoreCategory *category = store_category_new ();
+            g_ptr_array_add (categories, category);
+            store_category_set_name (category, section);
+            store_category_set_title (category, get_section_title (section));
+            store_category_set_summary (category, get_section_summary (section));
+            g_hash_table_add (self->hydrating, g_strdup (section));
+        }
+        g_clear_pointer (&self->categories, g_ptr_array_unref);
+        self->categories = g_steal_pointer (&categories);
+        g_object_notify (G_OBJECT (self), "categories");
+    }
+
+    g_autoptr(GPtrArray) first_sections = g_ptr_array_new ();
+    data->remaining_sections = g_ptr_array_new_with_free_func (g_free);
+    guint n_visible = 0;
+    for (guint i = 0; i < self->categories->len; i++) {
+        StoreCategory *category = g_ptr_array_index (self->categories, i);
+        const gchar *section = store_category_get_name (category);
+
+        /* The home page shows the featured category and the first four others */
+        gboolean visible = FALSE;
+        if (strcmp (section, "featured") == 0)
+            visible = TRUE;
+        else if (n_visible < 4) {
+            visible = TRUE;
+            n_visible++;
+        }
+
+        /* Skip categories snapd has already filled in */
+        if (!g_hash_table_contains (self->hydrating, section))
+            continue;
+
+        if (visible)
+            g_ptr_array_add (first_sections, (gpointer) section);
+        else
+            g_ptr_array_add (data->remaining_sections, g_strdup (section));
+    }
+
+    load_categories (self, task, first_sections, load_category_cb);
+    if (data->n_loading == 0) {
+        g_autoptr(GPtrArray) remaining_sections = g_steal_pointer (&data->remaining_sections);
+        return_loaded (task);
+        load_categories (self, task, remaining_sections, load_category_cb);
+        if (data->n_loading == 0)
+            store_trace_end ("model-load", data->start_time);
+    }
+}
+
+static gboolean
+has_member_of_type (JsonObject *object, const gchar *name, JsonNodeType type)
+{
+    JsonNode *node = json_object_get_member (object, name);
+    return node != NULL && json_node_get_node_type (node) == type;
+}
+
+static gboolean
+is_valid_snapshot_app (JsonNode *app)
+{
+    if (json_node_get_node_type (app) != JSON_NODE_OBJECT)
+        return FALSE;
+
+    JsonObject *object = json_node_get_object (app);
+    if (!has_member_of_type (object, "name", JSON_NODE_VALUE) ||
+        (json_object_has_member (object, "icon") && !has_member_of_type (object, "icon", JSON_NODE_OBJECT)) ||
+        !has_member_of_type (object, "ratings", JSON_NODE_ARRAY))
+        return FALSE;
+
+    /* One count for each number of stars */
+    JsonArray *ratings = json_object_get_array_member (object, "ratings");
+    if (json_array_get_length (ratings) != 5)
+        return FALSE;
+    for (guint i = 0; i < 5; i++)
+        if (json_node_get_value_type (json_array_get_element (ratings, i)) != G_TYPE_INT64)
+            return FALSE;
+
+    return TRUE;
+}
+
+/* Anything unexpected means a cold load rather than showing a broken home page */
+static gboolean
+is_valid_snapshot (JsonNode *snapshot)
+{
+    if (snapshot == NULL || json_node_get_node_type (snapshot) != JSON_NODE_OBJECT)
+        return FALSE;
+
+    JsonObject *object = json_node_get_object (snapshot);
+    if (!json_object_has_member (object, "version") || json_object_get_int_member (object, "version") != SNAPSHOT_VERSION)
+        return FALSE;
+
+    if (!has_member_of_type (object, "categories", JSON_NODE_ARRAY))
+        return FALSE;
+    JsonArray *categories = json_object_get_array_member (object, "categories");
+    for (guint i = 0; i < json_array_get_length (categories); i++) {
+        JsonNode *category = json_array_get_element (categories, i);
+        if (json_node_get_node_type (category) != JSON_NODE_OBJECT)
+            return FALSE;
+
+        JsonObject *category_object = json_node_get_object (category);
+        if (!has_member_of_type (category_object, "name", JSON_NODE_VALUE) || !has_member_of_type (category_object, "apps", JSON_NODE_ARRAY))
+            return FALSE;
+        JsonArray *apps = json_object_get_array_member (category_object, "apps");
+        for (guint j = 0; j < json_array_get_length (apps); j++)
+            if (!is_valid_snapshot_app (json_array_get_element (apps, j)))
+                return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* Runs in a worker thread, the snapshot is a single cache entry so the home
+ * page can be shown from one read */
+static void
+load_snapshot_thread (GTask *task, gpointer source_object G_GNUC_UNUSED, gpointer task_data, GCancellable *cancellable)
+{
+    SnapshotData *data = task_data;
+
+    g_autoptr(JsonNode) snapshot = store_cache_lookup_json (data->cache, "snapshot", "home", FALSE, cancellable, NULL);
+    if (!is_valid_snapshot (snapshot)) {
+        g_task_return_boolean (task, TRUE);
+        return;
+    }
+
+    /* Decode icons here so they're ready to paint */
+    JsonArray *categories = json_object_get_array_member (json_node_get_object (snapshot), "categories");
+    for (guint i = 0; i < json_array_get_length (categories); i++) {
+        JsonArray *apps = json_object_get_array_member (json_array_get_object_element (categories, i), "apps");
+        for (guint j = 0; j < json_array_get_length (apps); j++) {
+            JsonObject *app = json_array_get_object_element (apps, j);
+            if (!json_object_has_member (app, "icon") || !json_object_has_member (app, "icon-data"))
+                continue;
+
+            gsize icon_data_length;
+            g_autofree guchar *icon_data = g_base64_decode (json_object_get_string_member (app, "icon-data"), &icon_data_length);
+            g_autoptr(GInputStream) stream = g_memory_input_stream_new_from_data (icon_data, icon_data_length, NULL);
+            g_autoptr(GdkPixbuf) pixbuf = gdk_pixbuf_new_from_stream (stream, cancellable, NULL);
+            if (pixbuf == NULL)
+                continue;
+
+            const gchar *uri = json_object_get_string_member (json_object_get_object_member (app, "icon"), "uri");
+            g_hash_table_insert (data->icons, g_strdup (uri), g_steal_pointer (&pixbuf));
+        }
+    }
+    data->snapshot = g_steal_pointer (&snapshot);
+
+    g_task_return_boolean (task, TRUE);
+}
+
+static StoreSnapApp *
+snap_from_snapshot (StoreModel *self, JsonObject *object)
+{
+    g_autoptr(StoreSnapApp) app = lookup_snap (self, json_object_get_string_member (object, "name"));
+
+    /* Only the fields the tiles show, the rest are filled in from the cache */
+    g_object_freeze_notify (G_OBJECT (app));
+    store_app_set_appstream_id (STORE_APP (app), json_object_get_string_member (object, "appstream-id"));
+    if (json_object_has_member (object, "icon")) {
+        g_autoptr(StoreMedia) icon = store_media_new_from_json (json_object_get_member (object, "icon"));
+        store_app_set_icon (STORE_APP (app), icon);
+    }
+    store_app_set_publisher (STORE_APP (app), json_object_get_string_member (object, "publisher"));
+    store_app_set_publisher_validated (STORE_APP (app), json_object_get_boolean_member (object, "publisher-validated"));
+    JsonArray *ratings = json_object_get_array_member (object, "ratings");
+    store_app_set_review_count_one_star (STORE_APP (app), json_array_get_int_element (ratings, 0));
+    store_app_set_review_count_two_star (STORE_APP (app), json_array_get_int_element (ratings, 1));
+    store_app_set_review_count_three_star (STORE_APP (app), json_array_get_int_element (ratings, 2));
+    store_app_set_review_count_four_star (STORE_APP (app), json_array_get_int_element (ratings, 3));
+    store_app_set_review_count_five_star (STORE_APP (app), json_array_get_int_element (ratings, 4));
+    store_app_set_summary (STORE_APP (app), json_object_get_string_member (object, "summary"));
+    store_app_set_title (STORE_APP (app), json_object_get_string_member (object, "title"));
+    g_object_thaw_notify (G_OBJECT (app));
+
+    return g_steal_pointer (&app);
+}
+
+/* Returns TRUE if there is enough to show the home page */
+static gboolean
+apply_snapshot (StoreModel *self, SnapshotData *data)
+{
+    if (data->snapshot == NULL)
+        return FALSE;
+
+    /* Keep the icons so images can show them without going to the cache */
+    g_hash_table_unref (self->snapshot_icons);
+    self->snapshot_icons = g_hash_table_ref (data->icons);
+
+    /* Nothing to do if up to date categories arrived from snapd first */
+    if (self->categories->len > 0)
+        return TRUE;
+
+    g_autoptr(GPtrArray) categories = g_ptr_array_new_with_free_func (g_object_unref);
+    JsonArray *array = json_object_get_array_member (json_node_get_object (data->snapshot), "categories");
+    for (guint i = 0; i < json_array_get_length (array); i++) {
+        JsonObject *object = json_array_get_object_element (array, i);
+        const gchar *section = json_object_get_string_member (object, "name");
+
+        StoreCategory *category = store_category_new ();
+        g_ptr_array_add (categories, category);
+        store_category_set_name (category, section);
+        store_category_set_title (category, get_section_title (section));
+        store_category_set_summary (category, get_section_summary (section));
+        g_hash_table_add (self->hydrating, g_strdup (section));
+
+        g_autoptr(GPtrArray) apps = g_ptr_array_new_with_free_func (g_object_unref);
+        JsonArray *apps_array = json_object_get_array_member (object, "apps");
+        for (guint j = 0; j < json_array_get_length (apps_array); j++)
+            g_ptr_array_add (apps, snap_from_snapshot (self, json_array_get_object_element (apps_array, j)));
+        store_category_set_apps (category, apps);
+    }
+    g_clear_pointer (&self->categories, g_ptr_array_unref);
+    self->categories = g_steal_pointer (&categories);
+    g_object_notify (G_OBJECT (self), "categories");
+
+    return TRUE;
+}
+
+static void
+load_snapshot_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    StoreModel *self = STORE_MODEL (object);
+    LoadData *data = g_task_get_task_data (task);
+
+    g_autoptr(GError) error = NULL;
+    if (!g_task_propagate_boolean (G_TASK (result), &error)) {
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            index_loaded (self);
+            g_task_return_error (task, g_steal_pointer (&error));
+            return;
+        }
+        g_warning ("Failed to load snapshot: %s", error->message);
+    }
+    else if (apply_snapshot (self, g_task_get_task_data (G_TASK (result)))) {
+        /* Enough to show the home page, the rest of the cache fills in behind it */
+        store_trace_end ("model-load-snapshot", data->start_time);
+        return_loaded (task);
+    }
+
+    GTask *index_task = g_task_new (self, g_task_get_cancellable (task), load_index_cb, g_steal_pointer (&task));
+    g_task_set_task_data (index_task, data, NULL);
+    g_task_run_in_thread (index_task, load_index_thread);
+    g_object_unref (index_task);
+}
+
+static JsonNode *
+snapshot_app_to_json (StoreModel *self, StoreApp *app)
+{
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "appstream-id");
+    json_builder_add_string_value (builder, store_app_get_appstream_id (app));
+    if (store_app_get_icon (app) != NULL) {
+        json_builder_set_member_name (builder, "icon");
+        json_builder_add_value (builder, store_media_to_json (store_app_get_icon (app)));
+    }
+    json_builder_set_member_name (builder, "name");
+    json_builder_add_string_value (builder, store_app_get_name (app));
+    json_builder_set_member_name (builder, "publisher");
+    json_builder_add_string_value (builder, store_app_get_publisher (app));
+    json_builder_set_member_name (builder, "publisher-validated");
+    json_builder_add_boolean_value (builder, store_app_get_publisher_validated (app));
+    json_builder_set_member_name (builder, "ratings");
+    json_builder_begin_array (builder);
+    const guint32 *ratings = NULL;
+    if (store_app_get_appstream_id (app) != NULL)
+        ratings = store_odrs_client_get_ratings (self->odrs_client, store_app_get_appstream_id (app));
+    for (int i = 0; i < 5; i++)
+        json_builder_add_int_value (builder, ratings != NULL ? ratings[i] : 0);
+    json_builder_end_array (builder);
+    json_builder_set_member_name (builder, "summary");
+    json_builder_add_string_value (builder, store_app_get_summary (app));
+    json_builder_set_member_name (builder, "title");
+    json_builder_add_string_value (builder, store_app_get_title (app));
+    json_builder_end_object (builder);
+
+    return json_builder_get_root (builder);
+}
+
+/* Runs in a worker thread, adds the icons scaled to the size tiles use */
+static void
+save_snapshot_thread (GTask *task, gpointer source_object G_GNUC_UNUSED, gpointer task_data, GCancellable *cancellable)
+{
+    SnapshotData *data = task_data;
+
+    JsonArray *categories = json_object_get_array_member (json_node_get_object (data->snapshot), "categories");
+    for (guint i = 0; i < json_array_get_length (categories); i++) {
+        JsonArray *apps = json_object_get_array_member (json_array_get_object_element (categories, i), "apps");
+        for (guint j = 0; j < json_array_get_length (apps); j++) {
+            if (g_task_return_error_if_cancelled (task))
+                return;
+
+            JsonObject *app = json_array_get_object_element (apps, j);
+            if (!json_object_has_member (app, "icon"))
+                continue;
+
+            const gchar *uri = json_object_get_string_member (json_object_get_object_member (app, "icon"), "uri");
+            g_autoptr(GBytes) image = store_cache_lookup_sync (data->cache, "images", uri, TRUE, cancellable, NULL);
+            if (image == NULL)
+                continue;
+            g_autoptr(GInputStream) stream = g_memory_input_stream_new_from_bytes (image);
+            g_autoptr(GdkPixbuf) pixbuf = gdk_pixbuf_new_from_stream_at_scale (stream, SNAPSHOT_ICON_SIZE, SNAPSHOT_ICON_SIZE, TRUE, cancellable, NULL);
+            if (pixbuf == NULL)
+                continue;
+
+            g_autofree gchar *icon_data = NULL;
+            gsize icon_data_length;
+            if (!gdk_pixbuf_save_to_buffer (pixbuf, &icon_data, &icon_data_length, "png", NULL, NULL))
+                continue;
+            g_autofree gchar *icon_data_base64 = g_base64_encode ((const guchar *) icon_data, icon_data_length);
+            json_object_set_string_member (app, "icon-data", icon_data_base64);
+        }
+    }
+
+    g_autoptr(GError) error = NULL;
+    if (!store_cache_insert_json (data->cache, "snapshot", "home", FALSE, data->snapshot, cancellable, &error)) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+get_category_snaps_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(FindSectionData) data = user_data;
+    StoreModel *self = data->self;
+
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GPtrArray) snaps = snapd_client_find_section_finish (SNAPD_CLIENT (object), result, NULL, &error);
+    if (snaps == NULL) {
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            return;
+        g_warning ("Failed to find snaps in category: %s", error->message);
+        return;
+    }
+
+    g_autoptr(GPtrArray) apps = g_ptr_array_new_with_free_func (g_object_unref);
+    for (guint i = 0; i < snaps->len; i++) {
+        SnapdSnap *snap = g_ptr_array_index (snaps, i);
+        g_autoptr(StoreSnapApp) app = store_model_get_snap (self, snapd_snap_get_name (snap));
+        store_snap_app_update_from_search (app, snap);
+        if (self->cache != NULL)
+            store_app_save_to_cache (STORE_APP (app), self->cache);
+        g_ptr_array_add (apps, g_steal_pointer (&app));
+    }
+
+    StoreCategory *category = find_category (self, data->section_name);
+    if (category != NULL)
+        store_category_set_apps (category, apps);
+    g_hash_table_remove (self->hydrating, data->section_name);
+
+    /* Save in cache */
+    if (self->cache != NULL) {
+        g_autoptr(JsonBuilder) builder = json_builder_new ();
+        json_builder_begin_array (builder);
+        for (guint i = 0; i < snaps->len; i++) {
+            SnapdSnap *snap = g_ptr_array_index (snaps, i);
+            json_builder_add_string_value (builder, snapd_snap_get_name (snap));
+        }
+        json_builder_end_array (builder);
+        g_autoptr(JsonNode) root = json_builder_get_root (builder);
+        store_cache_insert_json (self->cache, "sections", data->section_name, FALSE, root, NULL, NULL);
+    }
+}
+
+static void
+get_sections_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    g_autoptr(GError) error = NULL;
+    g_auto(GStrv) sections = snapd_client_get_sections_finish (SNAPD_CLIENT (object), result, &error);
+    if (sections == NULL) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+
+    StoreModel *self = g_task_get_source_object (task);
+
+    /* Reuse existing categories so views only see changes to their contents */
+    g_autoptr(GPtrArray) categories = g_ptr_array_new_with_free_func (g_object_unref);
+    for (int i = 0; sections[i] != NULL; i++) {
+        StoreCategory *category = find_category (self, sections[i]);
+        if (category != NULL)
+            g_ptr_array_add (categories, g_object_ref (category));
+        else {
+            category = store_category_new ();
+            g_ptr_array_add (categories, category);
+            store_category_set_name (category, sections[i]);
+            store_category_set_title (category, get_section_title (sections[i]));
+            store_category_set_summary (category, get_section_summary (sections[i]));
+
+            g_autoptr(GPtrArray) apps = load_cached_category_apps (self, sections[i]);
+            store_category_set_apps (category, apps);
+        }
+
+        g_autoptr(SnapdClient) client = snapd_client_new ();
+        snapd_client_set_socket_path (client, self->snapd_socket_path);
+        snapd_client_find_section_async (client, SNAPD_FIND_FLAGS_SCOPE_WIDE, sections[i], NULL, g_task_get_cancellable (task), get_category_snaps_cb, find_section_data_new (self, sections[i]));
+    }
+
+    /* Save in cache */
+    if (self->cache != NULL) {
+        g_autoptr(JsonBuilder) builder = json_builder_new ();
+        json_builder_begin_array (builder);
+        for (int i = 0; sections[i] != NULL; i++)
+            json_builder_add_string_value (builder, sections[i]);
         json_builder_end_array (builder);
         g_autoptr(JsonNode) root = json_builder_get_root (builder);
         store_cache_insert_json (self->cache, "sections", "_index", FALSE, root, NULL, NULL);
     }
 
-    g_object_notify (G_OBJECT (self), "categories");
+    if (!categories_equal (self->categories, categories)) {
+        g_clear_pointer (&self->categories, g_ptr_array_unref);
+        self->categories = g_steal_pointer (&categories);
+        g_object_notify (G_OBJECT (self), "categories");
+    }
 
     g_task_return_boolean (task, TRUE);
 }
 
+/* Only change the rows that differ so views don't have to rebuild */
+static void
+update_installed_apps (StoreModel *self)
+{
+    GListModel *list = G_LIST_MODEL (self->installed_apps);
+
+    g_autoptr(GHashTable) positions = g_hash_table_new (g_direct_hash, g_direct_equal);
+    for (guint i = 0; i < self->installed->len; i++)
+        g_hash_table_insert (positions, g_ptr_array_index (self->installed, i), GUINT_TO_POINTER (i));
+
+    /* Remove apps that are no longer installed */
+    for (guint i = g_list_model_get_n_items (list); i > 0; i--) {
+        g_autoptr(StoreApp) app = g_list_model_get_item (list, i - 1);
+        if (!g_hash_table_contains (positions, app))
+            g_list_store_remove (self->installed_apps, i - 1);
+    }
+
+    /* Take out the apps that have changed order, leaving the most that are still in order */
+    guint n_listed = g_list_model_get_n_items (list);
+    g_autofree guint *listed_positions = g_new (guint, n_listed + 1);
+    for (guint i = 0; i < n_listed; i++) {
+        g_autoptr(StoreApp) app = g_list_model_get_item (list, i);
+        listed_positions[i] = GPOINTER_TO_UINT (g_hash_table_lookup (positions, app));
+    }
+    g_autofree gboolean *stationary = store_diff_find_stationary (listed_positions, n_listed);
+    for (guint i = n_listed; i > 0; i--) {
+        if (!stationary[i - 1])
+            g_list_store_remove (self->installed_apps, i - 1);
+    }
+
+    /* Put back moved apps and add new ones, in order so each position is final */
+    for (guint i = 0; i < self->installed->len; i++) {
+        StoreApp *app = g_ptr_array_index (self->installed, i);
+        g_autoptr(StoreApp) current = g_list_model_get_item (list, i);
+        if (current != app)
+            g_list_store_insert (self->installed_apps, i, app);
+    }
+}
+
 static void
 get_snaps_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 {
@@ -391,42 +1489,220 @@ get_snaps_cb (GObject *object, GAsyncResult *result, gpointer user_data)
             store_app_save_to_cache (STORE_APP (app), self->cache);
         g_ptr_array_add (self->installed, g_steal_pointer (&app));
     }
+    update_installed_apps (self);
+
+    g_object_notify (G_OBJECT (self), "installed");
+
+    g_task_return_boolean (task, TRUE);
+}
+
+static gboolean
+ratings_equal (const guint32 *a, const guint32 *b)
+{
+    for (int i = 0; i < 5; i++)
+        if ((a != NULL ? a[i] : 0) != (b != NULL ? b[i] : 0))
+            return FALSE;
+    return TRUE;
+}
+
+static const guint32 *
+lookup_ratings (StoreOdrsRatings *ratings, StoreApp *app)
+{
+    if (ratings == NULL || store_app_get_appstream_id (app) == NULL)
+        return NULL;
+    return store_odrs_ratings_lookup (ratings, store_app_get_appstream_id (app));
+}
+
+static gboolean
+apply_ratings_cb (gpointer user_data)
+{
+    GTask *task = user_data;
+
+    if (g_task_return_error_if_cancelled (task))
+        return G_SOURCE_REMOVE;
+
+    StoreModel *self = g_task_get_source_object (task);
+    UpdateRatingsData *data = g_task_get_task_data (task);
+
+    /* Apply in slices so a large update doesn't stall the main loop */
+    gint64 end_time = g_get_monotonic_time () + RATINGS_TIME_SLICE;
+    do {
+        set_review_counts (self, g_ptr_array_index (data->changed_apps, data->n_applied));
+        data->n_applied++;
+    } while (data->n_applied < data->changed_apps->len && g_get_monotonic_time () < end_time);
+
+    if (data->n_applied < data->changed_apps->len)
+        return G_SOURCE_CONTINUE;
+
+    store_trace_mark ("ratings-applied");
+    g_task_return_boolean (task, TRUE);
+    return G_SOURCE_REMOVE;
+}
+
+/* Runs in a worker thread, the table is complete and no longer changes so it can be read from here */
+static void
+save_ratings_thread (GTask *task, gpointer source_object G_GNUC_UNUSED, gpointer task_data, GCancellable *cancellable)
+{
+    SaveRatingsData *data = task_data;
+
+    g_autoptr(GBytes) bytes = store_odrs_ratings_to_bytes (data->ratings);
+    g_autoptr(GError) error = NULL;
+    if (!store_cache_insert (data->cache, "ratings", data->name, TRUE, bytes, cancellable, &error)) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+save_ratings_cb (GObject *object G_GNUC_UNUSED, GAsyncResult *result, gpointer user_data G_GNUC_UNUSED)
+{
+    g_autoptr(GError) error = NULL;
+    if (!g_task_propagate_boolean (G_TASK (result), &error))
+        g_warning ("Failed to save ratings: %s", error->message);
+}
+
+static void
+ratings_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    g_autoptr(GError) error = NULL;
+    if (!store_odrs_client_update_ratings_finish (STORE_ODRS_CLIENT (object), result, &error)) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+
+    StoreModel *self = g_task_get_source_object (task);
+    UpdateRatingsData *data = g_task_get_task_data (task);
+    StoreOdrsRatings *ratings = store_odrs_client_get_ratings_table (self->odrs_client);
+
+    /* Server confirmed the ratings we have are current */
+    if (ratings == data->old_ratings) {
+        store_trace_mark ("ratings-applied");
+        g_task_return_boolean (task, TRUE);
+        return;
+    }
+
+    if (self->cache != NULL) {
+        g_autoptr(GTask) save_task = g_task_new (self, NULL, save_ratings_cb, NULL);
+        g_task_set_task_data (save_task, save_ratings_data_new (self->cache, store_odrs_client_get_server_uri (self->odrs_client), ratings), (GDestroyNotify) save_ratings_data_free);
+        g_task_run_in_thread (save_task, save_ratings_thread);
+    }
+
+    /* Only update apps whose counts differ from the previous table */
+    GHashTableIter iter;
+    g_hash_table_iter_init (&iter, self->snaps);
+    gpointer key, value;
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+        StoreApp *app = value;
+        if (!ratings_equal (lookup_ratings (data->old_ratings, app), lookup_ratings (ratings, app)))
+            g_ptr_array_add (data->changed_apps, g_object_ref (app));
+    }
+
+    if (data->changed_apps->len == 0) {
+        g_task_return_boolean (task, TRUE);
+        return;
+    }
+
+    g_autoptr(GSource) source = g_idle_source_new ();
+    g_task_attach_source (task, source, apply_ratings_cb);
+}
+
+static ReviewPages *
+get_review_pages (StoreModel *self, StoreApp *app)
+{
+    ReviewPages *pages = g_hash_table_lookup (self->review_pages, store_app_get_name (app));
+    if (pages == NULL) {
+        pages = review_pages_new ();
+        g_hash_table_insert (self->review_pages, g_strdup (store_app_get_name (app)), pages);
+    }
 
-    g_object_notify (G_OBJECT (self), "installed");
+    /* Start again from the first page once expired */
+    if (pages->reviews != NULL && !pages->prefetching && g_get_monotonic_time () > pages->expiry_time) {
+        g_clear_pointer (&pages->reviews, g_ptr_array_unref);
+        g_clear_pointer (&pages->next_page, g_ptr_array_unref);
+        pages->complete = FALSE;
+    }
 
-    g_task_return_boolean (task, TRUE);
+    return pages;
 }
 
 static void
-ratings_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+show_next_page (StoreApp *app, ReviewPages *pages)
+{
+    /* Use a new array so the reviews property changes */
+    GPtrArray *reviews = g_ptr_array_new_with_free_func (g_object_unref);
+    for (guint i = 0; i < pages->reviews->len; i++)
+        g_ptr_array_add (reviews, g_object_ref (g_ptr_array_index (pages->reviews, i)));
+    for (guint i = 0; i < pages->next_page->len; i++)
+        g_ptr_array_add (reviews, g_object_ref (g_ptr_array_index (pages->next_page, i)));
+    g_ptr_array_unref (pages->reviews);
+    pages->reviews = reviews;
+    g_clear_pointer (&pages->next_page, g_ptr_array_unref);
+
+    store_app_set_reviews (app, pages->reviews);
+}
+
+static void
+fetch_next_page (StoreModel *self, StoreApp *app, ReviewPages *pages, GCancellable *cancellable, GAsyncReadyCallback callback)
+{
+    if (pages->reviews == NULL || pages->complete || pages->prefetching || pages->next_page != NULL)
+        return;
+
+    pages->prefetching = TRUE;
+    GTask *task = g_task_new (self, cancellable, NULL, NULL);
+    g_task_set_task_data (task, g_object_ref (app), g_object_unref);
+    store_odrs_client_get_reviews_async (self->odrs_client, store_app_get_appstream_id (app), NULL, NULL, pages->reviews->len, REVIEWS_PAGE_SIZE, cancellable, callback, task);
+}
+
+static void
+prefetch_reviews_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 {
     g_autoptr(GTask) task = user_data;
 
+    StoreModel *self = g_task_get_source_object (task);
+    StoreApp *app = g_task_get_task_data (task);
+    ReviewPages *pages = g_hash_table_lookup (self->review_pages, store_app_get_name (app));
+
+    pages->prefetching = FALSE;
+    g_autoptr(GPtrArray) waiting_tasks = pages->waiting_tasks;
+    pages->waiting_tasks = g_ptr_array_new_with_free_func (g_object_unref);
+
     g_autoptr(GError) error = NULL;
-    if (!store_odrs_client_update_ratings_finish (STORE_ODRS_CLIENT (object), result, &error)) {
+    g_autoptr(GPtrArray) page = store_odrs_client_get_reviews_finish (STORE_ODRS_CLIENT (object), result, NULL, &error);
+    if (page == NULL) {
+        for (guint i = 0; i < waiting_tasks->len; i++)
+            g_task_return_error (g_ptr_array_index (waiting_tasks, i), g_error_copy (error));
         g_task_return_error (task, g_steal_pointer (&error));
         return;
     }
 
-    StoreModel *self = g_task_get_source_object (task);
-
-    /* Update existing apps */
-    GHashTableIter iter;
-    g_hash_table_iter_init (&iter, self->snaps);
-    gpointer key, value;
-    while (g_hash_table_iter_next (&iter, &key, &value)) {
-        StoreSnapApp *snap = value;
-        gint64 *ratings = store_odrs_client_get_ratings (self->odrs_client, store_app_get_appstream_id (STORE_APP (snap)));
-        store_app_set_review_count_one_star (STORE_APP (snap), ratings != NULL ? ratings[0] : 0);
-        store_app_set_review_count_two_star (STORE_APP (snap), ratings != NULL ? ratings[1] : 0);
-        store_app_set_review_count_three_star (STORE_APP (snap), ratings != NULL ? ratings[2] : 0);
-        store_app_set_review_count_four_star (STORE_APP (snap), ratings != NULL ? ratings[3] : 0);
-        store_app_set_review_count_five_star (STORE_APP (snap), ratings != NULL ? ratings[4] : 0);
+    if (page->len < REVIEWS_PAGE_SIZE)
+        pages->complete = TRUE;
+    if (page->len > 0)
+        pages->next_page = g_steal_pointer (&page);
+
+    /* Someone asked for this page while it was loading */
+    if (waiting_tasks->len > 0) {
+        if (pages->next_page != NULL)
+            show_next_page (app, pages);
+        for (guint i = 0; i < waiting_tasks->len; i++)
+            g_task_return_boolean (g_ptr_array_index (waiting_tasks, i), TRUE);
+        fetch_next_page (self, app, pages, g_task_get_cancellable (task), prefetch_reviews_cb);
     }
 
     g_task_return_boolean (task, TRUE);
 }
 
+/* Prefetching stops when the page that wanted the reviews goes away */
+static void
+prefetch_reviews (StoreModel *self, StoreApp *app, ReviewPages *pages, GCancellable *cancellable)
+{
+    fetch_next_page (self, app, pages, cancellable, prefetch_reviews_cb);
+}
+
 static void
 reviews_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 {
@@ -444,9 +1720,16 @@ reviews_cb (GObject *object, GAsyncResult *result, gpointer user_data)
     StoreModel *self = g_task_get_source_object (task);
     StoreApp *app = g_task_get_task_data (task);
 
+    ReviewPages *pages = get_review_pages (self, app);
+    g_clear_pointer (&pages->reviews, g_ptr_array_unref);
+    pages->reviews = g_ptr_array_ref (reviews);
+    g_clear_pointer (&pages->next_page, g_ptr_array_unref);
+    pages->complete = reviews->len < REVIEWS_PAGE_SIZE;
+    pages->expiry_time = g_get_monotonic_time () + REVIEWS_EXPIRY;
+
     store_app_set_reviews (app, reviews);
 
-    /* Save in cache */
+    /* Save first page in cache */
     if (self->cache != NULL) {
         g_autoptr(JsonBuilder) builder = json_builder_new ();
         json_builder_begin_array (builder);
@@ -460,6 +1743,9 @@ reviews_cb (GObject *object, GAsyncResult *result, gpointer user_data)
     }
 
     g_task_return_boolean (task, TRUE);
+
+    /* Get the next page ready while the user reads this one */
+    prefetch_reviews (self, app, pages, g_task_get_cancellable (task));
 }
 
 static void
@@ -487,15 +1773,7 @@ image_size_cb (GetImageData *data, gint width, gint height, GdkPixbufLoader *loa
 static GdkPixbuf *
 process_image (GetImageData *image_data, GBytes *data, GError **error)
 {
-    g_autoptr(GdkPixbufLoader) loader = gdk_pixbuf_loader_new ();
-
-    g_signal_connect_swapped (loader, "size-prepared", G_CALLBACK (image_size_cb), image_data);
-
-    if (!gdk_pixbuf_loader_write_bytes (loader, data, error) ||
-        !gdk_pixbuf_loader_close (loader, error))
-        return NULL;
-
-    return g_object_ref (gdk_pixbuf_loader_get_pixbuf (loader));
+    return store_model_decode_image (data, image_data->width, image_data->height, &image_data->orig_width, &image_data->orig_height, error);
 }
 
 static void
@@ -552,35 +1830,25 @@ read_cb (GObject *object, GAsyncResult *result, gpointer user_data)
         return;
     }
 
+    /* Update the index, it is written out in the background */
+    ImageMetadata *metadata = g_new0 (ImageMetadata, 1);
+    metadata->etag = g_strdup (soup_message_headers_get_one (image_data->message->response_headers, "ETag"));
+    metadata->fetch_time = g_get_real_time () / G_USEC_PER_SEC;
+    metadata->width = image_data->orig_width;
+    metadata->height = image_data->orig_height;
+    const gchar *cache_control = soup_message_headers_get_one (image_data->message->response_headers, "Cache-Control");
+    if (cache_control != NULL) {
+        g_autoptr(GHashTable) params = soup_header_parse_param_list (cache_control);
+        const gchar *max_age = g_hash_table_lookup (params, "max-age");
+        if (max_age != NULL)
+            metadata->max_age = g_ascii_strtoull (max_age, NULL, 10);
+    }
+    g_hash_table_insert (self->image_metadata, g_strdup (image_data->uri), metadata);
+    schedule_image_metadata_save (self);
+
     /* Save in cache */
-    if (self->cache != NULL) {
-        g_autoptr(JsonBuilder) builder = json_builder_new ();
-        json_builder_begin_object (builder);
-        json_builder_set_member_name (builder, "uri");
-        json_builder_add_string_value (builder, image_data->uri);
-        json_builder_set_member_name (builder, "width");
-        json_builder_add_int_value (builder, image_data->orig_width);
-        json_builder_set_member_name (builder, "height");
-        json_builder_add_int_value (builder, image_data->orig_height);
-        const gchar *etag = soup_message_headers_get_one (image_data->message->response_headers, "ETag");
-        if (etag != NULL) {
-            json_builder_set_member_name (builder, "etag");
-            json_builder_add_string_value (builder, etag);
-        }
-        const gchar *cache_control = soup_message_headers_get_one (image_data->message->response_headers, "Cache-Control");
-        if (cache_control != NULL) {
-            g_autoptr(GHashTable) params = soup_header_parse_param_list (cache_control);
-            const gchar *max_age = g_hash_table_lookup (params, "max-age");
-            if (max_age != NULL) {
-                json_builder_set_member_name (builder, "max-age");
-                json_builder_add_int_value (builder, g_ascii_strtoull (max_age, NULL, 10));
-            }
-        }
-        json_builder_end_object (builder);
-        g_autoptr(JsonNode) root = json_builder_get_root (builder);
-        store_cache_insert_json (self->cache, "image-metadata", image_data->uri, TRUE, root, g_task_get_cancellable (task), NULL);
+    if (self->cache != NULL)
         store_cache_insert (self->cache, "images", image_data->uri, TRUE, full_data, g_task_get_cancellable (task), NULL);
-    }
 
     g_task_return_pointer (task, g_steal_pointer (&pixbuf), g_object_unref);
 }
@@ -591,7 +1859,7 @@ send_cb (GObject *object, GAsyncResult *result, gpointer user_data)
     g_autoptr(GTask) task = user_data;
 
     g_autoptr(GError) error = NULL;
-    g_autoptr(GInputStream) stream = soup_session_send_finish (SOUP_SESSION (object), result, &error);
+    g_autoptr(GInputStream) stream = store_http_send_finish (STORE_HTTP (object), result, &error);
     if (stream == NULL) {
         g_task_return_error (task, g_steal_pointer (&error));
         return;
@@ -636,18 +1904,136 @@ search_cb (GObject *object, GAsyncResult *result, gpointer user_data)
     g_task_return_pointer (task, apps, (GDestroyNotify) g_ptr_array_unref);
 }
 
+static void
+save_refresh_times (StoreModel *self)
+{
+    if (self->cache == NULL)
+        return;
+
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+    json_builder_begin_object (builder);
+    for (guint i = 0; i < self->refreshes->len; i++) {
+        RefreshState *state = g_ptr_array_index (self->refreshes, i);
+        if (!state->persist || state->last_refresh_time == 0)
+            continue;
+        json_builder_set_member_name (builder, state->name);
+        json_builder_add_int_value (builder, state->last_refresh_time);
+    }
+    json_builder_end_object (builder);
+    g_autoptr(JsonNode) root = json_builder_get_root (builder);
+    store_cache_insert_json (self->cache, "refresh", "times", FALSE, root, NULL, NULL);
+}
+
+/* Exponential backoff with jitter so clients that failed together don't retry together */
+static GTimeSpan
+get_backoff (RefreshState *state)
+{
+    GTimeSpan backoff = REFRESH_BACKOFF_MIN;
+    for (guint i = 1; i < state->n_failures && backoff < REFRESH_BACKOFF_MAX; i++)
+        backoff *= 2;
+    backoff = MIN (backoff, MIN (REFRESH_BACKOFF_MAX, state->staleness));
+
+    return backoff / 2 + (GTimeSpan) g_random_double_range (0, backoff / 2);
+}
+
+static void
+refresh_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    StoreModel *self = STORE_MODEL (object);
+    RefreshState *state = user_data;
+
+    state->refreshing = FALSE;
+
+    g_autoptr(GError) error = NULL;
+    if (!g_task_propagate_boolean (G_TASK (result), &error)) {
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            return;
+
+        state->n_failures++;
+        GTimeSpan backoff = get_backoff (state);
+        g_warning ("Failed to refresh %s, retrying in %" G_GINT64_FORMAT "s: %s", state->name, backoff / G_TIME_SPAN_SECOND, error->message);
+        state->next_refresh_time = g_get_real_time () + backoff;
+    }
+    else {
+        state->n_failures = 0;
+        state->last_refresh_time = g_get_real_time ();
+        state->next_refresh_time = state->last_refresh_time + state->staleness;
+        if (state->persist)
+            save_refresh_times (self);
+    }
+
+    schedule_refresh (self);
+}
+
+static gboolean
+refresh_timeout_cb (gpointer user_data)
+{
+    StoreModel *self = user_data;
+
+    /* Wait for the user to stop interacting, within reason */
+    gint64 now = g_get_monotonic_time ();
+    if (now - self->last_activity_time < REFRESH_IDLE_DELAY) {
+        if (self->refresh_deferred_time == 0)
+            self->refresh_deferred_time = now;
+        if (now - self->refresh_deferred_time < REFRESH_MAX_DEFERRAL) {
+            g_source_set_ready_time (self->refresh_source, self->last_activity_time + REFRESH_IDLE_DELAY);
+            return G_SOURCE_CONTINUE;
+        }
+    }
+    self->refresh_deferred_time = 0;
+
+    gint64 real_now = g_get_real_time ();
+    for (guint i = 0; i < self->refreshes->len; i++) {
+        RefreshState *state = g_ptr_array_index (self->refreshes, i);
+        if (state->refreshing || state->next_refresh_time == 0 || state->next_refresh_time > real_now)
+            continue;
+
+        g_debug ("Refreshing %s", state->name);
+        state->refreshing = TRUE;
+        state->refresh (self, self->refresh_cancellable, refresh_cb, state);
+    }
+    schedule_refresh (self);
+
+    return G_SOURCE_CONTINUE;
+}
+
 static void
 store_model_dispose (GObject *object)
 {
     StoreModel *self = STORE_MODEL (object);
 
+    /* Write out what hasn't been saved yet, before the cache goes */
+    if (self->image_metadata_save_source != NULL) {
+        g_source_destroy (self->image_metadata_save_source);
+        g_clear_pointer (&self->image_metadata_save_source, g_source_unref);
+
+        if (self->cache != NULL) {
+            g_autoptr(JsonNode) index = image_metadata_table_to_json (self->image_metadata);
+            g_autoptr(GError) error = NULL;
+            if (!store_cache_insert_json (self->cache, "image-metadata", "_index", FALSE, index, NULL, &error))
+                g_warning ("Failed to save image metadata: %s", error->message);
+        }
+    }
+
     g_clear_object (&self->cache);
     g_clear_pointer (&self->categories, g_ptr_array_unref);
+    g_clear_object (&self->http);
+    g_clear_object (&self->recorder);
+    g_clear_pointer (&self->hydrating, g_hash_table_unref);
+    g_clear_pointer (&self->image_metadata, g_hash_table_unref);
     g_clear_pointer (&self->installed, g_ptr_array_unref);
+    g_clear_object (&self->installed_apps);
     g_clear_object (&self->odrs_client);
-    g_clear_object (&self->session);
+    g_cancellable_cancel (self->refresh_cancellable);
+    g_clear_object (&self->refresh_cancellable);
+    if (self->refresh_source != NULL)
+        g_source_destroy (self->refresh_source);
+    g_clear_pointer (&self->refresh_source, g_source_unref);
+    g_clear_pointer (&self->refreshes, g_ptr_array_unref);
+    g_clear_pointer (&self->review_pages, g_hash_table_unref);
     g_clear_pointer (&self->snapd_socket_path, g_free);
     g_clear_pointer (&self->snaps, g_hash_table_unref);
+    g_clear_pointer (&self->snapshot_icons, g_hash_table_unref);
 
     G_OBJECT_CLASS (store_model_parent_class)->dispose (object);
 }
@@ -697,10 +2083,26 @@ store_model_init (StoreModel *self)
 {
     self->cache = store_cache_new ();
     self->categories = g_ptr_array_new ();
+    self->http = store_http_new ();
+    store_http_set_max_connections_per_host (self->http, HTTP_MAX_CONNECTIONS_PER_HOST);
+    store_http_set_idle_timeout (self->http, HTTP_IDLE_TIMEOUT);
+    store_http_set_timeout (self->http, HTTP_TIMEOUT);
+    self->hydrating = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    self->image_metadata = image_metadata_table_new ();
     self->installed = g_ptr_array_new ();
+    self->installed_apps = g_list_store_new (store_app_get_type ());
     self->odrs_client = store_odrs_client_new ();
-    self->session = soup_session_new ();
+    store_odrs_client_set_cache (self->odrs_client, self->cache);
+    store_odrs_client_set_http (self->odrs_client, self->http);
+    self->refresh_cancellable = g_cancellable_new ();
+    self->refresh_source = store_ready_source_new (refresh_timeout_cb, self);
+    self->refreshes = g_ptr_array_new_with_free_func (g_free);
+    g_ptr_array_add (self->refreshes, refresh_state_new ("categories", CATEGORIES_STALENESS, store_model_update_categories_async, TRUE));
+    g_ptr_array_add (self->refreshes, refresh_state_new ("installed", INSTALLED_STALENESS, store_model_update_installed_async, FALSE));
+    g_ptr_array_add (self->refreshes, refresh_state_new ("ratings", RATINGS_STALENESS, store_model_update_ratings_async, TRUE));
+    self->review_pages = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) review_pages_free);
     self->snaps = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+    self->snapshot_icons = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
 }
 
 StoreModel *
@@ -715,6 +2117,7 @@ store_model_set_cache (StoreModel *self, StoreCache *cache)
     g_return_if_fail (STORE_IS_MODEL (self));
 
     g_set_object (&self->cache, cache);
+    store_odrs_client_set_cache (self->odrs_client, cache);
 }
 
 StoreCache *
@@ -725,6 +2128,14 @@ store_model_get_cache (StoreModel *self)
     return self->cache;
 }
 
+StoreHttp *
+store_model_get_http (StoreModel *self)
+{
+    g_return_val_if_fail (STORE_IS_MODEL (self), NULL);
+
+    return self->http;
+}
+
 void
 store_model_set_odrs_server_uri (StoreModel *self, const gchar *uri)
 {
@@ -750,13 +2161,163 @@ store_model_set_snapd_socket_path (StoreModel *self, const gchar *path)
     // FIXME: Update existing StoreSnapApp objects
 }
 
+/* Records snapd and HTTP traffic to a file for replaying with the mock servers.
+ * Call after setting the snapd socket path */
+gboolean
+store_model_start_recording (StoreModel *self, const gchar *path, GError **error)
+{
+    g_return_val_if_fail (STORE_IS_MODEL (self), FALSE);
+
+    if (self->recorder != NULL) {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_EXISTS, "Already recording");
+        return FALSE;
+    }
+
+    g_autoptr(StoreRecorder) recorder = store_recorder_new ();
+    if (!store_recorder_open (recorder, path, error))
+        return FALSE;
+
+    /* Same as snapd-glib uses */
+    const gchar *snapd_socket_path = self->snapd_socket_path;
+    if (snapd_socket_path == NULL)
+        snapd_socket_path = g_getenv ("SNAP") != NULL ? "/run/snapd-snap.socket" : "/run/snapd.socket";
+    const gchar *proxy_socket_path = store_recorder_start_snapd_proxy (recorder, snapd_socket_path, error);
+    if (proxy_socket_path == NULL)
+        return FALSE;
+
+    store_model_set_snapd_socket_path (self, proxy_socket_path);
+    store_http_set_recorder (self->http, recorder);
+    self->recorder = g_steal_pointer (&recorder);
+
+    return TRUE;
+}
+
+/* Completes once the home page snapshot or the categories visible on the home
+ * page are loaded, the rest continue to load in the background */
 void
-store_model_load (StoreModel *self)
+store_model_load_async (StoreModel *self,
+                        GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data)
 {
     g_return_if_fail (STORE_IS_MODEL (self));
 
-    self->categories = load_cached_categories (self);
-    g_object_notify (G_OBJECT (self), "categories");
+    g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
+
+    if (self->cache == NULL || self->loaded) {
+        g_task_return_boolean (task, TRUE);
+        return;
+    }
+    self->loaded = TRUE;
+    self->loading_index = TRUE;
+
+    LoadData *data = load_data_new (self->cache, store_odrs_client_get_server_uri (self->odrs_client));
+    g_task_set_task_data (task, data, (GDestroyNotify) load_data_free);
+    GTask *snapshot_task = g_task_new (self, cancellable, load_snapshot_cb, g_steal_pointer (&task));
+    g_task_set_task_data (snapshot_task, snapshot_data_new (self->cache, NULL), (GDestroyNotify) snapshot_data_free);
+    g_task_run_in_thread (snapshot_task, load_snapshot_thread);
+    g_object_unref (snapshot_task);
+}
+
+gboolean
+store_model_load_finish (StoreModel *self, GAsyncResult *result, GError **error)
+{
+    g_return_val_if_fail (STORE_IS_MODEL (self), FALSE);
+    g_return_val_if_fail (g_task_is_valid (G_TASK (result), self), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/* Saves the categories and the first apps in the visible ones so the home page
+ * can be shown straight away on the next start */
+void
+store_model_save_snapshot_async (StoreModel *self, GPtrArray *visible_categories,
+                                 GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data)
+{
+    g_return_if_fail (STORE_IS_MODEL (self));
+
+    g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
+
+    if (self->cache == NULL || self->categories->len == 0) {
+        g_task_return_boolean (task, TRUE);
+        return;
+    }
+
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "version");
+    json_builder_add_int_value (builder, SNAPSHOT_VERSION);
+    json_builder_set_member_name (builder, "categories");
+    json_builder_begin_array (builder);
+    for (guint i = 0; i < self->categories->len; i++) {
+        StoreCategory *category = g_ptr_array_index (self->categories, i);
+        json_builder_begin_object (builder);
+        json_builder_set_member_name (builder, "name");
+        json_builder_add_string_value (builder, store_category_get_name (category));
+        json_builder_set_member_name (builder, "apps");
+        json_builder_begin_array (builder);
+        if (g_ptr_array_find (visible_categories, category, NULL)) {
+            GPtrArray *apps = store_category_get_apps (category);
+            for (guint j = 0; j < apps->len && j < SNAPSHOT_APPS_PER_CATEGORY; j++)
+                json_builder_add_value (builder, snapshot_app_to_json (self, g_ptr_array_index (apps, j)));
+        }
+        json_builder_end_array (builder);
+        json_builder_end_object (builder);
+    }
+    json_builder_end_array (builder);
+    json_builder_end_object (builder);
+
+    g_autoptr(JsonNode) root = json_builder_get_root (builder);
+    g_task_set_task_data (task, snapshot_data_new (self->cache, root), (GDestroyNotify) snapshot_data_free);
+    g_task_run_in_thread (task, save_snapshot_thread);
+}
+
+gboolean
+store_model_save_snapshot_finish (StoreModel *self, GAsyncResult *result, GError **error)
+{
+    g_return_val_if_fail (STORE_IS_MODEL (self), FALSE);
+    g_return_val_if_fail (g_task_is_valid (G_TASK (result), self), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/* Starts refreshing data in the background, data that is cached and still
+ * fresh from the last run is not refreshed until it goes stale. Waits for the
+ * cached data to load first so it knows what is missing and has the validators
+ * for conditional requests */
+void
+store_model_start_refresh (StoreModel *self)
+{
+    g_return_if_fail (STORE_IS_MODEL (self));
+
+    if (self->loading_index) {
+        self->refresh_pending = TRUE;
+        return;
+    }
+
+    start_refresh (self);
+}
+
+/* Call on user input, refreshes are put off while the user is interacting */
+void
+store_model_report_activity (StoreModel *self)
+{
+    g_return_if_fail (STORE_IS_MODEL (self));
+
+    self->last_activity_time = g_get_monotonic_time ();
+}
+
+/* For diagnostics, returns when @resource ("categories", "installed" or
+ * "ratings") is next due to refresh or %NULL if not scheduled */
+GDateTime *
+store_model_get_next_refresh (StoreModel *self, const gchar *resource)
+{
+    g_return_val_if_fail (STORE_IS_MODEL (self), NULL);
+
+    RefreshState *state = find_refresh_state (self, resource);
+    if (state == NULL || state->refreshing || state->next_refresh_time == 0)
+        return NULL;
+
+    g_autoptr(GDateTime) epoch = g_date_time_new_from_unix_utc (0);
+    return g_date_time_add (epoch, state->next_refresh_time);
 }
 
 StoreSnapApp *
@@ -764,22 +2325,23 @@ store_model_get_snap (StoreModel *self, const gchar *name)
 {
     g_return_val_if_fail (STORE_IS_MODEL (self), NULL);
 
-    StoreSnapApp *snap = g_hash_table_lookup (self->snaps, name);
-    if (snap == NULL) {
-        snap = store_snap_app_new ();
-        store_snap_app_set_snapd_socket_path (snap, self->snapd_socket_path);
-        store_app_set_name (STORE_APP (snap), name);
-        g_hash_table_insert (self->snaps, g_strdup (name), snap); // FIXME: Use a weak ref to clean out when no-longer used
-    }
+    g_autoptr(StoreSnapApp) snap = lookup_snap (self, name);
 
+    g_object_freeze_notify (G_OBJECT (snap));
     if (self->cache != NULL)
         store_app_update_from_cache (STORE_APP (snap), self->cache);
     set_review_counts (self, STORE_APP (snap));
-    g_autoptr(GPtrArray) reviews = load_cached_reviews (self, name);
-    if (reviews != NULL)
-        store_app_set_reviews (STORE_APP (snap), reviews);
+    ReviewPages *pages = g_hash_table_lookup (self->review_pages, name);
+    if (pages != NULL && pages->reviews != NULL)
+        store_app_set_reviews (STORE_APP (snap), pages->reviews);
+    else {
+        g_autoptr(GPtrArray) reviews = load_cached_reviews (self, name);
+        if (reviews != NULL)
+            store_app_set_reviews (STORE_APP (snap), reviews);
+    }
+    g_object_thaw_notify (G_OBJECT (snap));
 
-    return g_object_ref (snap);
+    return g_steal_pointer (&snap);
 }
 
 GPtrArray *
@@ -798,7 +2360,7 @@ store_model_update_categories_async (StoreModel *self,
     g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
     g_autoptr(SnapdClient) client = snapd_client_new ();
     snapd_client_set_socket_path (client, self->snapd_socket_path);
-    snapd_client_get_sections_async (client, cancellable, get_sections_cb, g_steal_pointer (&task)); // FIXME: Combine cancellables
+    snapd_client_get_sections_async (client, cancellable, get_sections_cb, g_steal_pointer (&task));
 }
 
 gboolean
@@ -817,6 +2379,13 @@ store_model_get_installed (StoreModel *self)
     return self->installed;
 }
 
+GListModel *
+store_model_get_installed_apps (StoreModel *self)
+{
+    g_return_val_if_fail (STORE_IS_MODEL (self), NULL);
+    return G_LIST_MODEL (self->installed_apps);
+}
+
 void
 store_model_update_installed_async (StoreModel *self,
                                     GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data)
@@ -826,7 +2395,7 @@ store_model_update_installed_async (StoreModel *self,
     g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
     g_autoptr(SnapdClient) client = snapd_client_new ();
     snapd_client_set_socket_path (client, self->snapd_socket_path);
-    snapd_client_get_snaps_async (client, SNAPD_GET_SNAPS_FLAGS_NONE, NULL, cancellable, get_snaps_cb, g_steal_pointer (&task)); // FIXME: Combine cancellables
+    snapd_client_get_snaps_async (client, SNAPD_GET_SNAPS_FLAGS_NONE, NULL, cancellable, get_snaps_cb, g_steal_pointer (&task));
 }
 
 gboolean
@@ -845,7 +2414,8 @@ store_model_update_ratings_async (StoreModel *self,
     g_return_if_fail (STORE_IS_MODEL (self));
 
     g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
-    store_odrs_client_update_ratings_async (self->odrs_client, cancellable, ratings_cb, g_steal_pointer (&task)); // FIXME: Combine cancellables
+    g_task_set_task_data (task, update_ratings_data_new (store_odrs_client_get_ratings_table (self->odrs_client)), (GDestroyNotify) update_ratings_data_free);
+    store_odrs_client_update_ratings_async (self->odrs_client, cancellable, ratings_cb, g_steal_pointer (&task));
 }
 
 gboolean
@@ -870,8 +2440,17 @@ store_model_update_reviews_async (StoreModel *self, StoreApp *app,
         return;
     }
 
+    /* Use pages already loaded */
+    ReviewPages *pages = get_review_pages (self, app);
+    if (pages->reviews != NULL) {
+        store_app_set_reviews (app, pages->reviews);
+        prefetch_reviews (self, app, pages, cancellable);
+        g_task_return_boolean (task, TRUE);
+        return;
+    }
+
     g_task_set_task_data (task, g_object_ref (app), g_object_unref);
-    store_odrs_client_get_reviews_async (self->odrs_client, store_app_get_appstream_id (app), NULL, NULL, 40, cancellable, reviews_cb, g_steal_pointer (&task)); // FIXME: Combine cancellables
+    store_odrs_client_get_reviews_async (self->odrs_client, store_app_get_appstream_id (app), NULL, NULL, 0, REVIEWS_PAGE_SIZE, cancellable, reviews_cb, g_steal_pointer (&task));
 }
 
 gboolean
@@ -883,6 +2462,59 @@ store_model_update_reviews_finish (StoreModel *self, GAsyncResult *result, GErro
     return g_task_propagate_boolean (G_TASK (result), error);
 }
 
+void
+store_model_load_more_reviews_async (StoreModel *self, StoreApp *app,
+                                     GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data)
+{
+    g_return_if_fail (STORE_IS_MODEL (self));
+
+    g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
+
+    ReviewPages *pages = g_hash_table_lookup (self->review_pages, store_app_get_name (app));
+    if (pages == NULL || pages->reviews == NULL) {
+        g_task_return_boolean (task, TRUE);
+        return;
+    }
+
+    /* Show the prefetched page straight away */
+    if (pages->next_page != NULL) {
+        show_next_page (app, pages);
+        prefetch_reviews (self, app, pages, cancellable);
+        g_task_return_boolean (task, TRUE);
+        return;
+    }
+
+    if (pages->complete) {
+        g_task_return_boolean (task, TRUE);
+        return;
+    }
+
+    /* Wait for the page to arrive */
+    g_ptr_array_add (pages->waiting_tasks, g_steal_pointer (&task));
+    prefetch_reviews (self, app, pages, cancellable);
+}
+
+gboolean
+store_model_load_more_reviews_finish (StoreModel *self, GAsyncResult *result, GError **error)
+{
+    g_return_val_if_fail (STORE_IS_MODEL (self), FALSE);
+    g_return_val_if_fail (g_task_is_valid (G_TASK (result), self), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+gboolean
+store_model_get_has_more_reviews (StoreModel *self, StoreApp *app)
+{
+    g_return_val_if_fail (STORE_IS_MODEL (self), FALSE);
+
+    ReviewPages *pages = g_hash_table_lookup (self->review_pages, store_app_get_name (app));
+    if (pages == NULL || pages->reviews == NULL)
+        return FALSE;
+
+    return pages->next_page != NULL || !pages->complete;
+}
+
 void
 store_model_search_async (StoreModel *self, const gchar *query,
                           GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data)
@@ -892,7 +2524,7 @@ store_model_search_async (StoreModel *self, const gchar *query,
     g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
     g_autoptr(SnapdClient) client = snapd_client_new ();
     snapd_client_set_socket_path (client, self->snapd_socket_path);
-    snapd_client_find_async (client, SNAPD_FIND_FLAGS_SCOPE_WIDE, query, cancellable, search_cb, g_steal_pointer (&task)); // FIXME: Combine cancellables
+    snapd_client_find_async (client, SNAPD_FIND_FLAGS_SCOPE_WIDE, query, cancellable, search_cb, g_steal_pointer (&task));
 }
 
 GPtrArray *
@@ -904,22 +2536,44 @@ store_model_search_finish (StoreModel *self, GAsyncResult *result, GError **erro
     return g_task_propagate_pointer (G_TASK (result), error);
 }
 
+/* Decodes an image scaled to fit in width x height (0 for the original size) */
+GdkPixbuf *
+store_model_decode_image (GBytes *data, gint width, gint height, gint *orig_width, gint *orig_height, GError **error)
+{
+    GetImageData image_data = { .width = width, .height = height };
+
+    g_autoptr(GdkPixbufLoader) loader = gdk_pixbuf_loader_new ();
+
+    g_signal_connect_swapped (loader, "size-prepared", G_CALLBACK (image_size_cb), &image_data);
+
+    if (!gdk_pixbuf_loader_write_bytes (loader, data, error) ||
+        !gdk_pixbuf_loader_close (loader, error))
+        return NULL;
+
+    if (orig_width != NULL)
+        *orig_width = image_data.orig_width;
+    if (orig_height != NULL)
+        *orig_height = image_data.orig_height;
+
+    return g_object_ref (gdk_pixbuf_loader_get_pixbuf (loader));
+}
+
+/* Looked up from memory, the index is loaded with the rest of the cache */
 gboolean
-store_model_get_cached_image_metadata_sync (StoreModel *self, const gchar *uri, gchar **etag, gint64 *width, gint64 *height, GCancellable *cancellable, GError **error)
+store_model_get_cached_image_metadata (StoreModel *self, const gchar *uri, const gchar **etag, gint64 *width, gint64 *height)
 {
     g_return_val_if_fail (STORE_IS_MODEL (self), FALSE);
 
-    g_autoptr(JsonNode) node = store_cache_lookup_json (self->cache, "image-metadata", uri, TRUE, cancellable, error);
-    if (node == NULL)
+    ImageMetadata *metadata = g_hash_table_lookup (self->image_metadata, uri);
+    if (metadata == NULL)
         return FALSE;
 
-    JsonObject *o = json_node_get_object (node);
-    if (etag != NULL && json_object_has_member (o, "etag"))
-        *etag = g_strdup (json_object_get_string_member (o, "etag"));
-    if (width != NULL && json_object_has_member (o, "width"))
-        *width = json_object_get_int_member (o, "width");
-    if (height != NULL && json_object_has_member (o, "height"))
-        *height = json_object_get_int_member (o, "height");
+    if (etag != NULL)
+        *etag = metadata->etag;
+    if (width != NULL)
+        *width = metadata->width;
+    if (height != NULL)
+        *height = metadata->height;
 
     return TRUE;
 }
@@ -931,13 +2585,21 @@ store_model_get_cached_image_async (StoreModel *self, const gchar *uri, gint wid
     g_return_if_fail (STORE_IS_MODEL (self));
 
     g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
+
+    /* Icons from the snapshot are already decoded */
+    GdkPixbuf *icon = g_hash_table_lookup (self->snapshot_icons, uri);
+    if (icon != NULL && width > 0 && width <= SNAPSHOT_ICON_SIZE && height > 0 && height <= SNAPSHOT_ICON_SIZE) {
+        g_task_return_pointer (task, g_object_ref (icon), g_object_unref);
+        return;
+    }
+
     if (self->cache == NULL) {
         g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "No cache");
         return;
     }
 
     g_task_set_task_data (task, get_image_data_new (self, uri, width, height), (GDestroyNotify) get_image_data_free);
-    store_cache_lookup_async (self->cache, "images", uri, TRUE, cancellable, cached_image_cb, g_steal_pointer (&task)); // FIXME: Combine cancellables
+    store_cache_lookup_async (self->cache, "images", uri, TRUE, cancellable, cached_image_cb, g_steal_pointer (&task));
 }
 
 GdkPixbuf *
@@ -961,7 +2623,7 @@ store_model_get_image_async (StoreModel *self, const gchar *uri, const gchar *et
     image_data->message = soup_message_new ("GET", uri);
     if (etag != NULL)
         soup_message_headers_append (image_data->message->request_headers, "If-None-Match", etag);
-    soup_session_send_async (self->session, image_data->message, cancellable, send_cb, g_steal_pointer (&task)); // FIXME: Combine cancellables
+    store_http_send_async (self->http, image_data->message, cancellable, send_cb, g_steal_pointer (&task));
 }
 
 GdkPixbuf *
@@ -14,6 +14,7 @@
 
 #include "store-cache.h"
 #include "store-category.h"
+#include "store-http.h"
 #include "store-snap-app.h"
 
 G_BEGIN_DECLS
@@ -22,18 +23,36 @@ G_DECLARE_FINAL_TYPE   (StoreModel, store_model, STORE, MODEL, GObject)
 
 StoreModel    *store_model_new                            (void);
 
-void           store_model_load                           (StoreModel *model);
+void           store_model_load_async                     (StoreModel *model,
+                                                           GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data);
+
+gboolean       store_model_load_finish                    (StoreModel *model, GAsyncResult *result, GError **error);
+
+void           store_model_save_snapshot_async            (StoreModel *model, GPtrArray *visible_categories,
+                                                           GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data);
+
+gboolean       store_model_save_snapshot_finish           (StoreModel *model, GAsyncResult *result, GError **error);
+
+void           store_model_start_refresh                  (StoreModel *model);
+
+void           store_model_report_activity                (StoreModel *model);
+
+GDateTime     *store_model_get_next_refresh               (StoreModel *model, const gchar *resource);
 
 void           store_model_set_cache                      (StoreModel *model, StoreCache *cache);
 
 StoreCache    *store_model_get_cache                      (StoreModel *model);
 
+StoreHttp     *store_model_get_http                       (StoreModel *model);
+
 void           store_model_set_odrs_server_uri            (StoreModel *model, const gchar *uri);
 
 const gchar   *store_model_get_odrs_server_uri            (StoreModel *model);
 
 void           store_model_set_snapd_socket_path          (StoreModel *model, const gchar *path);
 
+gboolean       store_model_start_recording                (StoreModel *model, const gchar *path, GError **error);
+
 StoreSnapApp  *store_model_get_snap                       (StoreModel *model, const gchar *name);
 
 GPtrArray     *store_model_get_categories                 (StoreModel *model);
@@ -45,6 +64,8 @@ gboolean       store_model_update_categories_finish       (StoreModel *model, GA
 
 GPtrArray     *store_model_get_installed                  (StoreModel *model);
 
+GListModel    *store_model_get_installed_apps             (StoreModel *model);
+
 void           store_model_update_installed_async         (StoreModel *model,
                                                            GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data);
 
@@ -60,13 +81,21 @@ void           store_model_update_reviews_async           (StoreModel *model, St
 
 gboolean       store_model_update_reviews_finish          (StoreModel *model, GAsyncResult *result, GError **error);
 
+void           store_model_load_more_reviews_async        (StoreModel *model, StoreApp *app,
+                                                           GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data);
+
+gboolean       store_model_load_more_reviews_finish       (StoreModel *model, GAsyncResult *result, GError **error);
+
+gboolean       store_model_get_has_more_reviews           (StoreModel *model, StoreApp *app);
+
 void           store_model_search_async                   (StoreModel *model, const gchar *query,
                                                            GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data);
 
 GPtrArray     *store_model_search_finish                  (StoreModel *model, GAsyncResult *result, GError **error);
 
-gboolean       store_model_get_cached_image_metadata_sync (StoreModel *model, const gchar *uri, gchar **etag, gint64 *width, gint64 *height,
-                                                           GCancellable *cancellable, GError **error);
+GdkPixbuf     *store_model_decode_image                   (GBytes *data, gint width, gint height, gint *orig_width, gint *orig_height, GError **error);
+
+gboolean       store_model_get_cached_image_metadata      (StoreModel *model, const gchar *uri, const gchar **etag, gint64 *width, gint64 *height);
 
 void           store_model_get_cached_image_async         (StoreModel *model, const gchar *uri, gint width, gint height,
                                                            GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data);
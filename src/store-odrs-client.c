@@ -12,23 +12,84 @@
 
 #include "store-odrs-client.h"
 
+#include "store-cancellable.h"
+#include "store-http.h"
+#include "store-odrs-ratings.h"
 #include "store-odrs-review.h"
+#include "store-ready-source.h"
+
+/* Time to wait for more feedback before sending */
+#define FEEDBACK_DELAY (2 * G_TIME_SPAN_SECOND)
+
+/* Range of delays before resending feedback that failed to send */
+#define FEEDBACK_RETRY_MIN (30 * G_TIME_SPAN_SECOND)
+#define FEEDBACK_RETRY_MAX (30 * G_TIME_SPAN_MINUTE)
 
 struct _StoreOdrsClient
 {
     GObject parent_instance;
 
+    StoreCache *cache;
     GCancellable *cancellable;
     gchar *distro;
+    GPtrArray *feedback;
+    GTimeSpan feedback_retry_delay;
+    gboolean feedback_save_pending;
+    gboolean feedback_saving;
+    GSource *feedback_source;
+    StoreHttp *http;
     gchar *locale;
-    GHashTable *ratings;
+    StoreOdrsRatings *ratings;
     gchar *server_uri;
-    SoupSession *soup_session;
     gchar *user_hash;
 };
 
 G_DEFINE_TYPE (StoreOdrsClient, store_odrs_client, G_TYPE_OBJECT)
 
+typedef struct
+{
+    StoreOdrsClient *client;
+    gchar *server_uri;
+    gchar *method;
+    JsonNode *request;
+    gboolean sending;
+    SoupMessage *message;
+    GPtrArray *tasks;
+} FeedbackItem;
+
+typedef struct
+{
+    SoupMessage *message;
+    GInputStream *stream;
+    GBytes *chunk;
+    StoreOdrsRatings *ratings;
+} UpdateRatingsData;
+
+typedef struct
+{
+    GInputStream *stream;
+    GByteArray *data;
+} ReadJsonData;
+
+static UpdateRatingsData *
+update_ratings_data_new (SoupMessage *message)
+{
+    UpdateRatingsData *data = g_new0 (UpdateRatingsData, 1);
+    data->message = g_object_ref (message);
+    data->ratings = store_odrs_ratings_new ();
+    return data;
+}
+
+static void
+update_ratings_data_free (UpdateRatingsData *data)
+{
+    g_clear_object (&data->message);
+    g_clear_object (&data->stream);
+    g_clear_pointer (&data->chunk, g_bytes_unref);
+    g_clear_object (&data->ratings);
+    g_free (data);
+}
+
 static gchar *
 get_user_hash (void)
 {
@@ -43,91 +104,206 @@ get_user_hash (void)
     return g_compute_checksum_for_string (G_CHECKSUM_SHA1, salted, -1);
 }
 
-static JsonNode *
-send_finish (GTask *task, GObject *object, GAsyncResult *result, GError **error)
+/* Stop requests when either the caller gives up on them or the client goes away */
+static GCancellable *
+new_task_cancellable (StoreOdrsClient *self, GCancellable *cancellable)
 {
-    g_autoptr(GInputStream) stream = soup_session_send_finish (SOUP_SESSION (object), result, error);
-    if (stream == NULL)
-        return NULL;
+    GCancellable *task_cancellable = store_cancellable_new_child (self->cancellable);
+    store_cancellable_link (task_cancellable, cancellable);
+    return task_cancellable;
+}
 
-    StoreOdrsClient *self = g_task_get_source_object (task);
+static void
+read_json_data_free (ReadJsonData *data)
+{
+    g_clear_object (&data->stream);
+    g_clear_pointer (&data->data, g_byte_array_unref);
+    g_free (data);
+}
+
+static void
+parse_json_thread (GTask *task, gpointer source_object G_GNUC_UNUSED, gpointer task_data, GCancellable *cancellable G_GNUC_UNUSED)
+{
+    ReadJsonData *data = task_data;
 
     g_autoptr(JsonParser) parser = json_parser_new ();
-    if (!json_parser_load_from_stream (parser, stream, self->cancellable, error))
-        return NULL;
+    g_autoptr(GError) error = NULL;
+    if (!json_parser_load_from_data (parser, (const gchar *) data->data->data, data->data->len, &error)) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
 
     JsonNode *root = json_parser_get_root (parser);
     if (root == NULL) {
-        g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "No JSON data returned");
-        return NULL;
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED, "No JSON data returned");
+        return;
     }
 
-    return json_node_ref (root);
+    g_task_return_pointer (task, json_node_ref (root), (GDestroyNotify) json_node_unref);
 }
 
 static void
-get_ratings_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+read_json_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 {
     g_autoptr(GTask) task = user_data;
 
     g_autoptr(GError) error = NULL;
-    g_autoptr(JsonNode) root = send_finish (task, object, result, &error);
-    if (root == NULL) {
+    g_autoptr(GBytes) bytes = g_input_stream_read_bytes_finish (G_INPUT_STREAM (object), result, &error);
+    if (bytes == NULL) {
         g_task_return_error (task, g_steal_pointer (&error));
         return;
     }
 
-    StoreOdrsClient *self = g_task_get_source_object (task);
+    ReadJsonData *data = g_task_get_task_data (task);
 
-    if (json_node_get_node_type (root) != JSON_NODE_OBJECT) {
-        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to get ratings, server returned non JSON object");
+    if (g_bytes_get_size (bytes) > 0) {
+        g_byte_array_append (data->data, g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes));
+        g_input_stream_read_bytes_async (data->stream, 65535, G_PRIORITY_DEFAULT, g_task_get_cancellable (task), read_json_cb, g_steal_pointer (&task));
         return;
     }
 
-    g_clear_pointer (&self->ratings, g_hash_table_unref);
-    self->ratings = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    /* Parse off the main loop, large responses can take a noticeable time */
+    g_task_run_in_thread (task, parse_json_thread);
+}
 
-    if (json_node_get_node_type (root) != JSON_NODE_OBJECT) {
-        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED, "ODRS server returned non-object ratings");
+/* Read a JSON response without blocking the main loop on the network or the parser */
+static void
+read_json_async (StoreOdrsClient *self, GInputStream *stream,
+                 GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data)
+{
+    GTask *task = g_task_new (self, cancellable, callback, callback_data);
+    g_task_set_return_on_cancel (task, TRUE);
+    ReadJsonData *data = g_new0 (ReadJsonData, 1);
+    data->stream = g_object_ref (stream);
+    data->data = g_byte_array_new ();
+    g_task_set_task_data (task, data, (GDestroyNotify) read_json_data_free);
+
+    g_input_stream_read_bytes_async (stream, 65535, G_PRIORITY_DEFAULT, cancellable, read_json_cb, task);
+}
+
+static JsonNode *
+read_json_finish (StoreOdrsClient *self, GAsyncResult *result, GError **error)
+{
+    g_return_val_if_fail (g_task_is_valid (G_TASK (result), self), NULL);
+
+    return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/* Each chunk is parsed as it arrives, so only one is held in memory at a time.
+ * The tokenizer and the sort and pack at the end take a while, so they run in a worker thread */
+static void
+feed_ratings_thread (GTask *task, gpointer source_object G_GNUC_UNUSED, gpointer task_data, GCancellable *cancellable G_GNUC_UNUSED)
+{
+    UpdateRatingsData *data = task_data;
+
+    g_autoptr(GError) error = NULL;
+    gboolean result;
+    if (data->chunk != NULL)
+        result = store_odrs_ratings_feed (data->ratings, g_bytes_get_data (data->chunk, NULL), g_bytes_get_size (data->chunk), &error);
+    else
+        result = store_odrs_ratings_complete (data->ratings, &error);
+    if (!result) {
+        g_task_return_error (task, g_steal_pointer (&error));
         return;
     }
-    JsonObject *ratings_object = json_node_get_object (root);
-    JsonObjectIter iter;
-    json_object_iter_init (&iter, ratings_object);
-    const gchar *app_id;
-    JsonNode *node;
-    while (json_object_iter_next (&iter, &app_id, &node)) {
-        if (json_node_get_node_type (node) != JSON_NODE_OBJECT)
-            continue;
-        JsonObject *o = json_node_get_object (node);
-        gint64 *values = g_new0 (gint64, 5);
-        if (json_object_has_member (o, "star1"))
-            values[0] = json_object_get_int_member (o, "star1");
-        if (json_object_has_member (o, "star2"))
-            values[1] = json_object_get_int_member (o, "star2");
-        if (json_object_has_member (o, "star3"))
-            values[2] = json_object_get_int_member (o, "star3");
-        if (json_object_has_member (o, "star4"))
-            values[3] = json_object_get_int_member (o, "star4");
-        if (json_object_has_member (o, "star5"))
-            values[4] = json_object_get_int_member (o, "star5");
-        g_hash_table_insert (self->ratings, g_strdup (app_id), values);
+
+    g_task_return_boolean (task, TRUE);
+}
+
+/* Called back both when a chunk has been read and when it has been parsed.
+ * The next chunk isn't read until the thread is done with the last one, so
+ * the thread has the table to itself and the main loop only waits on the network */
+static void
+update_ratings_step_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    StoreOdrsClient *self = g_task_get_source_object (task);
+    UpdateRatingsData *data = g_task_get_task_data (task);
+    GCancellable *cancellable = g_task_get_cancellable (task);
+
+    g_autoptr(GError) error = NULL;
+    if (G_IS_INPUT_STREAM (object)) {
+        g_autoptr(GBytes) bytes = g_input_stream_read_bytes_finish (G_INPUT_STREAM (object), result, &error);
+        if (bytes == NULL) {
+            g_task_return_error (task, g_steal_pointer (&error));
+            return;
+        }
+
+        /* An empty read is the end of the feed, which completes the table */
+        if (g_bytes_get_size (bytes) > 0)
+            data->chunk = g_steal_pointer (&bytes);
+        g_autoptr(GTask) feed_task = g_task_new (self, cancellable, update_ratings_step_cb, g_steal_pointer (&task));
+        g_task_set_task_data (feed_task, data, NULL);
+        g_task_run_in_thread (feed_task, feed_ratings_thread);
+        return;
+    }
+
+    if (!g_task_propagate_boolean (G_TASK (result), &error)) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
     }
 
+    if (data->chunk != NULL) {
+        g_clear_pointer (&data->chunk, g_bytes_unref);
+        g_input_stream_read_bytes_async (data->stream, 65535, G_PRIORITY_DEFAULT, cancellable, update_ratings_step_cb, g_steal_pointer (&task));
+        return;
+    }
+
+    /* Keep validators so the next update can be conditional */
+    store_odrs_ratings_set_etag (data->ratings, soup_message_headers_get_one (data->message->response_headers, "ETag"));
+    store_odrs_ratings_set_last_modified (data->ratings, soup_message_headers_get_one (data->message->response_headers, "Last-Modified"));
+
+    /* The table is only handed to the client once it's complete */
+    g_clear_object (&self->ratings);
+    self->ratings = g_object_ref (data->ratings);
+
     g_task_return_boolean (task, TRUE);
 }
 
 static void
-get_reviews_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+get_ratings_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 {
     g_autoptr(GTask) task = user_data;
 
     g_autoptr(GError) error = NULL;
-    g_autoptr(JsonNode) root = send_finish (task, object, result, &error);
+    g_autoptr(GInputStream) stream = store_http_send_finish (STORE_HTTP (object), result, &error);
+    if (stream == NULL) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+
+    StoreOdrsClient *self = g_task_get_source_object (task);
+    UpdateRatingsData *data = g_task_get_task_data (task);
+
+    /* Existing ratings are still current */
+    if (data->message->status_code == SOUP_STATUS_NOT_MODIFIED) {
+        g_task_return_boolean (task, TRUE);
+        return;
+    }
+
+    if (data->message->status_code != SOUP_STATUS_OK) {
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to get ratings, server returned status code %d", data->message->status_code);
+        return;
+    }
+
+    data->stream = g_object_ref (stream);
+    g_input_stream_read_bytes_async (stream, 65535, G_PRIORITY_DEFAULT, g_task_get_cancellable (task), update_ratings_step_cb, g_steal_pointer (&task));
+}
+
+static void
+reviews_json_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    g_autoptr(GError) error = NULL;
+    g_autoptr(JsonNode) root = read_json_finish (STORE_ODRS_CLIENT (object), result, &error);
     if (root == NULL) {
         g_task_return_error (task, g_steal_pointer (&error));
         return;
     }
+    if (g_task_return_error_if_cancelled (task))
+        return;
 
     if (json_node_get_node_type (root) != JSON_NODE_ARRAY) {
         g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to get reviews, server returned non JSON array");
@@ -173,28 +349,95 @@ get_reviews_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 }
 
 static void
-submit_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+get_reviews_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 {
     g_autoptr(GTask) task = user_data;
 
     g_autoptr(GError) error = NULL;
-    g_autoptr(JsonNode) root = send_finish (task, object, result, &error);
-    if (root == NULL) {
+    g_autoptr(GInputStream) stream = store_http_send_finish (STORE_HTTP (object), result, &error);
+    if (stream == NULL) {
         g_task_return_error (task, g_steal_pointer (&error));
         return;
     }
 
-    g_task_return_boolean (task, TRUE);
+    StoreOdrsClient *self = g_task_get_source_object (task);
+    read_json_async (self, stream, g_task_get_cancellable (task), reviews_json_cb, g_steal_pointer (&task));
+}
+
+static FeedbackItem *
+feedback_item_new (const gchar *server_uri, const gchar *method, JsonNode *request)
+{
+    FeedbackItem *item = g_new0 (FeedbackItem, 1);
+    item->server_uri = g_strdup (server_uri);
+    item->method = g_strdup (method);
+    item->request = json_node_ref (request);
+    item->tasks = g_ptr_array_new_with_free_func (g_object_unref);
+    return item;
 }
 
 static void
-upvote_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+feedback_item_free (FeedbackItem *item)
 {
-    g_autoptr(GTask) task = user_data;
+    g_clear_object (&item->client);
+    g_clear_pointer (&item->server_uri, g_free);
+    g_clear_pointer (&item->method, g_free);
+    g_clear_pointer (&item->request, json_node_unref);
+    g_clear_object (&item->message);
+    g_clear_pointer (&item->tasks, g_ptr_array_unref);
+    g_free (item);
+}
+
+/* Votes on the same review cancel each other out, so they share a key */
+static gboolean
+feedback_item_matches (FeedbackItem *item, const gchar *method, JsonNode *request)
+{
+    gboolean is_vote = g_strcmp0 (method, "upvote") == 0 || g_strcmp0 (method, "downvote") == 0;
+    gboolean item_is_vote = g_strcmp0 (item->method, "upvote") == 0 || g_strcmp0 (item->method, "downvote") == 0;
+    if (is_vote != item_is_vote || (!is_vote && g_strcmp0 (method, item->method) != 0))
+        return FALSE;
+
+    JsonObject *object = json_node_get_object (request);
+    JsonObject *item_object = json_node_get_object (item->request);
+    if (g_strcmp0 (json_object_get_string_member (object, "app_id"), json_object_get_string_member (item_object, "app_id")) != 0)
+        return FALSE;
+
+    /* Only one review per app can be submitted, so a later one replaces it */
+    if (g_strcmp0 (method, "submit") == 0)
+        return TRUE;
+
+    return json_object_get_int_member (object, "review_id") == json_object_get_int_member (item_object, "review_id");
+}
+
+typedef struct
+{
+    StoreCache *cache;
+    JsonNode *root;
+} SaveFeedbackData;
+
+static SaveFeedbackData *
+save_feedback_data_new (StoreCache *cache, JsonNode *root)
+{
+    SaveFeedbackData *data = g_new0 (SaveFeedbackData, 1);
+    data->cache = g_object_ref (cache);
+    data->root = json_node_ref (root);
+    return data;
+}
+
+static void
+save_feedback_data_free (SaveFeedbackData *data)
+{
+    g_clear_object (&data->cache);
+    g_clear_pointer (&data->root, json_node_unref);
+    g_free (data);
+}
+
+static void
+save_feedback_thread (GTask *task, gpointer source_object G_GNUC_UNUSED, gpointer task_data, GCancellable *cancellable)
+{
+    SaveFeedbackData *data = task_data;
 
     g_autoptr(GError) error = NULL;
-    g_autoptr(JsonNode) root = send_finish (task, object, result, &error);
-    if (root == NULL) {
+    if (!store_cache_insert_json (data->cache, "odrs", "feedback", FALSE, data->root, cancellable, &error)) {
         g_task_return_error (task, g_steal_pointer (&error));
         return;
     }
@@ -203,42 +446,287 @@ upvote_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 }
 
 static void
-downvote_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+start_save_feedback (StoreOdrsClient *self, GAsyncReadyCallback callback)
 {
-    g_autoptr(GTask) task = user_data;
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+    json_builder_begin_array (builder);
+    for (guint i = 0; i < self->feedback->len; i++) {
+        FeedbackItem *item = g_ptr_array_index (self->feedback, i);
+        json_builder_begin_object (builder);
+        json_builder_set_member_name (builder, "server-uri");
+        json_builder_add_string_value (builder, item->server_uri);
+        json_builder_set_member_name (builder, "method");
+        json_builder_add_string_value (builder, item->method);
+        json_builder_set_member_name (builder, "request");
+        json_builder_add_value (builder, json_node_ref (item->request));
+        json_builder_end_object (builder);
+    }
+    json_builder_end_array (builder);
+    g_autoptr(JsonNode) root = json_builder_get_root (builder);
+
+    /* Written in a thread so voting doesn't wait on the disk */
+    self->feedback_saving = TRUE;
+    g_autoptr(GTask) task = g_task_new (self, NULL, callback, NULL);
+    g_task_set_task_data (task, save_feedback_data_new (self->cache, root), (GDestroyNotify) save_feedback_data_free);
+    g_task_run_in_thread (task, save_feedback_thread);
+}
+
+static void
+save_feedback_cb (GObject *object, GAsyncResult *result, gpointer user_data G_GNUC_UNUSED)
+{
+    StoreOdrsClient *self = STORE_ODRS_CLIENT (object);
 
     g_autoptr(GError) error = NULL;
-    g_autoptr(JsonNode) root = send_finish (task, object, result, &error);
-    if (root == NULL) {
-        g_task_return_error (task, g_steal_pointer (&error));
+    if (!g_task_propagate_boolean (G_TASK (result), &error))
+        g_warning ("Failed to save ODRS feedback queue: %s", error->message);
+
+    /* Save what changed while this was being written */
+    self->feedback_saving = FALSE;
+    if (self->feedback_save_pending && self->cache != NULL) {
+        self->feedback_save_pending = FALSE;
+        start_save_feedback (self, save_feedback_cb);
+    }
+}
+
+static void
+save_feedback (StoreOdrsClient *self)
+{
+    if (self->cache == NULL)
+        return;
+
+    /* Only one save at a time so an older queue can't overwrite a newer one */
+    if (self->feedback_saving)
+        self->feedback_save_pending = TRUE;
+    else
+        start_save_feedback (self, save_feedback_cb);
+}
+
+static void
+load_feedback (StoreOdrsClient *self)
+{
+    g_autoptr(JsonNode) root = store_cache_lookup_json (self->cache, "odrs", "feedback", FALSE, NULL, NULL);
+    if (root == NULL || json_node_get_node_type (root) != JSON_NODE_ARRAY)
         return;
+
+    JsonArray *array = json_node_get_array (root);
+    for (guint i = 0; i < json_array_get_length (array); i++) {
+        JsonNode *element = json_array_get_element (array, i);
+        if (json_node_get_node_type (element) != JSON_NODE_OBJECT)
+            continue;
+        JsonObject *object = json_node_get_object (element);
+        if (!json_object_has_member (object, "server-uri") || !json_object_has_member (object, "method"))
+            continue;
+
+        JsonNode *request = json_object_get_member (object, "request");
+        if (request == NULL || json_node_get_node_type (request) != JSON_NODE_OBJECT)
+            continue;
+
+        /* Anything already queued is the same or newer than what was saved */
+        const gchar *server_uri = json_object_get_string_member (object, "server-uri");
+        const gchar *method = json_object_get_string_member (object, "method");
+        gboolean queued = FALSE;
+        for (guint j = 0; j < self->feedback->len && !queued; j++) {
+            FeedbackItem *item = g_ptr_array_index (self->feedback, j);
+            queued = g_strcmp0 (item->server_uri, server_uri) == 0 && feedback_item_matches (item, method, request);
+        }
+        if (!queued)
+            g_ptr_array_add (self->feedback, feedback_item_new (server_uri, method, request));
     }
+}
 
-    g_task_return_boolean (task, TRUE);
+/* Send the queue after a delay, unless it's already due to go sooner */
+static void
+schedule_feedback (StoreOdrsClient *self, GTimeSpan delay)
+{
+    gint64 ready_time = g_get_monotonic_time () + delay;
+    gint64 current_ready_time = g_source_get_ready_time (self->feedback_source);
+    if (current_ready_time < 0 || ready_time < current_ready_time)
+        g_source_set_ready_time (self->feedback_source, ready_time);
 }
 
+/* Back off while the server can't be reached, so a long outage doesn't mean constant retries */
 static void
-report_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+schedule_feedback_retry (StoreOdrsClient *self)
 {
-    g_autoptr(GTask) task = user_data;
+    self->feedback_retry_delay = CLAMP (self->feedback_retry_delay * 2, FEEDBACK_RETRY_MIN, FEEDBACK_RETRY_MAX);
+    g_debug ("Resending ODRS feedback in %" G_GINT64_FORMAT "s", self->feedback_retry_delay / G_TIME_SPAN_SECOND);
+    schedule_feedback (self, self->feedback_retry_delay);
+}
+
+static void
+complete_feedback_item (FeedbackItem *item, const GError *error)
+{
+    for (guint i = 0; i < item->tasks->len; i++) {
+        GTask *task = g_ptr_array_index (item->tasks, i);
+        if (error != NULL)
+            g_task_return_error (task, g_error_copy (error));
+        else
+            g_task_return_boolean (task, TRUE);
+    }
+    g_ptr_array_set_size (item->tasks, 0);
+}
+
+/* Leave in the queue so it's sent again later, unless the client is going away */
+static void
+retry_feedback_item (FeedbackItem *item, const GError *error)
+{
+    /* The client owns the item, so keep it alive until the item is done with */
+    g_autoptr(StoreOdrsClient) self = g_steal_pointer (&item->client);
+    g_clear_object (&item->message);
+    item->sending = FALSE;
+
+    complete_feedback_item (item, error);
+    if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        g_warning ("Failed to send ODRS %s: %s", item->method, error->message);
+        schedule_feedback_retry (self);
+    }
+}
+
+/* Done with, either the server accepted it or refused it and always will */
+static void
+finish_feedback_item (FeedbackItem *item, const GError *error)
+{
+    g_autoptr(StoreOdrsClient) self = g_steal_pointer (&item->client);
+    g_clear_object (&item->message);
+    item->sending = FALSE;
+
+    if (error != NULL)
+        g_warning ("Dropping ODRS %s: %s", item->method, error->message);
+    complete_feedback_item (item, error);
+    self->feedback_retry_delay = 0;
+
+    g_ptr_array_remove (self->feedback, item);
+    save_feedback (self);
+}
 
+static void
+feedback_json_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    FeedbackItem *item = user_data;
+
+    /* A response cut short might not have been acted on, so send it again */
     g_autoptr(GError) error = NULL;
-    g_autoptr(JsonNode) root = send_finish (task, object, result, &error);
+    g_autoptr(JsonNode) root = read_json_finish (STORE_ODRS_CLIENT (object), result, &error);
     if (root == NULL) {
-        g_task_return_error (task, g_steal_pointer (&error));
+        retry_feedback_item (item, error);
         return;
     }
 
-    g_task_return_boolean (task, TRUE);
+    finish_feedback_item (item, NULL);
 }
 
 static void
-send_feedback (StoreOdrsClient *self, const char *method, GAsyncReadyCallback result_callback, const gchar *user_skey, const gchar *app_id, gint64 review_id,
-               GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data)
+feedback_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 {
-    g_autofree gchar *uri= g_strdup_printf ("%s/1.0/reviews/api/%s", self->server_uri, method);
-    g_autoptr(SoupMessage) message = soup_message_new ("POST", uri);
+    FeedbackItem *item = user_data;
+
+    /* Leave in the queue on connection failures so it's sent next time */
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GInputStream) stream = store_http_send_finish (STORE_HTTP (object), result, &error);
+    if (stream == NULL) {
+        retry_feedback_item (item, error);
+        return;
+    }
+
+    /* The request was bad, e.g. the review has gone, sending it again won't help */
+    guint status_code = item->message->status_code;
+    if (SOUP_STATUS_IS_CLIENT_ERROR (status_code)) {
+        g_autoptr(GError) status_error = g_error_new (G_IO_ERROR, G_IO_ERROR_FAILED, "Server returned status code %u", status_code);
+        finish_feedback_item (item, status_error);
+        return;
+    }
 
+    /* Anything else, e.g. the server is overloaded, may well work later */
+    if (!SOUP_STATUS_IS_SUCCESSFUL (status_code)) {
+        g_autoptr(GError) status_error = g_error_new (G_IO_ERROR, G_IO_ERROR_FAILED, "Server returned status code %u", status_code);
+        retry_feedback_item (item, status_error);
+        return;
+    }
+
+    read_json_async (item->client, stream, item->client->cancellable, feedback_json_cb, item);
+}
+
+static gboolean
+flush_feedback_cb (gpointer user_data)
+{
+    StoreOdrsClient *self = user_data;
+
+    g_source_set_ready_time (self->feedback_source, -1);
+
+    gboolean dropped = FALSE;
+    for (guint i = 0; i < self->feedback->len; i++) {
+        FeedbackItem *item = g_ptr_array_index (self->feedback, i);
+        if (item->sending)
+            continue;
+
+        g_autofree gchar *uri = g_strdup_printf ("%s/1.0/reviews/api/%s", item->server_uri, item->method);
+        g_autoptr(SoupMessage) message = soup_message_new ("POST", uri);
+
+        /* This will never send, so don't keep it around */
+        if (message == NULL) {
+            g_autoptr(GError) error = g_error_new (G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT, "Invalid ODRS URI %s", uri);
+            g_warning ("Dropping ODRS %s: %s", item->method, error->message);
+            complete_feedback_item (item, error);
+            g_ptr_array_remove_index (self->feedback, i);
+            i--;
+            dropped = TRUE;
+            continue;
+        }
+
+        g_autoptr(JsonGenerator) generator = json_generator_new ();
+        json_generator_set_root (generator, item->request);
+        gsize json_text_length;
+        g_autofree gchar *json_text = json_generator_to_data (generator, &json_text_length);
+        soup_message_set_request (message, "application/json; charset=utf-8", SOUP_MEMORY_COPY, json_text, json_text_length);
+
+        item->sending = TRUE;
+        item->client = g_object_ref (self);
+        item->message = g_object_ref (message);
+        store_http_send_async (self->http, message, self->cancellable, feedback_cb, item);
+    }
+    if (dropped)
+        save_feedback (self);
+
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+queue_feedback (StoreOdrsClient *self, const gchar *method, JsonNode *request,
+                GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data)
+{
+    /* The caller's cancellable only stops waiting for the result, the feedback is still sent */
+    g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
+
+    /* Replace anything not yet sent that this supersedes, e.g. an upvote then a downvote */
+    FeedbackItem *item = NULL;
+    for (guint i = 0; i < self->feedback->len; i++) {
+        FeedbackItem *existing = g_ptr_array_index (self->feedback, i);
+        if (!existing->sending && g_strcmp0 (existing->server_uri, self->server_uri) == 0 && feedback_item_matches (existing, method, request)) {
+            item = existing;
+            break;
+        }
+    }
+    if (item != NULL) {
+        g_free (item->method);
+        item->method = g_strdup (method);
+        json_node_unref (item->request);
+        item->request = json_node_ref (request);
+    }
+    else {
+        item = feedback_item_new (self->server_uri, method, request);
+        g_ptr_array_add (self->feedback, item);
+    }
+    g_ptr_array_add (item->tasks, g_steal_pointer (&task));
+    save_feedback (self);
+
+    /* Wait a bit so a burst of actions goes out together */
+    schedule_feedback (self, FEEDBACK_DELAY);
+}
+
+static void
+send_feedback (StoreOdrsClient *self, const char *method, const gchar *user_skey, const gchar *app_id, gint64 review_id,
+               GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data)
+{
     g_autoptr(JsonBuilder) builder = json_builder_new ();
     json_builder_begin_object (builder);
     json_builder_set_member_name (builder, "user_hash");
@@ -250,15 +738,9 @@ send_feedback (StoreOdrsClient *self, const char *method, GAsyncReadyCallback re
     json_builder_set_member_name (builder, "review_id");
     json_builder_add_int_value (builder, review_id);
     json_builder_end_object (builder);
-    g_autoptr(JsonGenerator) generator = json_generator_new ();
     g_autoptr(JsonNode) root = json_builder_get_root (builder);
-    json_generator_set_root (generator, root);
-    gsize json_text_length;
-    g_autofree gchar *json_text = json_generator_to_data (generator, &json_text_length);
-    soup_message_set_request (message, "application/json; charset=utf-8", SOUP_MEMORY_COPY, json_text, json_text_length);
 
-    GTask *task = g_task_new (self, cancellable, callback, callback_data); // FIXME: Need to combine cancellables?
-    soup_session_send_async (self->soup_session, message, self->cancellable, result_callback, task);
+    queue_feedback (self, method, root, cancellable, callback, callback_data);
 }
 
 static void
@@ -266,13 +748,18 @@ store_odrs_client_dispose (GObject *object)
 {
     StoreOdrsClient *self = STORE_ODRS_CLIENT (object);
 
+    if (self->feedback_source != NULL)
+        g_source_destroy (self->feedback_source);
+    g_clear_pointer (&self->feedback_source, g_source_unref);
+    g_clear_object (&self->cache);
     g_cancellable_cancel (self->cancellable);
     g_clear_object (&self->cancellable);
     g_clear_pointer (&self->distro, g_free);
+    g_clear_pointer (&self->feedback, g_ptr_array_unref);
+    g_clear_object (&self->http);
     g_clear_pointer (&self->locale, g_free);
-    g_clear_pointer (&self->ratings, g_hash_table_unref);
+    g_clear_object (&self->ratings);
     g_clear_pointer (&self->server_uri, g_free);
-    g_clear_object (&self->soup_session);
     g_clear_pointer (&self->user_hash, g_free);
 
     G_OBJECT_CLASS (store_odrs_client_parent_class)->dispose (object);
@@ -289,9 +776,10 @@ store_odrs_client_init (StoreOdrsClient *self)
 {
     self->cancellable = g_cancellable_new ();
     self->distro = g_strdup ("Ubuntu"); // FIXME
+    self->feedback = g_ptr_array_new_with_free_func ((GDestroyNotify) feedback_item_free);
+    self->feedback_source = store_ready_source_new (flush_feedback_cb, self);
     self->locale = g_strdup ("en"); // FIXME
     self->server_uri = g_strdup ("https://odrs.gnome.org");
-    self->soup_session = soup_session_new (); // FIXME: Support common session
     self->user_hash = get_user_hash ();
 }
 
@@ -301,6 +789,20 @@ store_odrs_client_new (void)
     return g_object_new (store_odrs_client_get_type (), NULL);
 }
 
+void
+store_odrs_client_set_cache (StoreOdrsClient *self, StoreCache *cache)
+{
+    g_return_if_fail (STORE_IS_ODRS_CLIENT (self));
+
+    if (!g_set_object (&self->cache, cache) || cache == NULL)
+        return;
+
+    /* Send anything left over from last time */
+    load_feedback (self);
+    if (self->feedback->len > 0)
+        schedule_feedback (self, FEEDBACK_DELAY);
+}
+
 void
 store_odrs_client_set_server_uri (StoreOdrsClient *self, const gchar *server_uri)
 {
@@ -334,7 +836,34 @@ store_odrs_client_set_locale (StoreOdrsClient *self, const gchar *locale)
     self->locale = g_strdup (locale);
 }
 
-gint64 *
+/* Must be set before making requests, the client shares the owner's session */
+void
+store_odrs_client_set_http (StoreOdrsClient *self, StoreHttp *http)
+{
+    g_return_if_fail (STORE_IS_ODRS_CLIENT (self));
+    g_return_if_fail (STORE_IS_HTTP (http));
+
+    g_set_object (&self->http, http);
+}
+
+void
+store_odrs_client_set_ratings_table (StoreOdrsClient *self, StoreOdrsRatings *ratings)
+{
+    g_return_if_fail (STORE_IS_ODRS_CLIENT (self));
+
+    g_clear_object (&self->ratings);
+    if (ratings != NULL)
+        self->ratings = g_object_ref (ratings);
+}
+
+StoreOdrsRatings *
+store_odrs_client_get_ratings_table (StoreOdrsClient *self)
+{
+    g_return_val_if_fail (STORE_IS_ODRS_CLIENT (self), NULL);
+    return self->ratings;
+}
+
+const guint32 *
 store_odrs_client_get_ratings (StoreOdrsClient *self, const gchar *app_id)
 {
     g_return_val_if_fail (STORE_IS_ODRS_CLIENT (self), NULL);
@@ -343,7 +872,7 @@ store_odrs_client_get_ratings (StoreOdrsClient *self, const gchar *app_id)
     if (self->ratings == NULL)
         return NULL;
 
-    return g_hash_table_lookup (self->ratings, app_id);
+    return store_odrs_ratings_lookup (self->ratings, app_id);
 }
 
 void
@@ -354,9 +883,19 @@ store_odrs_client_update_ratings_async (StoreOdrsClient *self,
 
     g_autofree gchar *uri= g_strdup_printf ("%s/1.0/reviews/api/ratings", self->server_uri);
     g_autoptr(SoupMessage) message = soup_message_new ("GET", uri);
+    if (self->ratings != NULL) {
+        const gchar *etag = store_odrs_ratings_get_etag (self->ratings);
+        const gchar *last_modified = store_odrs_ratings_get_last_modified (self->ratings);
+        if (etag != NULL)
+            soup_message_headers_append (message->request_headers, "If-None-Match", etag);
+        if (last_modified != NULL)
+            soup_message_headers_append (message->request_headers, "If-Modified-Since", last_modified);
+    }
 
-    GTask *task = g_task_new (self, cancellable, callback, callback_data); // FIXME: Need to combine cancellables?
-    soup_session_send_async (self->soup_session, message, self->cancellable, get_ratings_cb, task);
+    g_autoptr(GCancellable) task_cancellable = new_task_cancellable (self, cancellable);
+    GTask *task = g_task_new (self, task_cancellable, callback, callback_data);
+    g_task_set_task_data (task, update_ratings_data_new (message), (GDestroyNotify) update_ratings_data_free);
+    store_http_send_async (self->http, message, task_cancellable, get_ratings_cb, task);
 }
 
 gboolean
@@ -369,7 +908,7 @@ store_odrs_client_update_ratings_finish (StoreOdrsClient *self, GAsyncResult *re
 }
 
 void
-store_odrs_client_get_reviews_async (StoreOdrsClient *self, const gchar *app_id, GStrv compat_ids, const gchar *version, gint64 limit, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data)
+store_odrs_client_get_reviews_async (StoreOdrsClient *self, const gchar *app_id, GStrv compat_ids, const gchar *version, gint64 start, gint64 limit, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data)
 {
     g_return_if_fail (STORE_IS_ODRS_CLIENT (self));
     g_return_if_fail (app_id != NULL);
@@ -399,6 +938,8 @@ store_odrs_client_get_reviews_async (StoreOdrsClient *self, const gchar *app_id,
     json_builder_add_string_value (builder, self->distro);
     json_builder_set_member_name (builder, "version");
     json_builder_add_string_value (builder, version);
+    json_builder_set_member_name (builder, "start");
+    json_builder_add_int_value (builder, start);
     json_builder_set_member_name (builder, "limit");
     json_builder_add_int_value (builder, limit);
     json_builder_end_object (builder);
@@ -409,8 +950,9 @@ store_odrs_client_get_reviews_async (StoreOdrsClient *self, const gchar *app_id,
     g_autofree gchar *json_text = json_generator_to_data (generator, &json_text_length);
     soup_message_set_request (message, "application/json; charset=utf-8", SOUP_MEMORY_COPY, json_text, json_text_length);
 
-    GTask *task = g_task_new (self, cancellable, callback, callback_data); // FIXME: Need to combine cancellables?
-    soup_session_send_async (self->soup_session, message, self->cancellable, get_reviews_cb, task);
+    g_autoptr(GCancellable) task_cancellable = new_task_cancellable (self, cancellable);
+    GTask *task = g_task_new (self, task_cancellable, callback, callback_data);
+    store_http_send_async (self->http, message, task_cancellable, get_reviews_cb, task);
 }
 
 GPtrArray *
@@ -440,9 +982,6 @@ store_odrs_client_submit_async (StoreOdrsClient *self, const gchar *user_skey, c
     g_return_if_fail (STORE_IS_ODRS_CLIENT (self));
     g_return_if_fail (app_id != NULL);
 
-    g_autofree gchar *uri= g_strdup_printf ("%s/1.0/reviews/api/submit", self->server_uri);
-    g_autoptr(SoupMessage) message = soup_message_new ("POST", uri);
-
     g_autoptr(JsonBuilder) builder = json_builder_new ();
     json_builder_begin_object (builder);
     json_builder_set_member_name (builder, "user_hash");
@@ -466,15 +1005,9 @@ store_odrs_client_submit_async (StoreOdrsClient *self, const gchar *user_skey, c
     json_builder_set_member_name (builder, "rating");
     json_builder_add_int_value (builder, rating);
     json_builder_end_object (builder);
-    g_autoptr(JsonGenerator) generator = json_generator_new ();
     g_autoptr(JsonNode) root = json_builder_get_root (builder);
-    json_generator_set_root (generator, root);
-    gsize json_text_length;
-    g_autofree gchar *json_text = json_generator_to_data (generator, &json_text_length);
-    soup_message_set_request (message, "application/json; charset=utf-8", SOUP_MEMORY_COPY, json_text, json_text_length);
 
-    GTask *task = g_task_new (self, cancellable, callback, callback_data); // FIXME: Need to combine cancellables?
-    soup_session_send_async (self->soup_session, message, self->cancellable, submit_cb, task);
+    queue_feedback (self, "submit", root, cancellable, callback, callback_data);
 }
 
 gboolean
@@ -493,7 +1026,7 @@ store_odrs_client_upvote_async (StoreOdrsClient *self, const gchar *user_skey, c
     g_return_if_fail (STORE_IS_ODRS_CLIENT (self));
     g_return_if_fail (app_id != NULL);
 
-    send_feedback (self, "upvote", upvote_cb, user_skey, app_id, review_id, cancellable, callback, callback_data);
+    send_feedback (self, "upvote", user_skey, app_id, review_id, cancellable, callback, callback_data);
 }
 
 gboolean
@@ -512,7 +1045,7 @@ store_odrs_client_downvote_async (StoreOdrsClient *self, const gchar *user_skey,
     g_return_if_fail (STORE_IS_ODRS_CLIENT (self));
     g_return_if_fail (app_id != NULL);
 
-    send_feedback (self, "downvote", downvote_cb, user_skey, app_id, review_id, cancellable, callback, callback_data);
+    send_feedback (self, "downvote", user_skey, app_id, review_id, cancellable, callback, callback_data);
 }
 
 gboolean
@@ -531,7 +1064,7 @@ store_odrs_client_report_async (StoreOdrsClient *self, const gchar *user_skey, c
     g_return_if_fail (STORE_IS_ODRS_CLIENT (self));
     g_return_if_fail (app_id != NULL);
 
-    send_feedback (self, "report", report_cb, user_skey, app_id, review_id, cancellable, callback, callback_data);
+    send_feedback (self, "report", user_skey, app_id, review_id, cancellable, callback, callback_data);
 }
 
 gboolean
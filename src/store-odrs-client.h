@@ -11,6 +11,9 @@
 
 #include <gio/gio.h>
 
+#include "store-cache.h"
+#include "store-http.h"
+#include "store-odrs-ratings.h"
 #include "store-odrs-review.h"
 
 G_BEGIN_DECLS
@@ -19,6 +22,8 @@ G_DECLARE_FINAL_TYPE (StoreOdrsClient, store_odrs_client, STORE, ODRS_CLIENT, GO
 
 StoreOdrsClient *store_odrs_client_new                  (void);
 
+void             store_odrs_client_set_cache            (StoreOdrsClient *client, StoreCache *cache);
+
 void             store_odrs_client_set_server_uri       (StoreOdrsClient *client, const gchar *server_uri);
 
 const gchar     *store_odrs_client_get_server_uri       (StoreOdrsClient *client);
@@ -27,14 +32,20 @@ void             store_odrs_client_set_distro           (StoreOdrsClient *client
 
 void             store_odrs_client_set_locale           (StoreOdrsClient *client, const gchar *locale);
 
-gint64          *store_odrs_client_get_ratings          (StoreOdrsClient *client, const gchar *app_id);
+void             store_odrs_client_set_http             (StoreOdrsClient *client, StoreHttp *http);
+
+void             store_odrs_client_set_ratings_table    (StoreOdrsClient *client, StoreOdrsRatings *ratings);
+
+StoreOdrsRatings *store_odrs_client_get_ratings_table   (StoreOdrsClient *client);
+
+const guint32   *store_odrs_client_get_ratings          (StoreOdrsClient *client, const gchar *app_id);
 
 void             store_odrs_client_update_ratings_async (StoreOdrsClient *client,
                                                          GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data);
 
 gboolean         store_odrs_client_update_ratings_finish (StoreOdrsClient *client, GAsyncResult *result, GError **error);
 
-void             store_odrs_client_get_reviews_async    (StoreOdrsClient *client, const gchar *app_id, GStrv compat_ids, const gchar *version, gint64 limit,
+void             store_odrs_client_get_reviews_async    (StoreOdrsClient *client, const gchar *app_id, GStrv compat_ids, const gchar *version, gint64 start, gint64 limit,
                                                          GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data);
 
 GPtrArray       *store_odrs_client_get_reviews_finish   (StoreOdrsClient *client, GAsyncResult *result, gchar **user_skey, GError **error);
@@ -0,0 +1,603 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <string.h>
+
+#include "store-odrs-ratings.h"
+
+/* The ODRS ratings feed is a single object containing every app on the server:
+ * { "app-id": { "star0": 0, "star1": 2, ..., "star5": 10, "total": 12 }, ... }
+ * It is tokenized as it arrives and only the star counts are kept, in a table
+ * sorted by app ID with the IDs packed into one string pool. */
+
+typedef enum
+{
+    TOKEN_STATE_NONE,
+    TOKEN_STATE_STRING,
+    TOKEN_STATE_STRING_ESCAPE,
+    TOKEN_STATE_STRING_UNICODE,
+    TOKEN_STATE_NUMBER,
+    TOKEN_STATE_LITERAL
+} TokenState;
+
+typedef struct
+{
+    guint32 id_offset;
+    guint32 counts[5];
+} RatingsEntry;
+
+struct _StoreOdrsRatings
+{
+    GObject parent_instance;
+
+    /* Parser state, freed once complete */
+    GString *app_id;
+    gboolean capture;
+    GByteArray *containers;
+    guint32 counts[5];
+    GArray *entries;
+    gboolean expect_key;
+    gboolean have_root;
+    gboolean in_app;
+    GString *member;
+    GString *pool;
+    GString *token;
+    TokenState token_state;
+    gunichar unicode_high;
+    guint unicode_length;
+    gunichar unicode_value;
+
+    /* Completed table */
+    gchar *etag;
+    gchar *ids;
+    gsize ids_length;
+    gchar *last_modified;
+    guint n_ratings;
+    RatingsEntry *ratings;
+};
+
+/* Header of the cached table, followed by the ETag, Last-Modified, entries and IDs */
+#define CACHE_MAGIC "ODRSRAT1"
+typedef struct
+{
+    gchar magic[8];
+    guint32 etag_length;
+    guint32 last_modified_length;
+    guint32 n_ratings;
+    guint32 ids_length;
+} CacheHeader;
+
+G_DEFINE_TYPE (StoreOdrsRatings, store_odrs_ratings, G_TYPE_OBJECT)
+
+static gboolean
+parse_error (GError **error, const gchar *message)
+{
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Invalid ODRS ratings: %s", message);
+    return FALSE;
+}
+
+static guint
+get_depth (StoreOdrsRatings *self)
+{
+    return self->containers->len;
+}
+
+static gboolean
+in_object (StoreOdrsRatings *self)
+{
+    return self->containers->len > 0 && self->containers->data[self->containers->len - 1] == '{';
+}
+
+static void
+add_entry (StoreOdrsRatings *self)
+{
+    RatingsEntry entry;
+    entry.id_offset = self->pool->len;
+    memcpy (entry.counts, self->counts, sizeof (entry.counts));
+    g_string_append_len (self->pool, self->app_id->str, self->app_id->len + 1);
+    g_array_append_val (self->entries, entry);
+}
+
+static gboolean
+begin_container (StoreOdrsRatings *self, guint8 type, GError **error)
+{
+    if (get_depth (self) == 0) {
+        if (type != '{' || self->have_root)
+            return parse_error (error, "expected single object");
+        self->have_root = TRUE;
+    }
+    if (self->expect_key)
+        return parse_error (error, "expected member name");
+
+    /* Each member of the top level object is an app */
+    if (get_depth (self) == 1 && type == '{') {
+        self->in_app = TRUE;
+        memset (self->counts, 0, sizeof (self->counts));
+    }
+
+    g_byte_array_append (self->containers, &type, 1);
+    self->expect_key = type == '{';
+
+    return TRUE;
+}
+
+static gboolean
+end_container (StoreOdrsRatings *self, guint8 type, GError **error)
+{
+    if (get_depth (self) == 0 || self->containers->data[self->containers->len - 1] != type)
+        return parse_error (error, "mismatched brackets");
+
+    g_byte_array_set_size (self->containers, self->containers->len - 1);
+    self->expect_key = FALSE;
+
+    if (get_depth (self) == 1 && self->in_app) {
+        add_entry (self);
+        self->in_app = FALSE;
+    }
+
+    return TRUE;
+}
+
+static void
+end_string (StoreOdrsRatings *self)
+{
+    if (!self->expect_key)
+        return;
+    self->expect_key = FALSE;
+
+    if (get_depth (self) == 1)
+        g_string_assign (self->app_id, self->token->str);
+    else if (get_depth (self) == 2)
+        g_string_assign (self->member, self->token->str);
+}
+
+static gboolean
+end_number (StoreOdrsRatings *self, GError **error)
+{
+    if (get_depth (self) == 0)
+        return parse_error (error, "expected object");
+
+    /* star0 is ignored, it is the count of reviews without a rating */
+    if (!self->in_app || get_depth (self) != 2 ||
+        self->member->len != 5 || strncmp (self->member->str, "star", 4) != 0 ||
+        self->member->str[4] < '1' || self->member->str[4] > '5')
+        return TRUE;
+
+    gdouble value = g_ascii_strtod (self->token->str, NULL);
+    self->counts[self->member->str[4] - '1'] = value <= 0 ? 0 : value >= G_MAXUINT32 ? G_MAXUINT32 : (guint32) value;
+
+    return TRUE;
+}
+
+static gboolean
+end_literal (StoreOdrsRatings *self, GError **error)
+{
+    if (get_depth (self) == 0)
+        return parse_error (error, "expected object");
+
+    if (strcmp (self->token->str, "true") != 0 &&
+        strcmp (self->token->str, "false") != 0 &&
+        strcmp (self->token->str, "null") != 0)
+        return parse_error (error, "unknown literal");
+
+    return TRUE;
+}
+
+static void
+append_unicode (StoreOdrsRatings *self)
+{
+    gunichar c = self->unicode_value;
+
+    /* Combine UTF-16 surrogate pairs */
+    if (c >= 0xD800 && c <= 0xDBFF) {
+        self->unicode_high = c;
+        return;
+    }
+    if (c >= 0xDC00 && c <= 0xDFFF && self->unicode_high != 0)
+        c = 0x10000 + ((self->unicode_high - 0xD800) << 10) + (c - 0xDC00);
+    self->unicode_high = 0;
+
+    if (self->capture)
+        g_string_append_unichar (self->token, c);
+}
+
+static gboolean
+feed_char (StoreOdrsRatings *self, gchar c, GError **error)
+{
+    switch (self->token_state)
+    {
+    case TOKEN_STATE_STRING:
+        if (c == '"') {
+            self->token_state = TOKEN_STATE_NONE;
+            end_string (self);
+        }
+        else if (c == '\\')
+            self->token_state = TOKEN_STATE_STRING_ESCAPE;
+        else if (self->capture)
+            g_string_append_c (self->token, c);
+        return TRUE;
+
+    case TOKEN_STATE_STRING_ESCAPE:
+        self->token_state = TOKEN_STATE_STRING;
+        if (c == 'u') {
+            self->token_state = TOKEN_STATE_STRING_UNICODE;
+            self->unicode_length = 0;
+            self->unicode_value = 0;
+            return TRUE;
+        }
+        if (!self->capture)
+            return TRUE;
+        switch (c)
+        {
+        case 'b':
+            g_string_append_c (self->token, '\b');
+            break;
+        case 'f':
+            g_string_append_c (self->token, '\f');
+            break;
+        case 'n':
+            g_string_append_c (self->token, '\n');
+            break;
+        case 'r':
+            g_string_append_c (self->token, '\r');
+            break;
+        case 't':
+            g_string_append_c (self->token, '\t');
+            break;
+        default:
+            g_string_append_c (self->token, c);
+            break;
+        }
+        return TRUE;
+
+    case TOKEN_STATE_STRING_UNICODE:
+        if (!g_ascii_isxdigit (c))
+            return parse_error (error, "invalid unicode escape");
+        self->unicode_value = self->unicode_value << 4 | g_ascii_xdigit_value (c);
+        self->unicode_length++;
+        if (self->unicode_length == 4) {
+            self->token_state = TOKEN_STATE_STRING;
+            append_unicode (self);
+        }
+        return TRUE;
+
+    case TOKEN_STATE_NUMBER:
+        if (g_ascii_isdigit (c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+            g_string_append_c (self->token, c);
+            return TRUE;
+        }
+        self->token_state = TOKEN_STATE_NONE;
+        if (!end_number (self, error))
+            return FALSE;
+        break;
+
+    case TOKEN_STATE_LITERAL:
+        if (g_ascii_isalpha (c)) {
+            g_string_append_c (self->token, c);
+            return TRUE;
+        }
+        self->token_state = TOKEN_STATE_NONE;
+        if (!end_literal (self, error))
+            return FALSE;
+        break;
+
+    case TOKEN_STATE_NONE:
+        break;
+    }
+
+    /* Start of a new token */
+    switch (c)
+    {
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\r':
+        return TRUE;
+    case '{':
+    case '[':
+        return begin_container (self, c, error);
+    case '}':
+        return end_container (self, '{', error);
+    case ']':
+        return end_container (self, '[', error);
+    case ':':
+        if (!in_object (self))
+            return parse_error (error, "unexpected colon");
+        self->expect_key = FALSE;
+        return TRUE;
+    case ',':
+        if (get_depth (self) == 0)
+            return parse_error (error, "unexpected comma");
+        self->expect_key = in_object (self);
+        return TRUE;
+    case '"':
+        if (get_depth (self) == 0)
+            return parse_error (error, "expected object");
+        self->token_state = TOKEN_STATE_STRING;
+        self->unicode_high = 0;
+        /* Only app IDs and the members of each app are needed */
+        self->capture = self->expect_key && (get_depth (self) == 1 || (get_depth (self) == 2 && self->in_app));
+        g_string_truncate (self->token, 0);
+        return TRUE;
+    default:
+        if (self->expect_key)
+            return parse_error (error, "expected member name");
+        g_string_truncate (self->token, 0);
+        g_string_append_c (self->token, c);
+        if (g_ascii_isdigit (c) || c == '-')
+            self->token_state = TOKEN_STATE_NUMBER;
+        else if (g_ascii_isalpha (c))
+            self->token_state = TOKEN_STATE_LITERAL;
+        else
+            return parse_error (error, "unexpected character");
+        return TRUE;
+    }
+}
+
+static gint
+compare_entries (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    const gchar *pool = user_data;
+    const RatingsEntry *entry_a = a, *entry_b = b;
+    return strcmp (pool + entry_a->id_offset, pool + entry_b->id_offset);
+}
+
+static void
+clear_parser (StoreOdrsRatings *self)
+{
+    if (self->app_id != NULL)
+        g_string_free (self->app_id, TRUE);
+    self->app_id = NULL;
+    g_clear_pointer (&self->containers, g_byte_array_unref);
+    g_clear_pointer (&self->entries, g_array_unref);
+    if (self->member != NULL)
+        g_string_free (self->member, TRUE);
+    self->member = NULL;
+    if (self->pool != NULL)
+        g_string_free (self->pool, TRUE);
+    self->pool = NULL;
+    if (self->token != NULL)
+        g_string_free (self->token, TRUE);
+    self->token = NULL;
+}
+
+static void
+store_odrs_ratings_dispose (GObject *object)
+{
+    StoreOdrsRatings *self = STORE_ODRS_RATINGS (object);
+
+    clear_parser (self);
+    g_clear_pointer (&self->etag, g_free);
+    g_clear_pointer (&self->ids, g_free);
+    g_clear_pointer (&self->last_modified, g_free);
+    g_clear_pointer (&self->ratings, g_free);
+
+    G_OBJECT_CLASS (store_odrs_ratings_parent_class)->dispose (object);
+}
+
+static void
+store_odrs_ratings_class_init (StoreOdrsRatingsClass *klass)
+{
+    G_OBJECT_CLASS (klass)->dispose = store_odrs_ratings_dispose;
+}
+
+static void
+store_odrs_ratings_init (StoreOdrsRatings *self)
+{
+    self->app_id = g_string_new (NULL);
+    self->containers = g_byte_array_new ();
+    self->entries = g_array_new (FALSE, FALSE, sizeof (RatingsEntry));
+    self->member = g_string_new (NULL);
+    self->pool = g_string_new (NULL);
+    self->token = g_string_new (NULL);
+}
+
+StoreOdrsRatings *
+store_odrs_ratings_new (void)
+{
+    return g_object_new (store_odrs_ratings_get_type (), NULL);
+}
+
+StoreOdrsRatings *
+store_odrs_ratings_new_from_bytes (GBytes *data, GError **error)
+{
+    gsize length;
+    const gchar *contents = g_bytes_get_data (data, &length);
+
+    CacheHeader header;
+    if (length < sizeof (header)) {
+        parse_error (error, "truncated cache");
+        return NULL;
+    }
+    memcpy (&header, contents, sizeof (header));
+    if (memcmp (header.magic, CACHE_MAGIC, sizeof (header.magic)) != 0) {
+        parse_error (error, "unknown cache format");
+        return NULL;
+    }
+    gsize expected_length = sizeof (header) + (gsize) header.etag_length + header.last_modified_length + (gsize) header.n_ratings * sizeof (RatingsEntry) + header.ids_length;
+    if (length != expected_length) {
+        parse_error (error, "truncated cache");
+        return NULL;
+    }
+
+    g_autoptr(StoreOdrsRatings) self = store_odrs_ratings_new ();
+    clear_parser (self);
+
+    const gchar *offset = contents + sizeof (header);
+    if (header.etag_length > 0)
+        self->etag = g_strndup (offset, header.etag_length);
+    offset += header.etag_length;
+    if (header.last_modified_length > 0)
+        self->last_modified = g_strndup (offset, header.last_modified_length);
+    offset += header.last_modified_length;
+    self->n_ratings = header.n_ratings;
+    self->ratings = g_new (RatingsEntry, header.n_ratings);
+    memcpy (self->ratings, offset, header.n_ratings * sizeof (RatingsEntry));
+    offset += header.n_ratings * sizeof (RatingsEntry);
+    self->ids_length = header.ids_length;
+    self->ids = g_malloc (header.ids_length);
+    memcpy (self->ids, offset, header.ids_length);
+
+    /* Check every ID is inside the pool and terminated */
+    if (header.ids_length > 0 && self->ids[header.ids_length - 1] != '\0') {
+        parse_error (error, "corrupt cache");
+        return NULL;
+    }
+    for (guint i = 0; i < self->n_ratings; i++) {
+        if (self->ratings[i].id_offset >= header.ids_length) {
+            parse_error (error, "corrupt cache");
+            return NULL;
+        }
+    }
+
+    return g_steal_pointer (&self);
+}
+
+GBytes *
+store_odrs_ratings_to_bytes (StoreOdrsRatings *self)
+{
+    g_return_val_if_fail (STORE_IS_ODRS_RATINGS (self), NULL);
+
+    CacheHeader header;
+    memcpy (header.magic, CACHE_MAGIC, sizeof (header.magic));
+    header.etag_length = self->etag != NULL ? strlen (self->etag) : 0;
+    header.last_modified_length = self->last_modified != NULL ? strlen (self->last_modified) : 0;
+    header.n_ratings = self->n_ratings;
+    header.ids_length = self->ids_length;
+
+    GByteArray *data = g_byte_array_sized_new (sizeof (header) + header.etag_length + header.last_modified_length + self->n_ratings * sizeof (RatingsEntry) + self->ids_length);
+    g_byte_array_append (data, (const guint8 *) &header, sizeof (header));
+    g_byte_array_append (data, (const guint8 *) self->etag, header.etag_length);
+    g_byte_array_append (data, (const guint8 *) self->last_modified, header.last_modified_length);
+    g_byte_array_append (data, (const guint8 *) self->ratings, self->n_ratings * sizeof (RatingsEntry));
+    g_byte_array_append (data, (const guint8 *) self->ids, self->ids_length);
+
+    return g_byte_array_free_to_bytes (data);
+}
+
+gboolean
+store_odrs_ratings_feed (StoreOdrsRatings *self, const gchar *data, gsize length, GError **error)
+{
+    g_return_val_if_fail (STORE_IS_ODRS_RATINGS (self), FALSE);
+    g_return_val_if_fail (self->token != NULL, FALSE);
+
+    for (gsize i = 0; i < length; i++)
+        if (!feed_char (self, data[i], error))
+            return FALSE;
+
+    return TRUE;
+}
+
+gboolean
+store_odrs_ratings_complete (StoreOdrsRatings *self, GError **error)
+{
+    g_return_val_if_fail (STORE_IS_ODRS_RATINGS (self), FALSE);
+    g_return_val_if_fail (self->token != NULL, FALSE);
+
+    /* Flush any trailing token */
+    if (!feed_char (self, ' ', error))
+        return FALSE;
+    if (self->token_state != TOKEN_STATE_NONE || get_depth (self) != 0 || !self->have_root)
+        return parse_error (error, "unexpected end of data");
+
+    /* Sort by ID, the sort is stable so the last duplicate wins */
+    g_array_sort_with_data (self->entries, compare_entries, self->pool->str);
+    guint n_ratings = 0;
+    for (guint i = 0; i < self->entries->len; i++) {
+        if (i + 1 < self->entries->len && compare_entries (&g_array_index (self->entries, RatingsEntry, i), &g_array_index (self->entries, RatingsEntry, i + 1), self->pool->str) == 0)
+            continue;
+        g_array_index (self->entries, RatingsEntry, n_ratings) = g_array_index (self->entries, RatingsEntry, i);
+        n_ratings++;
+    }
+
+    /* Pack the IDs in sorted order so lookups walk memory in order */
+    gsize ids_length = 0;
+    for (guint i = 0; i < n_ratings; i++)
+        ids_length += strlen (self->pool->str + g_array_index (self->entries, RatingsEntry, i).id_offset) + 1;
+    g_clear_pointer (&self->ids, g_free);
+    g_clear_pointer (&self->ratings, g_free);
+    self->ids = g_malloc (ids_length);
+    self->ids_length = ids_length;
+    self->ratings = g_new (RatingsEntry, n_ratings);
+    self->n_ratings = n_ratings;
+    gsize offset = 0;
+    for (guint i = 0; i < n_ratings; i++) {
+        RatingsEntry *entry = &g_array_index (self->entries, RatingsEntry, i);
+        const gchar *id = self->pool->str + entry->id_offset;
+        gsize id_length = strlen (id) + 1;
+        memcpy (self->ids + offset, id, id_length);
+        self->ratings[i].id_offset = offset;
+        memcpy (self->ratings[i].counts, entry->counts, sizeof (entry->counts));
+        offset += id_length;
+    }
+
+    clear_parser (self);
+
+    return TRUE;
+}
+
+void
+store_odrs_ratings_set_etag (StoreOdrsRatings *self, const gchar *etag)
+{
+    g_return_if_fail (STORE_IS_ODRS_RATINGS (self));
+
+    g_free (self->etag);
+    self->etag = g_strdup (etag);
+}
+
+const gchar *
+store_odrs_ratings_get_etag (StoreOdrsRatings *self)
+{
+    g_return_val_if_fail (STORE_IS_ODRS_RATINGS (self), NULL);
+    return self->etag;
+}
+
+void
+store_odrs_ratings_set_last_modified (StoreOdrsRatings *self, const gchar *last_modified)
+{
+    g_return_if_fail (STORE_IS_ODRS_RATINGS (self));
+
+    g_free (self->last_modified);
+    self->last_modified = g_strdup (last_modified);
+}
+
+const gchar *
+store_odrs_ratings_get_last_modified (StoreOdrsRatings *self)
+{
+    g_return_val_if_fail (STORE_IS_ODRS_RATINGS (self), NULL);
+    return self->last_modified;
+}
+
+guint
+store_odrs_ratings_get_length (StoreOdrsRatings *self)
+{
+    g_return_val_if_fail (STORE_IS_ODRS_RATINGS (self), 0);
+    return self->n_ratings;
+}
+
+const guint32 *
+store_odrs_ratings_lookup (StoreOdrsRatings *self, const gchar *app_id)
+{
+    g_return_val_if_fail (STORE_IS_ODRS_RATINGS (self), NULL);
+    g_return_val_if_fail (app_id != NULL, NULL);
+
+    guint start = 0, end = self->n_ratings;
+    while (start < end) {
+        guint mid = start + (end - start) / 2;
+        gint cmp = strcmp (app_id, self->ids + self->ratings[mid].id_offset);
+        if (cmp == 0)
+            return self->ratings[mid].counts;
+        else if (cmp < 0)
+            end = mid;
+        else
+            start = mid + 1;
+    }
+
+    return NULL;
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+G_DECLARE_FINAL_TYPE (StoreOdrsRatings, store_odrs_ratings, STORE, ODRS_RATINGS, GObject)
+
+StoreOdrsRatings *store_odrs_ratings_new                (void);
+
+StoreOdrsRatings *store_odrs_ratings_new_from_bytes     (GBytes *data, GError **error);
+
+GBytes           *store_odrs_ratings_to_bytes           (StoreOdrsRatings *ratings);
+
+gboolean          store_odrs_ratings_feed               (StoreOdrsRatings *ratings, const gchar *data, gsize length, GError **error);
+
+gboolean          store_odrs_ratings_complete           (StoreOdrsRatings *ratings, GError **error);
+
+void              store_odrs_ratings_set_etag           (StoreOdrsRatings *ratings, const gchar *etag);
+
+const gchar      *store_odrs_ratings_get_etag           (StoreOdrsRatings *ratings);
+
+void              store_odrs_ratings_set_last_modified  (StoreOdrsRatings *ratings, const gchar *last_modified);
+
+const gchar      *store_odrs_ratings_get_last_modified  (StoreOdrsRatings *ratings);
+
+guint             store_odrs_ratings_get_length         (StoreOdrsRatings *ratings);
+
+const guint32    *store_odrs_ratings_lookup             (StoreOdrsRatings *ratings, const gchar *app_id);
+
+G_END_DECLS
@@ -201,6 +201,26 @@ store_odrs_review_to_json (StoreOdrsReview *self)
     return json_builder_get_root (builder);
 }
 
+gboolean
+store_odrs_review_equal (StoreOdrsReview *self, StoreOdrsReview *other)
+{
+    if (self == other)
+        return TRUE;
+    if (self == NULL || other == NULL)
+        return FALSE;
+
+    if (self->id != other->id ||
+        self->rating != other->rating ||
+        g_strcmp0 (self->author, other->author) != 0 ||
+        g_strcmp0 (self->summary, other->summary) != 0 ||
+        g_strcmp0 (self->description, other->description) != 0)
+        return FALSE;
+
+    if (self->date_created == NULL || other->date_created == NULL)
+        return self->date_created == other->date_created;
+    return g_date_time_equal (self->date_created, other->date_created);
+}
+
 void
 store_odrs_review_set_author (StoreOdrsReview *self, const gchar *author)
 {
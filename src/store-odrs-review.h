@@ -22,6 +22,8 @@ StoreOdrsReview *store_odrs_review_new_from_json    (JsonNode *node);
 
 JsonNode        *store_odrs_review_to_json          (StoreOdrsReview *app);
 
+gboolean         store_odrs_review_equal            (StoreOdrsReview *review, StoreOdrsReview *other);
+
 void             store_odrs_review_set_author       (StoreOdrsReview *review, const gchar *author);
 
 const gchar     *store_odrs_review_get_author       (StoreOdrsReview *review);
@@ -11,6 +11,7 @@
 
 typedef struct
 {
+    GCancellable *cancellable;
     StoreModel *model;
 } StorePagePrivate;
 
@@ -22,6 +23,8 @@ store_page_dispose (GObject *object)
     StorePage *self = STORE_PAGE (object);
     StorePagePrivate *priv = store_page_get_instance_private (self);
 
+    g_cancellable_cancel (priv->cancellable);
+    g_clear_object (&priv->cancellable);
     g_clear_object (&priv->model);
 
     G_OBJECT_CLASS (store_page_parent_class)->dispose (object);
@@ -44,8 +47,11 @@ store_page_class_init (StorePageClass *klass)
 }
 
 static void
-store_page_init (StorePage *self G_GNUC_UNUSED)
+store_page_init (StorePage *self)
 {
+    StorePagePrivate *priv = store_page_get_instance_private (self);
+
+    priv->cancellable = g_cancellable_new ();
 }
 
 void
@@ -65,3 +71,26 @@ store_page_get_model (StorePage *self)
 
     return priv->model;
 }
+
+/* Work done on behalf of this page should use this or a child of it */
+GCancellable *
+store_page_get_cancellable (StorePage *self)
+{
+    StorePagePrivate *priv = store_page_get_instance_private (self);
+
+    g_return_val_if_fail (STORE_IS_PAGE (self), NULL);
+
+    return priv->cancellable;
+}
+
+void
+store_page_cancel (StorePage *self)
+{
+    StorePagePrivate *priv = store_page_get_instance_private (self);
+
+    g_return_if_fail (STORE_IS_PAGE (self));
+
+    g_cancellable_cancel (priv->cancellable);
+    g_clear_object (&priv->cancellable);
+    priv->cancellable = g_cancellable_new ();
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "store-ready-source.h"
+
+static gboolean
+ready_source_dispatch (GSource *source G_GNUC_UNUSED, GSourceFunc callback, gpointer user_data)
+{
+    return callback (user_data);
+}
+
+static GSourceFuncs ready_source_funcs = { NULL, NULL, ready_source_dispatch, NULL, NULL, NULL };
+
+/* Creates a source on the default main context that only runs when its ready
+ * time is set with g_source_set_ready_time(). Unlike a timeout it can be moved
+ * earlier or later without being recreated. Free with g_source_destroy() and
+ * g_source_unref() */
+GSource *
+store_ready_source_new (GSourceFunc callback, gpointer user_data)
+{
+    g_return_val_if_fail (callback != NULL, NULL);
+
+    GSource *source = g_source_new (&ready_source_funcs, sizeof (GSource));
+    g_source_set_callback (source, callback, user_data, NULL);
+    g_source_set_ready_time (source, -1);
+    g_source_attach (source, g_main_context_default ());
+    return source;
+}
@@ -0,0 +1,354 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <gio/gunixsocketaddress.h>
+#include <glib/gstdio.h>
+#include <json-glib/json-glib.h>
+#include <string.h>
+
+#include "store-recorder.h"
+
+struct _StoreRecorder
+{
+    GObject parent_instance;
+
+    GMutex mutex;
+    gint64 origin_time;
+    GOutputStream *output;
+    gchar *proxy_dir;
+    GSocketService *proxy_service;
+    gchar *proxy_socket_path;
+    gchar *snapd_socket_path;
+};
+
+G_DEFINE_TYPE (StoreRecorder, store_recorder, G_TYPE_OBJECT)
+
+static void
+add_body_member (JsonBuilder *builder, const gchar *name, GBytes *body)
+{
+    if (body == NULL || g_bytes_get_size (body) == 0)
+        return;
+
+    gsize length;
+    const guchar *data = g_bytes_get_data (body, &length);
+    g_autofree gchar *text = g_base64_encode (data, length);
+    json_builder_set_member_name (builder, name);
+    json_builder_add_string_value (builder, text);
+}
+
+/* Lengths are recalculated when the response is replayed */
+static gboolean
+is_hop_header (const gchar *name)
+{
+    return g_ascii_strcasecmp (name, "Connection") == 0 ||
+           g_ascii_strcasecmp (name, "Content-Length") == 0 ||
+           g_ascii_strcasecmp (name, "Keep-Alive") == 0 ||
+           g_ascii_strcasecmp (name, "Transfer-Encoding") == 0;
+}
+
+static void
+write_header (const gchar *name, const gchar *value, gpointer user_data)
+{
+    GString *text = user_data;
+    if (!is_hop_header (name))
+        g_string_append_printf (text, "%s: %s\r\n", name, value);
+}
+
+/* Bodies are recorded after libsoup has decoded them */
+static void
+add_header_member (const gchar *name, const gchar *value, gpointer user_data)
+{
+    JsonBuilder *builder = user_data;
+    if (is_hop_header (name) || g_ascii_strcasecmp (name, "Content-Encoding") == 0)
+        return;
+    json_builder_set_member_name (builder, name);
+    json_builder_add_string_value (builder, value);
+}
+
+static GBytes *
+read_headers (GDataInputStream *stream, GError **error)
+{
+    g_autoptr(GString) text = g_string_new (NULL);
+    while (TRUE) {
+        g_autoptr(GError) read_error = NULL;
+        g_autofree gchar *line = g_data_input_stream_read_line (stream, NULL, NULL, &read_error);
+        if (line == NULL) {
+            if (read_error != NULL)
+                g_propagate_error (error, g_steal_pointer (&read_error));
+            else if (text->len > 0)
+                g_set_error (error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT, "Connection closed in headers");
+            return NULL;
+        }
+
+        g_string_append_printf (text, "%s\r\n", line);
+        if (line[0] == '\0')
+            break;
+    }
+
+    return g_string_free_to_bytes (g_steal_pointer (&text));
+}
+
+/* Sends a request from snapd-glib on to snapd and the response back, the
+ * upstream request is made with HTTP/1.0 so snapd closes the connection
+ * instead of chunking the response */
+static gboolean
+proxy_request (StoreRecorder *self, GDataInputStream *input, GOutputStream *output, GError **error)
+{
+    g_autoptr(GError) read_error = NULL;
+    g_autoptr(GBytes) request_header_text = read_headers (input, &read_error);
+    if (request_header_text == NULL) {
+        if (read_error != NULL)
+            g_propagate_error (error, g_steal_pointer (&read_error));
+        return FALSE;
+    }
+
+    gsize header_length;
+    const gchar *header_data = g_bytes_get_data (request_header_text, &header_length);
+    g_autoptr(SoupMessageHeaders) request_headers = soup_message_headers_new (SOUP_MESSAGE_HEADERS_REQUEST);
+    g_autofree gchar *method = NULL;
+    g_autofree gchar *target = NULL;
+    if (soup_headers_parse_request (header_data, header_length - 2, request_headers, &method, &target, NULL) != SOUP_STATUS_OK) {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Invalid request from snapd client");
+        return FALSE;
+    }
+    if (soup_message_headers_get_encoding (request_headers) == SOUP_ENCODING_CHUNKED) {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "Chunked requests not supported");
+        return FALSE;
+    }
+
+    goffset content_length = soup_message_headers_get_content_length (request_headers);
+    g_autofree guint8 *request_data = g_malloc (content_length);
+    gsize n_read;
+    if (!g_input_stream_read_all (G_INPUT_STREAM (input), request_data, content_length, &n_read, NULL, error))
+        return FALSE;
+    g_autoptr(GBytes) request_body = g_bytes_new_take (g_steal_pointer (&request_data), n_read);
+
+    gint64 start_time = g_get_monotonic_time ();
+
+    g_autoptr(GSocketClient) client = g_socket_client_new ();
+    g_autoptr(GSocketAddress) address = g_unix_socket_address_new (self->snapd_socket_path);
+    g_autoptr(GSocketConnection) connection = g_socket_client_connect (client, G_SOCKET_CONNECTABLE (address), NULL, error);
+    if (connection == NULL)
+        return FALSE;
+
+    g_autoptr(GString) upstream_headers = g_string_new (NULL);
+    g_string_append_printf (upstream_headers, "%s %s HTTP/1.0\r\n", method, target);
+    soup_message_headers_foreach (request_headers, write_header, upstream_headers);
+    g_string_append_printf (upstream_headers, "Content-Length: %zu\r\n\r\n", g_bytes_get_size (request_body));
+    GOutputStream *upstream_output = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+    if (!g_output_stream_write_all (upstream_output, upstream_headers->str, upstream_headers->len, NULL, NULL, error) ||
+        !g_output_stream_write_all (upstream_output, g_bytes_get_data (request_body, NULL), g_bytes_get_size (request_body), NULL, NULL, error))
+        return FALSE;
+
+    g_autoptr(GOutputStream) response_stream = g_memory_output_stream_new_resizable ();
+    if (g_output_stream_splice (response_stream, g_io_stream_get_input_stream (G_IO_STREAM (connection)),
+                                G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET, NULL, error) < 0)
+        return FALSE;
+    g_autoptr(GBytes) response = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (response_stream));
+
+    gint64 end_time = g_get_monotonic_time ();
+
+    gsize response_length;
+    const gchar *response_data = g_bytes_get_data (response, &response_length);
+    const gchar *header_end = response_length > 0 ? g_strstr_len (response_data, response_length, "\r\n\r\n") : NULL;
+    g_autoptr(SoupMessageHeaders) response_headers = soup_message_headers_new (SOUP_MESSAGE_HEADERS_RESPONSE);
+    guint status;
+    g_autofree gchar *reason = NULL;
+    if (header_end == NULL ||
+        !soup_headers_parse_response (response_data, header_end - response_data + 2, response_headers, NULL, &status, &reason)) {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Invalid response from snapd");
+        return FALSE;
+    }
+    gsize body_offset = header_end - response_data + 4;
+    g_autoptr(GBytes) response_body = g_bytes_new_from_bytes (response, body_offset, response_length - body_offset);
+
+    g_autoptr(GString) client_headers = g_string_new (NULL);
+    g_string_append_printf (client_headers, "HTTP/1.1 %u %s\r\n", status, reason);
+    soup_message_headers_foreach (response_headers, write_header, client_headers);
+    g_string_append_printf (client_headers, "Content-Length: %zu\r\n\r\n", g_bytes_get_size (response_body));
+    if (!g_output_stream_write_all (output, client_headers->str, client_headers->len, NULL, NULL, error) ||
+        !g_output_stream_write_all (output, g_bytes_get_data (response_body, NULL), g_bytes_get_size (response_body), NULL, NULL, error))
+        return FALSE;
+
+    g_auto(GStrv) target_parts = g_strsplit (target, "?", 2);
+    store_recorder_add (self, "snapd", method, NULL, target_parts[0], target_parts[1], request_body,
+                        status, response_headers, response_body, start_time, end_time);
+
+    return TRUE;
+}
+
+/* Runs in its own thread for each snapd-glib connection */
+static gboolean
+proxy_run_cb (StoreRecorder *self, GSocketConnection *connection)
+{
+    g_autoptr(GDataInputStream) input = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM (connection)));
+    g_data_input_stream_set_newline_type (input, G_DATA_STREAM_NEWLINE_TYPE_CR_LF);
+    g_filter_input_stream_set_close_base_stream (G_FILTER_INPUT_STREAM (input), FALSE);
+    GOutputStream *output = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+
+    g_autoptr(GError) error = NULL;
+    while (proxy_request (self, input, output, &error));
+    if (error != NULL)
+        g_warning ("Failed to proxy snapd request: %s", error->message);
+
+    return TRUE;
+}
+
+static void
+store_recorder_dispose (GObject *object)
+{
+    StoreRecorder *self = STORE_RECORDER (object);
+
+    if (self->proxy_service != NULL)
+        g_socket_service_stop (self->proxy_service);
+    g_clear_object (&self->proxy_service);
+    if (self->proxy_socket_path != NULL)
+        g_unlink (self->proxy_socket_path);
+    g_clear_pointer (&self->proxy_socket_path, g_free);
+    if (self->proxy_dir != NULL)
+        g_rmdir (self->proxy_dir);
+    g_clear_pointer (&self->proxy_dir, g_free);
+    g_clear_pointer (&self->snapd_socket_path, g_free);
+    if (self->output != NULL) {
+        g_autoptr(GError) error = NULL;
+        if (!g_output_stream_close (self->output, NULL, &error))
+            g_warning ("Failed to close recording: %s", error->message);
+    }
+    g_clear_object (&self->output);
+
+    G_OBJECT_CLASS (store_recorder_parent_class)->dispose (object);
+}
+
+static void
+store_recorder_finalize (GObject *object)
+{
+    StoreRecorder *self = STORE_RECORDER (object);
+
+    g_mutex_clear (&self->mutex);
+
+    G_OBJECT_CLASS (store_recorder_parent_class)->finalize (object);
+}
+
+static void
+store_recorder_class_init (StoreRecorderClass *klass)
+{
+    G_OBJECT_CLASS (klass)->dispose = store_recorder_dispose;
+    G_OBJECT_CLASS (klass)->finalize = store_recorder_finalize;
+}
+
+static void
+store_recorder_init (StoreRecorder *self)
+{
+    g_mutex_init (&self->mutex);
+    self->origin_time = g_get_monotonic_time ();
+}
+
+StoreRecorder *
+store_recorder_new (void)
+{
+    return g_object_new (store_recorder_get_type (), NULL);
+}
+
+/* Each exchange is written as a line of JSON, so a recording is usable even if snap-store doesn't exit cleanly */
+gboolean
+store_recorder_open (StoreRecorder *self, const gchar *path, GError **error)
+{
+    g_return_val_if_fail (STORE_IS_RECORDER (self), FALSE);
+
+    g_autoptr(GFile) file = g_file_new_for_path (path);
+    g_autoptr(GFileOutputStream) stream = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_NONE, NULL, error);
+    if (stream == NULL)
+        return FALSE;
+
+    g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->mutex);
+    g_set_object (&self->output, G_OUTPUT_STREAM (stream));
+    self->origin_time = g_get_monotonic_time ();
+
+    return TRUE;
+}
+
+/* Can be called from any thread */
+void
+store_recorder_add (StoreRecorder *self, const gchar *source, const gchar *method,
+                    const gchar *host, const gchar *path, const gchar *query, GBytes *request_body,
+                    guint status, SoupMessageHeaders *response_headers, GBytes *response_body,
+                    gint64 start_time, gint64 end_time)
+{
+    g_return_if_fail (STORE_IS_RECORDER (self));
+
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "source");
+    json_builder_add_string_value (builder, source);
+    json_builder_set_member_name (builder, "method");
+    json_builder_add_string_value (builder, method);
+    if (host != NULL) {
+        json_builder_set_member_name (builder, "host");
+        json_builder_add_string_value (builder, host);
+    }
+    json_builder_set_member_name (builder, "path");
+    json_builder_add_string_value (builder, path);
+    if (query != NULL) {
+        json_builder_set_member_name (builder, "query");
+        json_builder_add_string_value (builder, query);
+    }
+    add_body_member (builder, "request-body", request_body);
+    json_builder_set_member_name (builder, "start");
+    json_builder_add_int_value (builder, start_time - self->origin_time);
+    json_builder_set_member_name (builder, "duration");
+    json_builder_add_int_value (builder, end_time - start_time);
+    json_builder_set_member_name (builder, "status");
+    json_builder_add_int_value (builder, status);
+    json_builder_set_member_name (builder, "headers");
+    json_builder_begin_object (builder);
+    if (response_headers != NULL)
+        soup_message_headers_foreach (response_headers, add_header_member, builder);
+    json_builder_end_object (builder);
+    add_body_member (builder, "body", response_body);
+    json_builder_end_object (builder);
+
+    g_autoptr(JsonGenerator) generator = json_generator_new ();
+    g_autoptr(JsonNode) root = json_builder_get_root (builder);
+    json_generator_set_root (generator, root);
+    gsize length;
+    g_autofree gchar *text = json_generator_to_data (generator, &length);
+
+    g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->mutex);
+    if (self->output == NULL)
+        return;
+    g_autoptr(GError) error = NULL;
+    if (!g_output_stream_write_all (self->output, text, length, NULL, NULL, &error) ||
+        !g_output_stream_write_all (self->output, "\n", 1, NULL, NULL, &error))
+        g_warning ("Failed to write recording: %s", error->message);
+}
+
+/* snapd-glib has no hook to see requests, so it is pointed at a socket that
+ * passes them through to snapd. Returns the path to use in place of snapd's */
+const gchar *
+store_recorder_start_snapd_proxy (StoreRecorder *self, const gchar *snapd_socket_path, GError **error)
+{
+    g_return_val_if_fail (STORE_IS_RECORDER (self), NULL);
+    g_return_val_if_fail (self->proxy_service == NULL, NULL);
+
+    self->proxy_dir = g_dir_make_tmp ("snap-store-recorder-XXXXXX", error);
+    if (self->proxy_dir == NULL)
+        return NULL;
+    self->proxy_socket_path = g_build_filename (self->proxy_dir, "snapd.socket", NULL);
+    self->snapd_socket_path = g_strdup (snapd_socket_path);
+
+    self->proxy_service = g_threaded_socket_service_new (-1);
+    g_autoptr(GSocketAddress) address = g_unix_socket_address_new (self->proxy_socket_path);
+    if (!g_socket_listener_add_address (G_SOCKET_LISTENER (self->proxy_service), address,
+                                        G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT, NULL, NULL, error))
+        return NULL;
+    g_signal_connect_object (self->proxy_service, "run", G_CALLBACK (proxy_run_cb), self, G_CONNECT_SWAPPED);
+    g_socket_service_start (self->proxy_service);
+
+    return self->proxy_socket_path;
+}
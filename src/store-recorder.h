@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#pragma once
+
+#include <libsoup/soup.h>
+
+G_BEGIN_DECLS
+
+G_DECLARE_FINAL_TYPE (StoreRecorder, store_recorder, STORE, RECORDER, GObject)
+
+StoreRecorder *store_recorder_new               (void);
+
+gboolean       store_recorder_open              (StoreRecorder *recorder, const gchar *path, GError **error);
+
+void           store_recorder_add               (StoreRecorder *recorder, const gchar *source, const gchar *method,
+                                                 const gchar *host, const gchar *path, const gchar *query, GBytes *request_body,
+                                                 guint status, SoupMessageHeaders *response_headers, GBytes *response_body,
+                                                 gint64 start_time, gint64 end_time);
+
+const gchar   *store_recorder_start_snapd_proxy (StoreRecorder *recorder, const gchar *snapd_socket_path, GError **error);
+
+G_END_DECLS
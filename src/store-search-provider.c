@@ -0,0 +1,614 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <string.h>
+
+#include "store-search-provider.h"
+
+typedef struct
+{
+    gchar *name;
+    gchar *title;
+    gchar *summary;
+    gchar *icon_uri;
+    gchar *text;
+} SearchEntry;
+
+typedef struct
+{
+    GPtrArray *entries;
+    GHashTable *entries_by_name;
+} SearchIndex;
+
+struct _StoreSearchProvider
+{
+    GObject parent_instance;
+
+    StoreCache *cache;
+    GCancellable *cancellable;
+    GDBusConnection *connection;
+    SearchIndex *index;
+    gboolean indexing;
+    gint64 index_time;
+    GPtrArray *pending_invocations;
+    guint registration_id;
+};
+
+G_DEFINE_TYPE (StoreSearchProvider, store_search_provider, G_TYPE_OBJECT)
+
+enum
+{
+    SIGNAL_ACTIVATE_RESULT,
+    SIGNAL_LAUNCH_SEARCH,
+    SIGNAL_LAST
+};
+
+static guint signals[SIGNAL_LAST] = { 0, };
+
+/* How long the index is used before it is rebuilt in the background */
+#define INDEX_EXPIRY (5 * G_TIME_SPAN_MINUTE)
+
+static const gchar introspection_xml[] =
+    "<node>"
+    "  <interface name='org.gnome.Shell.SearchProvider2'>"
+    "    <method name='GetInitialResultSet'>"
+    "      <arg type='as' name='terms' direction='in'/>"
+    "      <arg type='as' name='results' direction='out'/>"
+    "    </method>"
+    "    <method name='GetSubsearchResultSet'>"
+    "      <arg type='as' name='previous_results' direction='in'/>"
+    "      <arg type='as' name='terms' direction='in'/>"
+    "      <arg type='as' name='results' direction='out'/>"
+    "    </method>"
+    "    <method name='GetResultMetas'>"
+    "      <arg type='as' name='identifiers' direction='in'/>"
+    "      <arg type='aa{sv}' name='metas' direction='out'/>"
+    "    </method>"
+    "    <method name='ActivateResult'>"
+    "      <arg type='s' name='identifier' direction='in'/>"
+    "      <arg type='as' name='terms' direction='in'/>"
+    "      <arg type='u' name='timestamp' direction='in'/>"
+    "    </method>"
+    "    <method name='LaunchSearch'>"
+    "      <arg type='as' name='terms' direction='in'/>"
+    "      <arg type='u' name='timestamp' direction='in'/>"
+    "    </method>"
+    "  </interface>"
+    "</node>";
+
+static SearchEntry *
+search_entry_new (const gchar *name, const gchar *title, const gchar *summary, const gchar *icon_uri)
+{
+    SearchEntry *entry = g_new0 (SearchEntry, 1);
+    entry->name = g_strdup (name);
+    entry->title = g_strdup (title);
+    entry->summary = g_strdup (summary);
+    entry->icon_uri = g_strdup (icon_uri);
+    return entry;
+}
+
+static void
+search_entry_free (SearchEntry *entry)
+{
+    g_clear_pointer (&entry->name, g_free);
+    g_clear_pointer (&entry->title, g_free);
+    g_clear_pointer (&entry->summary, g_free);
+    g_clear_pointer (&entry->icon_uri, g_free);
+    g_clear_pointer (&entry->text, g_free);
+    g_free (entry);
+}
+
+typedef struct
+{
+    StoreCache *cache;
+    GPtrArray *entries;
+} ResultMetasData;
+
+static ResultMetasData *
+result_metas_data_new (StoreCache *cache, GPtrArray *entries)
+{
+    ResultMetasData *data = g_new0 (ResultMetasData, 1);
+    if (cache != NULL)
+        data->cache = g_object_ref (cache);
+    data->entries = g_ptr_array_ref (entries);
+    return data;
+}
+
+static void
+result_metas_data_free (ResultMetasData *data)
+{
+    g_clear_object (&data->cache);
+    g_clear_pointer (&data->entries, g_ptr_array_unref);
+    g_free (data);
+}
+
+static SearchIndex *
+search_index_new (void)
+{
+    SearchIndex *index = g_new0 (SearchIndex, 1);
+    index->entries = g_ptr_array_new_with_free_func ((GDestroyNotify) search_entry_free);
+    index->entries_by_name = g_hash_table_new (g_str_hash, g_str_equal);
+    return index;
+}
+
+static void
+search_index_free (SearchIndex *index)
+{
+    g_clear_pointer (&index->entries_by_name, g_hash_table_unref);
+    g_clear_pointer (&index->entries, g_ptr_array_unref);
+    g_free (index);
+}
+
+static const gchar *
+get_string_member (JsonObject *object, const gchar *name)
+{
+    JsonNode *node = json_object_get_member (object, name);
+    if (node == NULL || !JSON_NODE_HOLDS_VALUE (node))
+        return NULL;
+    return json_node_get_string (node);
+}
+
+/* Runs in a worker thread, reads every snap in the cache */
+static void
+build_index_thread (GTask *task, gpointer source_object G_GNUC_UNUSED, gpointer task_data, GCancellable *cancellable)
+{
+    StoreCache *cache = task_data;
+
+    /* Nothing to search when running without a cache */
+    if (cache == NULL) {
+        g_task_return_pointer (task, search_index_new (), (GDestroyNotify) search_index_free);
+        return;
+    }
+
+    g_autoptr(GError) error = NULL;
+    g_auto(GStrv) names = store_cache_list (cache, "snaps", cancellable, &error);
+    if (names == NULL) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+
+    SearchIndex *index = search_index_new ();
+    for (int i = 0; names[i] != NULL; i++) {
+        g_autoptr(JsonNode) node = store_cache_lookup_json (cache, "snaps", names[i], FALSE, cancellable, NULL);
+        if (node == NULL || json_node_get_node_type (node) != JSON_NODE_OBJECT)
+            continue;
+        JsonObject *object = json_node_get_object (node);
+
+        const gchar *icon_uri = NULL;
+        JsonNode *icon = json_object_get_member (object, "icon");
+        if (icon != NULL && json_node_get_node_type (icon) == JSON_NODE_OBJECT)
+            icon_uri = get_string_member (json_node_get_object (icon), "uri");
+
+        SearchEntry *entry = search_entry_new (names[i], get_string_member (object, "title"), get_string_member (object, "summary"), icon_uri);
+        g_autofree gchar *text = g_strjoin (" ",
+                                            names[i],
+                                            entry->title != NULL ? entry->title : "",
+                                            entry->summary != NULL ? entry->summary : "",
+                                            get_string_member (object, "publisher") != NULL ? get_string_member (object, "publisher") : "",
+                                            NULL);
+        entry->text = g_utf8_casefold (text, -1);
+        g_ptr_array_add (index->entries, entry);
+        g_hash_table_insert (index->entries_by_name, entry->name, entry);
+    }
+
+    g_task_return_pointer (task, index, (GDestroyNotify) search_index_free);
+}
+
+static GStrv
+fold_terms (const gchar **terms)
+{
+    GStrv folded_terms = g_new0 (gchar *, g_strv_length ((GStrv) terms) + 1);
+    for (int i = 0; terms[i] != NULL; i++)
+        folded_terms[i] = g_utf8_casefold (terms[i], -1);
+    return folded_terms;
+}
+
+static gboolean
+entry_matches (SearchEntry *entry, GStrv terms)
+{
+    for (int i = 0; terms[i] != NULL; i++)
+        if (strstr (entry->text, terms[i]) == NULL)
+            return FALSE;
+    return TRUE;
+}
+
+static gboolean
+has_prefix (const gchar *value, const gchar *prefix)
+{
+    if (value == NULL || prefix == NULL)
+        return FALSE;
+
+    g_autofree gchar *folded_value = g_utf8_casefold (value, -1);
+    return g_str_has_prefix (folded_value, prefix);
+}
+
+/* Snaps named after the first term come first, then by title */
+static gint
+compare_results (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    SearchEntry *entry_a = *((SearchEntry **) a);
+    SearchEntry *entry_b = *((SearchEntry **) b);
+    const gchar *term = user_data;
+
+    gboolean prefix_a = has_prefix (entry_a->name, term) || has_prefix (entry_a->title, term);
+    gboolean prefix_b = has_prefix (entry_b->name, term) || has_prefix (entry_b->title, term);
+    if (prefix_a != prefix_b)
+        return prefix_a ? -1 : 1;
+
+    return g_utf8_collate (entry_a->title != NULL ? entry_a->title : entry_a->name,
+                           entry_b->title != NULL ? entry_b->title : entry_b->name);
+}
+
+/* Keep the application running until the reply is sent */
+static void
+hold (void)
+{
+    GApplication *application = g_application_get_default ();
+    if (application != NULL)
+        g_application_hold (application);
+}
+
+static void
+release (void)
+{
+    GApplication *application = g_application_get_default ();
+    if (application != NULL)
+        g_application_release (application);
+}
+
+static void
+return_value (GDBusMethodInvocation *invocation, GVariant *value)
+{
+    g_dbus_method_invocation_return_value (invocation, value);
+    release ();
+}
+
+static void
+return_error (GDBusMethodInvocation *invocation, GError *error)
+{
+    g_dbus_method_invocation_return_gerror (invocation, error);
+    release ();
+}
+
+static void
+return_result_set (GDBusMethodInvocation *invocation, GPtrArray *results)
+{
+    GVariantBuilder builder;
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("as"));
+    for (guint i = 0; i < results->len; i++) {
+        SearchEntry *entry = g_ptr_array_index (results, i);
+        g_variant_builder_add (&builder, "s", entry->name);
+    }
+
+    return_value (invocation, g_variant_new ("(as)", &builder));
+}
+
+static void
+get_initial_result_set (StoreSearchProvider *self, GDBusMethodInvocation *invocation)
+{
+    g_autofree const gchar **terms = NULL;
+    g_variant_get (g_dbus_method_invocation_get_parameters (invocation), "(^a&s)", &terms);
+    g_auto(GStrv) folded_terms = fold_terms (terms);
+
+    g_autoptr(GPtrArray) results = g_ptr_array_new ();
+    for (guint i = 0; i < self->index->entries->len; i++) {
+        SearchEntry *entry = g_ptr_array_index (self->index->entries, i);
+        if (entry_matches (entry, folded_terms))
+            g_ptr_array_add (results, entry);
+    }
+    g_ptr_array_sort_with_data (results, compare_results, folded_terms[0]);
+
+    return_result_set (invocation, results);
+}
+
+static void
+get_subsearch_result_set (StoreSearchProvider *self, GDBusMethodInvocation *invocation)
+{
+    g_autofree const gchar **previous_results = NULL;
+    g_autofree const gchar **terms = NULL;
+    g_variant_get (g_dbus_method_invocation_get_parameters (invocation), "(^a&s^a&s)", &previous_results, &terms);
+    g_auto(GStrv) folded_terms = fold_terms (terms);
+
+    /* The terms only get more specific, so filter what matched before and keep its order */
+    g_autoptr(GPtrArray) results = g_ptr_array_new ();
+    for (int i = 0; previous_results[i] != NULL; i++) {
+        SearchEntry *entry = g_hash_table_lookup (self->index->entries_by_name, previous_results[i]);
+        if (entry != NULL && entry_matches (entry, folded_terms))
+            g_ptr_array_add (results, entry);
+    }
+
+    return_result_set (invocation, results);
+}
+
+/* Runs in a worker thread, icons are read from the image cache */
+static void
+get_result_metas_thread (GTask *task, gpointer source_object G_GNUC_UNUSED, gpointer task_data, GCancellable *cancellable)
+{
+    ResultMetasData *data = task_data;
+    GPtrArray *entries = data->entries;
+
+    GVariantBuilder builder;
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+    for (guint i = 0; i < entries->len; i++) {
+        SearchEntry *entry = g_ptr_array_index (entries, i);
+
+        g_variant_builder_open (&builder, G_VARIANT_TYPE ("a{sv}"));
+        g_variant_builder_add (&builder, "{sv}", "id", g_variant_new_string (entry->name));
+        g_variant_builder_add (&builder, "{sv}", "name", g_variant_new_string (entry->title != NULL ? entry->title : entry->name));
+        if (entry->summary != NULL)
+            g_variant_builder_add (&builder, "{sv}", "description", g_variant_new_string (entry->summary));
+        g_autoptr(GBytes) icon_data = NULL;
+        if (data->cache != NULL && entry->icon_uri != NULL)
+            icon_data = store_cache_lookup_sync (data->cache, "images", entry->icon_uri, TRUE, cancellable, NULL);
+        g_autoptr(GIcon) icon = icon_data != NULL ? g_bytes_icon_new (icon_data) : g_themed_icon_new ("package-x-generic");
+        g_autoptr(GVariant) serialized_icon = g_icon_serialize (icon);
+        if (serialized_icon != NULL)
+            g_variant_builder_add (&builder, "{sv}", "icon", serialized_icon);
+        g_variant_builder_close (&builder);
+    }
+
+    g_task_return_pointer (task, g_variant_ref_sink (g_variant_new ("(aa{sv})", &builder)), (GDestroyNotify) g_variant_unref);
+}
+
+static void
+result_metas_cb (GObject *object G_GNUC_UNUSED, GAsyncResult *result, gpointer user_data)
+{
+    GDBusMethodInvocation *invocation = user_data;
+
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GVariant) metas = g_task_propagate_pointer (G_TASK (result), &error);
+    if (metas == NULL) {
+        return_error (invocation, error);
+        return;
+    }
+
+    return_value (invocation, metas);
+}
+
+static void
+get_result_metas (StoreSearchProvider *self, GDBusMethodInvocation *invocation)
+{
+    g_autofree const gchar **identifiers = NULL;
+    g_variant_get (g_dbus_method_invocation_get_parameters (invocation), "(^a&s)", &identifiers);
+
+    /* Copy so the index can be replaced while the icons load */
+    g_autoptr(GPtrArray) entries = g_ptr_array_new_with_free_func ((GDestroyNotify) search_entry_free);
+    for (int i = 0; identifiers[i] != NULL; i++) {
+        SearchEntry *entry = g_hash_table_lookup (self->index->entries_by_name, identifiers[i]);
+        if (entry != NULL)
+            g_ptr_array_add (entries, search_entry_new (entry->name, entry->title, entry->summary, entry->icon_uri));
+    }
+
+    /* The cache is referenced by the task in case it is replaced meanwhile */
+    g_autoptr(GTask) task = g_task_new (self, self->cancellable, result_metas_cb, invocation);
+    g_task_set_task_data (task, result_metas_data_new (self->cache, entries), (GDestroyNotify) result_metas_data_free);
+    g_task_run_in_thread (task, get_result_metas_thread);
+}
+
+static void
+activate_result (StoreSearchProvider *self, GDBusMethodInvocation *invocation)
+{
+    const gchar *identifier;
+    guint32 timestamp;
+    g_variant_get (g_dbus_method_invocation_get_parameters (invocation), "(&s^a&su)", &identifier, NULL, &timestamp);
+
+    g_signal_emit (self, signals[SIGNAL_ACTIVATE_RESULT], 0, identifier, timestamp);
+
+    return_value (invocation, NULL);
+}
+
+static void
+launch_search (StoreSearchProvider *self, GDBusMethodInvocation *invocation)
+{
+    g_autofree const gchar **terms = NULL;
+    guint32 timestamp;
+    g_variant_get (g_dbus_method_invocation_get_parameters (invocation), "(^a&su)", &terms, &timestamp);
+
+    g_autofree gchar *query = g_strjoinv (" ", (GStrv) terms);
+    g_signal_emit (self, signals[SIGNAL_LAUNCH_SEARCH], 0, query, timestamp);
+
+    return_value (invocation, NULL);
+}
+
+static void
+handle_method (StoreSearchProvider *self, GDBusMethodInvocation *invocation)
+{
+    const gchar *method_name = g_dbus_method_invocation_get_method_name (invocation);
+
+    if (strcmp (method_name, "GetInitialResultSet") == 0)
+        get_initial_result_set (self, invocation);
+    else if (strcmp (method_name, "GetSubsearchResultSet") == 0)
+        get_subsearch_result_set (self, invocation);
+    else if (strcmp (method_name, "GetResultMetas") == 0)
+        get_result_metas (self, invocation);
+    else if (strcmp (method_name, "ActivateResult") == 0)
+        activate_result (self, invocation);
+    else if (strcmp (method_name, "LaunchSearch") == 0)
+        launch_search (self, invocation);
+    else {
+        g_autoptr(GError) error = g_error_new (G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD, "Unknown method %s", method_name);
+        return_error (invocation, error);
+    }
+}
+
+static void
+index_cb (GObject *object, GAsyncResult *result, gpointer user_data G_GNUC_UNUSED)
+{
+    StoreSearchProvider *self = STORE_SEARCH_PROVIDER (object);
+
+    /* Cancelled builds have already been replaced */
+    g_autoptr(GError) error = NULL;
+    SearchIndex *index = g_task_propagate_pointer (G_TASK (result), &error);
+    if (index == NULL && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        return;
+    self->indexing = FALSE;
+
+    if (index == NULL) {
+        g_warning ("Failed to build search index: %s", error->message);
+        if (self->index == NULL)
+            index = search_index_new ();
+    }
+
+    if (index != NULL) {
+        g_clear_pointer (&self->index, search_index_free);
+        self->index = index;
+        self->index_time = g_get_monotonic_time ();
+    }
+
+    /* Answer the searches that came in while the index was being built */
+    g_autoptr(GPtrArray) pending_invocations = g_steal_pointer (&self->pending_invocations);
+    self->pending_invocations = g_ptr_array_new ();
+    for (guint i = 0; i < pending_invocations->len; i++)
+        handle_method (self, g_ptr_array_index (pending_invocations, i));
+}
+
+static void
+method_call_cb (GDBusConnection *connection G_GNUC_UNUSED, const gchar *sender G_GNUC_UNUSED,
+                const gchar *object_path G_GNUC_UNUSED, const gchar *interface_name G_GNUC_UNUSED, const gchar *method_name G_GNUC_UNUSED,
+                GVariant *parameters G_GNUC_UNUSED, GDBusMethodInvocation *invocation, gpointer user_data)
+{
+    StoreSearchProvider *self = user_data;
+
+    hold ();
+
+    /* Rebuild in the background once out of date, searches use the existing index meanwhile */
+    if (self->index == NULL || g_get_monotonic_time () - self->index_time > INDEX_EXPIRY)
+        store_search_provider_update_index (self);
+
+    if (self->index == NULL) {
+        g_ptr_array_add (self->pending_invocations, invocation);
+        return;
+    }
+
+    handle_method (self, invocation);
+}
+
+static const GDBusInterfaceVTable interface_vtable = { method_call_cb, NULL, NULL, { 0 } };
+
+static void
+store_search_provider_dispose (GObject *object)
+{
+    StoreSearchProvider *self = STORE_SEARCH_PROVIDER (object);
+
+    store_search_provider_unregister (self);
+    g_clear_object (&self->cache);
+    g_cancellable_cancel (self->cancellable);
+    g_clear_object (&self->cancellable);
+    g_clear_pointer (&self->index, search_index_free);
+    if (self->pending_invocations != NULL) {
+        g_autoptr(GError) error = g_error_new (G_IO_ERROR, G_IO_ERROR_CANCELLED, "Search provider closed");
+        for (guint i = 0; i < self->pending_invocations->len; i++)
+            return_error (g_ptr_array_index (self->pending_invocations, i), error);
+    }
+    g_clear_pointer (&self->pending_invocations, g_ptr_array_unref);
+
+    G_OBJECT_CLASS (store_search_provider_parent_class)->dispose (object);
+}
+
+static void
+store_search_provider_class_init (StoreSearchProviderClass *klass)
+{
+    G_OBJECT_CLASS (klass)->dispose = store_search_provider_dispose;
+
+    signals[SIGNAL_ACTIVATE_RESULT] = g_signal_new ("activate-result",
+                                                    G_TYPE_FROM_CLASS (G_OBJECT_CLASS (klass)),
+                                                    G_SIGNAL_RUN_LAST,
+                                                    0,
+                                                    NULL, NULL,
+                                                    NULL,
+                                                    G_TYPE_NONE,
+                                                    2, G_TYPE_STRING, G_TYPE_UINT);
+
+    signals[SIGNAL_LAUNCH_SEARCH] = g_signal_new ("launch-search",
+                                                  G_TYPE_FROM_CLASS (G_OBJECT_CLASS (klass)),
+                                                  G_SIGNAL_RUN_LAST,
+                                                  0,
+                                                  NULL, NULL,
+                                                  NULL,
+                                                  G_TYPE_NONE,
+                                                  2, G_TYPE_STRING, G_TYPE_UINT);
+}
+
+static void
+store_search_provider_init (StoreSearchProvider *self)
+{
+    self->cancellable = g_cancellable_new ();
+    self->pending_invocations = g_ptr_array_new ();
+}
+
+StoreSearchProvider *
+store_search_provider_new (void)
+{
+    return g_object_new (store_search_provider_get_type (), NULL);
+}
+
+/* With no cache set there are no results, e.g. when running with --no-cache */
+void
+store_search_provider_set_cache (StoreSearchProvider *self, StoreCache *cache)
+{
+    g_return_if_fail (STORE_IS_SEARCH_PROVIDER (self));
+
+    if (!g_set_object (&self->cache, cache))
+        return;
+
+    /* Don't use anything indexed from the old cache */
+    g_clear_pointer (&self->index, search_index_free);
+    if (self->indexing) {
+        self->indexing = FALSE;
+        g_cancellable_cancel (self->cancellable);
+        g_clear_object (&self->cancellable);
+        self->cancellable = g_cancellable_new ();
+    }
+    if (self->pending_invocations->len > 0)
+        store_search_provider_update_index (self);
+}
+
+gboolean
+store_search_provider_register (StoreSearchProvider *self, GDBusConnection *connection, const gchar *object_path, GError **error)
+{
+    g_return_val_if_fail (STORE_IS_SEARCH_PROVIDER (self), FALSE);
+
+    g_autoptr(GDBusNodeInfo) info = g_dbus_node_info_new_for_xml (introspection_xml, error);
+    if (info == NULL)
+        return FALSE;
+
+    self->registration_id = g_dbus_connection_register_object (connection, object_path, info->interfaces[0], &interface_vtable, self, NULL, error);
+    if (self->registration_id == 0)
+        return FALSE;
+    g_set_object (&self->connection, connection);
+
+    return TRUE;
+}
+
+void
+store_search_provider_unregister (StoreSearchProvider *self)
+{
+    g_return_if_fail (STORE_IS_SEARCH_PROVIDER (self));
+
+    if (self->registration_id != 0)
+        g_dbus_connection_unregister_object (self->connection, self->registration_id);
+    self->registration_id = 0;
+    g_clear_object (&self->connection);
+}
+
+/* Rebuilds the index from the snaps in the cache */
+void
+store_search_provider_update_index (StoreSearchProvider *self)
+{
+    g_return_if_fail (STORE_IS_SEARCH_PROVIDER (self));
+
+    if (self->indexing)
+        return;
+    self->indexing = TRUE;
+
+    g_autoptr(GTask) task = g_task_new (self, self->cancellable, index_cb, NULL);
+    if (self->cache != NULL)
+        g_task_set_task_data (task, g_object_ref (self->cache), g_object_unref);
+    g_task_run_in_thread (task, build_index_thread);
+}
@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include "store-cache.h"
+
+G_BEGIN_DECLS
+
+G_DECLARE_FINAL_TYPE (StoreSearchProvider, store_search_provider, STORE, SEARCH_PROVIDER, GObject)
+
+StoreSearchProvider *store_search_provider_new          (void);
+
+void                 store_search_provider_set_cache    (StoreSearchProvider *provider, StoreCache *cache);
+
+gboolean             store_search_provider_register     (StoreSearchProvider *provider, GDBusConnection *connection, const gchar *object_path, GError **error);
+
+void                 store_search_provider_unregister   (StoreSearchProvider *provider);
+
+void                 store_search_provider_update_index (StoreSearchProvider *provider);
+
+G_END_DECLS
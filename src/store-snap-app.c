@@ -142,7 +142,7 @@ store_snap_app_install_async (StoreApp *app, StoreChannel *channel G_GNUC_UNUSED
 
     g_autoptr(SnapdClient) client = snapd_client_new ();
     snapd_client_set_socket_path (client, self->snapd_socket_path);
-    GTask *task = g_task_new (app, cancellable, callback, callback_data); // FIXME: Need to combine cancellables?
+    GTask *task = g_task_new (app, cancellable, callback, callback_data);
     snapd_client_install2_async (client, SNAPD_INSTALL_FLAGS_NONE, store_app_get_name (app), NULL, NULL, NULL, NULL, cancellable, install_cb, task); // FIXME: channel
 }
 
@@ -168,7 +168,7 @@ store_snap_app_refresh_async (StoreApp *app, GCancellable *cancellable, GAsyncRe
 
     g_autoptr(SnapdClient) client = snapd_client_new ();
     snapd_client_set_socket_path (client, self->snapd_socket_path);
-    GTask *task = g_task_new (self, cancellable, callback, callback_data); // FIXME: Need to combine cancellables?
+    GTask *task = g_task_new (self, cancellable, callback, callback_data);
     snapd_client_find_async (client, SNAPD_FIND_FLAGS_MATCH_NAME, store_app_get_name (app), cancellable, find_cb, task);
 }
 
@@ -185,7 +185,7 @@ store_snap_app_remove_async (StoreApp *app, GCancellable *cancellable, GAsyncRea
 
     g_autoptr(SnapdClient) client = snapd_client_new ();
     snapd_client_set_socket_path (client, self->snapd_socket_path);
-    GTask *task = g_task_new (self, cancellable, callback, callback_data); // FIXME: Need to combine cancellables?
+    GTask *task = g_task_new (self, cancellable, callback, callback_data);
     snapd_client_remove_async (client, store_app_get_name (app), NULL, NULL, cancellable, remove_cb, task);
 }
 
@@ -257,13 +257,8 @@ store_snap_app_save_to_cache (StoreApp *self, StoreCache *cache)
 }
 
 static void
-store_snap_app_update_from_cache (StoreApp *self, StoreCache *cache)
+update_from_json (StoreApp *self, JsonNode *node)
 {
-    const gchar *name = store_app_get_name (STORE_APP (self));
-    g_autoptr(JsonNode) node = store_cache_lookup_json (cache, "snaps", name, FALSE, NULL, NULL);
-    if (node == NULL)
-        return;
-
     JsonObject *object = json_node_get_object (node);
     store_app_set_appstream_id (STORE_APP (self), json_object_get_string_member (object, "appstream-id")); // FIXME: Move common fields into StoreApp
     if (json_object_has_member (object, "banner")) {
@@ -306,6 +301,17 @@ store_snap_app_update_from_cache (StoreApp *self, StoreCache *cache)
         store_app_set_version (STORE_APP (self), json_object_get_string_member (object, "version"));
 }
 
+static void
+store_snap_app_update_from_cache (StoreApp *self, StoreCache *cache)
+{
+    const gchar *name = store_app_get_name (STORE_APP (self));
+    g_autoptr(JsonNode) node = store_cache_lookup_json (cache, "snaps", name, FALSE, NULL, NULL);
+    if (node == NULL)
+        return;
+
+    update_from_json (self, node);
+}
+
 static void
 store_snap_app_class_init (StoreSnapAppClass *klass)
 {
@@ -362,6 +368,9 @@ store_snap_app_update_from_search (StoreSnapApp *self, SnapdSnap *snap)
 {
     g_return_if_fail (STORE_IS_SNAP_APP (self));
 
+    /* Emit a single notify per changed property once all fields are updated */
+    g_object_freeze_notify (G_OBJECT (self));
+
     store_app_set_name (STORE_APP (self), snapd_snap_get_name (snap));
     if (snapd_snap_get_title (snap) != NULL)
         store_app_set_title (STORE_APP (self), snapd_snap_get_title (snap));
@@ -438,4 +447,18 @@ store_snap_app_update_from_search (StoreSnapApp *self, SnapdSnap *snap)
 
     g_autofree gchar *appstream_id = g_strdup_printf ("io.snapcraft.%s-%s", snapd_snap_get_name (snap), snapd_snap_get_id (snap));
     store_app_set_appstream_id (STORE_APP (self), appstream_id);
+
+    g_object_thaw_notify (G_OBJECT (self));
+}
+
+/* Update from a cache record that has already been read, e.g. on a worker thread */
+void
+store_snap_app_update_from_json (StoreSnapApp *self, JsonNode *node)
+{
+    g_return_if_fail (STORE_IS_SNAP_APP (self));
+    g_return_if_fail (node != NULL);
+
+    g_object_freeze_notify (G_OBJECT (self));
+    update_from_json (STORE_APP (self), node);
+    g_object_thaw_notify (G_OBJECT (self));
 }
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <json-glib/json-glib.h>
+#include <unistd.h>
+
+#include "store-trace.h"
+
+/* Startup only has a handful of phases, ignore anything past this */
+#define MAX_EVENTS 256
+
+typedef struct
+{
+    const gchar *name;
+    gint64 time;
+    gint64 duration;
+} TraceEvent;
+
+static StoreTraceMarkCallback mark_callback = NULL;
+static gpointer mark_callback_data = NULL;
+static gint64 origin_time = 0;
+static gchar *output_path = NULL;
+static TraceEvent events[MAX_EVENTS];
+static guint n_events = 0;
+
+static void
+add_event (const gchar *name, gint64 time, gint64 duration)
+{
+    if (output_path == NULL || n_events >= MAX_EVENTS)
+        return;
+
+    events[n_events].name = g_intern_string (name);
+    events[n_events].time = time;
+    events[n_events].duration = duration;
+    n_events++;
+}
+
+/* Call as early as possible, times are relative to this */
+void
+store_trace_init (void)
+{
+    origin_time = g_get_monotonic_time ();
+
+    const gchar *path = g_getenv ("SNAP_STORE_TRACE_STARTUP");
+    if (path != NULL && path[0] != '\0')
+        store_trace_set_output (path);
+}
+
+void
+store_trace_set_output (const gchar *path)
+{
+    g_free (output_path);
+    output_path = g_strdup (path);
+}
+
+gint64
+store_trace_begin (void)
+{
+    return g_get_monotonic_time ();
+}
+
+void
+store_trace_end (const gchar *name, gint64 start_time)
+{
+    add_event (name, start_time, g_get_monotonic_time () - start_time);
+}
+
+/* Only the first occurrence of each mark is recorded, e.g. first icon painted */
+void
+store_trace_mark (const gchar *name)
+{
+    if (mark_callback != NULL)
+        mark_callback (name, mark_callback_data);
+
+    if (output_path == NULL)
+        return;
+
+    const gchar *interned_name = g_intern_string (name);
+    for (guint i = 0; i < n_events; i++)
+        if (events[i].name == interned_name && events[i].duration < 0)
+            return;
+
+    add_event (interned_name, g_get_monotonic_time (), -1);
+}
+
+/* Called for every mark, even if not recording */
+void
+store_trace_set_mark_callback (StoreTraceMarkCallback callback, gpointer user_data)
+{
+    mark_callback = callback;
+    mark_callback_data = user_data;
+}
+
+/* Write in Chrome trace event format, viewable in chrome://tracing */
+gboolean
+store_trace_write (GError **error)
+{
+    if (output_path == NULL)
+        return TRUE;
+
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "traceEvents");
+    json_builder_begin_array (builder);
+    for (guint i = 0; i < n_events; i++) {
+        TraceEvent *event = &events[i];
+        json_builder_begin_object (builder);
+        json_builder_set_member_name (builder, "name");
+        json_builder_add_string_value (builder, event->name);
+        json_builder_set_member_name (builder, "ph");
+        json_builder_add_string_value (builder, event->duration >= 0 ? "X" : "i");
+        json_builder_set_member_name (builder, "ts");
+        json_builder_add_int_value (builder, event->time - origin_time);
+        if (event->duration >= 0) {
+            json_builder_set_member_name (builder, "dur");
+            json_builder_add_int_value (builder, event->duration);
+        }
+        else {
+            json_builder_set_member_name (builder, "s");
+            json_builder_add_string_value (builder, "g");
+        }
+        json_builder_set_member_name (builder, "pid");
+        json_builder_add_int_value (builder, getpid ());
+        json_builder_set_member_name (builder, "tid");
+        json_builder_add_int_value (builder, 1);
+        json_builder_end_object (builder);
+    }
+    json_builder_end_array (builder);
+    json_builder_set_member_name (builder, "displayTimeUnit");
+    json_builder_add_string_value (builder, "ms");
+    json_builder_end_object (builder);
+
+    g_autoptr(JsonGenerator) generator = json_generator_new ();
+    g_autoptr(JsonNode) root = json_builder_get_root (builder);
+    json_generator_set_root (generator, root);
+    json_generator_set_pretty (generator, TRUE);
+    return json_generator_to_file (generator, output_path, error);
+}
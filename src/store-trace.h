@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef void (*StoreTraceMarkCallback) (const gchar *name, gpointer user_data);
+
+void     store_trace_init       (void);
+
+void     store_trace_set_output (const gchar *path);
+
+gint64   store_trace_begin      (void);
+
+void     store_trace_end        (const gchar *name, gint64 start_time);
+
+void     store_trace_mark       (const gchar *name);
+
+void     store_trace_set_mark_callback (StoreTraceMarkCallback callback, gpointer user_data);
+
+gboolean store_trace_write      (GError **error);
+
+G_END_DECLS
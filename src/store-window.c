@@ -30,6 +30,7 @@ struct _StoreWindow
     StoreInstalledPage *installed_page;
     GtkStack *stack;
 
+    gulong event_hook;
     StoreModel *model;
     GList *page_stack;
 };
@@ -48,9 +49,20 @@ category_activated_cb (StoreWindow *self, StoreCategory *category)
     store_window_show_category (self, category);
 }
 
+static void
+close_page (StoreWindow *self)
+{
+    /* Stop anything still loading for the page being left */
+    GtkWidget *page = gtk_stack_get_visible_child (self->stack);
+    if (STORE_IS_PAGE (page))
+        store_page_cancel (STORE_PAGE (page));
+}
+
 static void
 back_button_clicked_cb (StoreWindow *self)
 {
+    close_page (self);
+
     GtkWidget *page = g_list_nth_data (self->page_stack, 0);
     if (page == NULL)
         page = GTK_WIDGET (self->home_page);
@@ -65,6 +77,9 @@ page_toggled_cb (StoreWindow *self, GtkToggleButton *button)
     if (!gtk_toggle_button_get_active (button))
         return;
 
+    if (self->page_stack != NULL)
+        close_page (self);
+
     if (button == self->home_button)
         gtk_stack_set_visible_child (self->stack, GTK_WIDGET (self->home_page));
     else if (button == self->categories_button)
@@ -82,11 +97,41 @@ page_toggled_cb (StoreWindow *self, GtkToggleButton *button)
         gtk_toggle_button_set_active (self->installed_button, FALSE);
 }
 
+/* Sees input to every widget, not just what propagates up to the window */
+static gboolean
+event_hook_cb (GSignalInvocationHint *hint G_GNUC_UNUSED, guint n_param_values G_GNUC_UNUSED, const GValue *param_values, gpointer user_data)
+{
+    StoreWindow *self = user_data;
+
+    GtkWidget *widget = g_value_get_object (&param_values[0]);
+    GdkEvent *event = g_value_get_boxed (&param_values[1]);
+    if (self->model == NULL || gtk_widget_get_toplevel (widget) != GTK_WIDGET (self))
+        return TRUE;
+
+    switch (event->type)
+    {
+    case GDK_BUTTON_PRESS:
+    case GDK_KEY_PRESS:
+    case GDK_SCROLL:
+    case GDK_TOUCH_BEGIN:
+        store_model_report_activity (self->model);
+        break;
+    default:
+        break;
+    }
+
+    return TRUE;
+}
+
 static void
 store_window_dispose (GObject *object)
 {
     StoreWindow *self = STORE_WINDOW (object);
 
+    if (self->event_hook != 0)
+        g_signal_remove_emission_hook (g_signal_lookup ("event", GTK_TYPE_WIDGET), self->event_hook);
+    self->event_hook = 0;
+
     g_clear_object (&self->model);
     g_clear_pointer (&self->page_stack, g_list_free);
 
@@ -127,6 +172,9 @@ store_window_init (StoreWindow *self)
     store_installed_page_get_type ();
     gtk_widget_init_template (GTK_WIDGET (self));
 
+    /* Background refreshes wait while the user is interacting */
+    self->event_hook = g_signal_add_emission_hook (g_signal_lookup ("event", GTK_TYPE_WIDGET), 0, event_hook_cb, self, NULL);
+
     gtk_window_set_default_size (GTK_WINDOW (self), 800, 600); // FIXME: Temp
 }
 
@@ -158,7 +206,6 @@ store_window_load (StoreWindow *self)
     g_return_if_fail (STORE_IS_WINDOW (self));
 
     store_home_page_load (self->home_page);
-    store_installed_page_load (self->installed_page);
 }
 
 void
@@ -173,6 +220,21 @@ store_window_show_app (StoreWindow *self, StoreApp *app)
     gtk_widget_show (GTK_WIDGET (self->back_button));
 }
 
+void
+store_window_search (StoreWindow *self, const gchar *query)
+{
+    g_return_if_fail (STORE_IS_WINDOW (self));
+
+    if (self->page_stack != NULL)
+        close_page (self);
+    g_clear_pointer (&self->page_stack, g_list_free);
+    gtk_widget_hide (GTK_WIDGET (self->back_button));
+    gtk_stack_set_visible_child (self->stack, GTK_WIDGET (self->home_page));
+    gtk_toggle_button_set_active (self->home_button, TRUE);
+
+    store_home_page_search (self->home_page, query);
+}
+
 void
 store_window_show_category (StoreWindow *self, StoreCategory *category)
 {
@@ -26,6 +26,8 @@ void         store_window_set_model     (StoreWindow *window, StoreModel *model)
 
 void         store_window_load          (StoreWindow *self);
 
+void         store_window_search        (StoreWindow *self, const gchar *query);
+
 void         store_window_show_app      (StoreWindow *self, StoreApp *app);
 
 void         store_window_show_category (StoreWindow *self, StoreCategory *category);
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+/* Counts heap allocations by wrapping the glibc allocator.
+ * Either link into a benchmark or LD_PRELOAD into a process and set
+ * ALLOC_COUNTER_OUTPUT to a file to write the total to on exit.
+ * Can't use GLib here as it allocates. */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "alloc-counter.h"
+
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t n_members, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+static unsigned long n_allocations = 0;
+
+static void
+count_allocation (void)
+{
+    __atomic_add_fetch (&n_allocations, 1, __ATOMIC_RELAXED);
+}
+
+void *
+malloc (size_t size)
+{
+    count_allocation ();
+    return __libc_malloc (size);
+}
+
+void *
+calloc (size_t n_members, size_t size)
+{
+    count_allocation ();
+    return __libc_calloc (n_members, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+    count_allocation ();
+    return __libc_realloc (ptr, size);
+}
+
+unsigned long
+alloc_counter_get_count (void)
+{
+    return __atomic_load_n (&n_allocations, __ATOMIC_RELAXED);
+}
+
+__attribute__((destructor)) static void
+write_count (void)
+{
+    const char *path = getenv ("ALLOC_COUNTER_OUTPUT");
+    if (path == NULL)
+        return;
+
+    FILE *file = fopen (path, "w");
+    if (file == NULL)
+        return;
+    fprintf (file, "%lu\n", alloc_counter_get_count ());
+    fclose (file);
+}
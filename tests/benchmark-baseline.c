@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <json-glib/json-glib.h>
+
+#include "benchmark-baseline.h"
+
+/* Reads the JSON lines printed by an earlier run, e.g. one built from the parent commit.
+ * Returns the results keyed by benchmark name */
+GHashTable *
+benchmark_baseline_load (const gchar *path, GError **error)
+{
+    g_autofree gchar *contents = NULL;
+    if (!g_file_get_contents (path, &contents, NULL, error))
+        return NULL;
+
+    GHashTable *baseline = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) json_object_unref);
+    g_auto(GStrv) lines = g_strsplit (contents, "\n", -1);
+    for (int i = 0; lines[i] != NULL; i++) {
+        if (lines[i][0] != '{')
+            continue;
+
+        g_autoptr(JsonParser) parser = json_parser_new ();
+        if (!json_parser_load_from_data (parser, lines[i], -1, NULL))
+            continue;
+        JsonNode *root = json_parser_get_root (parser);
+        if (!JSON_NODE_HOLDS_OBJECT (root))
+            continue;
+        JsonObject *object = json_node_get_object (root);
+        if (json_object_has_member (object, "benchmark"))
+            g_hash_table_insert (baseline, g_strdup (json_object_get_string_member (object, "benchmark")), json_object_ref (object));
+    }
+
+    return baseline;
+}
+
+/* Adds the earlier figures for @members to a result being printed, as "baseline-NAME" */
+void
+benchmark_baseline_append (GHashTable *baseline, const gchar *benchmark, const gchar * const *members, GString *text)
+{
+    JsonObject *before = baseline != NULL ? g_hash_table_lookup (baseline, benchmark) : NULL;
+    if (before == NULL)
+        return;
+
+    for (gsize i = 0; members[i] != NULL; i++) {
+        JsonNode *node = json_object_get_member (before, members[i]);
+        if (node == NULL || !JSON_NODE_HOLDS_VALUE (node))
+            continue;
+        if (json_node_get_value_type (node) == G_TYPE_INT64)
+            g_string_append_printf (text, ", \"baseline-%s\": %" G_GINT64_FORMAT, members[i], json_node_get_int (node));
+        else
+            g_string_append_printf (text, ", \"baseline-%s\": %.2f", members[i], json_node_get_double (node));
+    }
+}
@@ -0,0 +1,20 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+GHashTable *benchmark_baseline_load   (const gchar *path, GError **error);
+
+void        benchmark_baseline_append (GHashTable *baseline, const gchar *benchmark, const gchar * const *members, GString *text);
+
+G_END_DECLS
@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <glib/gi18n.h>
+#include <locale.h>
+#include <stdlib.h>
+
+#include <config.h>
+#include "store-application.h"
+#include "store-trace.h"
+#include "store-window.h"
+
+/* How far the scroll scenario moves each frame in pixels, and for at most how many frames */
+#define SCROLL_STEP 40
+#define SCROLL_FRAMES 600
+
+/* snap-store with a scenario driven on top of it, for e2e-benchmark.
+ * Progress is followed through the trace marks snap-store emits, so the
+ * application itself has no knowledge of the benchmark */
+
+typedef struct
+{
+    StoreApplication *application;
+    const gchar *scenario;
+    const gchar *arg;
+    const gchar *wait_mark;
+    gboolean scroll;
+    guint scroll_frames;
+} Benchmark;
+
+static void
+quit (Benchmark *benchmark)
+{
+    g_application_quit (G_APPLICATION (benchmark->application));
+}
+
+static StoreWindow *
+get_window (Benchmark *benchmark)
+{
+    return STORE_WINDOW (gtk_application_get_active_window (GTK_APPLICATION (benchmark->application)));
+}
+
+static void
+painted_cb (GdkFrameClock *clock, Benchmark *benchmark)
+{
+    g_signal_handlers_disconnect_by_func (clock, painted_cb, benchmark);
+
+    store_trace_mark ("benchmark-done");
+    quit (benchmark);
+}
+
+/* The scenario is complete once its result has been painted */
+static void
+finish (Benchmark *benchmark)
+{
+    benchmark->wait_mark = NULL;
+
+    GtkWidget *window = GTK_WIDGET (get_window (benchmark));
+    GdkFrameClock *clock = window != NULL ? gtk_widget_get_frame_clock (window) : NULL;
+    if (clock == NULL) {
+        store_trace_mark ("benchmark-done");
+        quit (benchmark);
+        return;
+    }
+
+    g_signal_connect (clock, "after-paint", G_CALLBACK (painted_cb), benchmark);
+    gtk_widget_queue_draw (window);
+}
+
+/* The scrolled window on the page being shown */
+static GtkScrolledWindow *
+find_scrolled_window (GtkWidget *widget)
+{
+    if (!gtk_widget_get_mapped (widget))
+        return NULL;
+    if (GTK_IS_SCROLLED_WINDOW (widget))
+        return GTK_SCROLLED_WINDOW (widget);
+    if (!GTK_IS_CONTAINER (widget))
+        return NULL;
+
+    g_autoptr(GList) children = gtk_container_get_children (GTK_CONTAINER (widget));
+    for (GList *link = children; link != NULL; link = link->next) {
+        GtkScrolledWindow *scrolled_window = find_scrolled_window (link->data);
+        if (scrolled_window != NULL)
+            return scrolled_window;
+    }
+
+    return NULL;
+}
+
+static gboolean
+scroll_cb (GtkWidget *widget, GdkFrameClock *clock G_GNUC_UNUSED, gpointer user_data)
+{
+    Benchmark *benchmark = user_data;
+
+    GtkAdjustment *adjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (widget));
+    gdouble end = gtk_adjustment_get_upper (adjustment) - gtk_adjustment_get_page_size (adjustment);
+    gdouble value = MIN (gtk_adjustment_get_value (adjustment) + SCROLL_STEP, end);
+    gtk_adjustment_set_value (adjustment, value);
+
+    benchmark->scroll_frames++;
+    if (value >= end || benchmark->scroll_frames >= SCROLL_FRAMES) {
+        finish (benchmark);
+        return G_SOURCE_REMOVE;
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+/* Scroll a step each frame, so the time taken goes up when frames take too long to draw */
+static void
+start_scroll (Benchmark *benchmark)
+{
+    benchmark->wait_mark = NULL;
+
+    GtkScrolledWindow *scrolled_window = find_scrolled_window (GTK_WIDGET (get_window (benchmark)));
+    if (scrolled_window == NULL) {
+        g_warning ("Nothing to scroll");
+        quit (benchmark);
+        return;
+    }
+
+    store_trace_mark ("benchmark-start");
+    gtk_widget_add_tick_callback (GTK_WIDGET (scrolled_window), scroll_cb, benchmark, NULL);
+}
+
+static StoreCategory *
+find_category (Benchmark *benchmark, const gchar *name)
+{
+    GPtrArray *categories = store_model_get_categories (store_application_get_model (benchmark->application));
+    for (guint i = 0; i < categories->len; i++) {
+        StoreCategory *category = g_ptr_array_index (categories, i);
+        if (g_strcmp0 (store_category_get_name (category), name) == 0)
+            return category;
+    }
+
+    return NULL;
+}
+
+static void
+show_category (Benchmark *benchmark)
+{
+    StoreCategory *category = find_category (benchmark, benchmark->arg);
+    if (category == NULL) {
+        g_warning ("Unknown category %s", benchmark->arg);
+        quit (benchmark);
+        return;
+    }
+
+    benchmark->wait_mark = "category-tiles";
+    store_window_show_category (get_window (benchmark), category);
+}
+
+/* Runs once the window is presented with the cached data loaded */
+static void
+run (Benchmark *benchmark)
+{
+    StoreModel *model = store_application_get_model (benchmark->application);
+
+    /* Started once the home page has categories, on a cold start they come from the refresh */
+    if (g_strcmp0 (benchmark->scenario, "start") == 0) {
+        if (store_model_get_categories (model)->len > 0)
+            finish (benchmark);
+        else
+            benchmark->wait_mark = "home-page-categories";
+        return;
+    }
+
+    /* Timed from when scrolling starts, once the category has been shown */
+    if (g_strcmp0 (benchmark->scenario, "scroll") == 0) {
+        benchmark->scroll = TRUE;
+        show_category (benchmark);
+        return;
+    }
+
+    store_trace_mark ("benchmark-start");
+    if (g_strcmp0 (benchmark->scenario, "search") == 0) {
+        benchmark->wait_mark = "search-results";
+        store_window_search (get_window (benchmark), benchmark->arg);
+    }
+    else if (g_strcmp0 (benchmark->scenario, "category") == 0)
+        show_category (benchmark);
+    else if (g_strcmp0 (benchmark->scenario, "app") == 0) {
+        benchmark->wait_mark = "app-refreshed";
+        g_autoptr(StoreSnapApp) app = store_model_get_snap (model, benchmark->arg);
+        store_window_show_app (get_window (benchmark), STORE_APP (app));
+    }
+    else {
+        g_warning ("Unknown benchmark scenario %s", benchmark->scenario);
+        quit (benchmark);
+    }
+}
+
+static void
+trace_mark_cb (const gchar *name, gpointer user_data)
+{
+    Benchmark *benchmark = user_data;
+
+    if (g_strcmp0 (name, "window-presented") == 0) {
+        run (benchmark);
+        return;
+    }
+
+    if (benchmark->wait_mark == NULL || g_strcmp0 (name, benchmark->wait_mark) != 0)
+        return;
+
+    if (benchmark->scroll)
+        start_scroll (benchmark);
+    else
+        finish (benchmark);
+}
+
+int
+main (int argc, char **argv)
+{
+    store_trace_init ();
+
+    setlocale (LC_ALL, "");
+
+    bindtextdomain (GETTEXT_PACKAGE, LOCALEDIR);
+    bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8");
+    textdomain (GETTEXT_PACKAGE);
+
+    /* Everything else is passed through to snap-store */
+    g_autofree gchar *scenario = NULL;
+    const GOptionEntry options[] = {
+        { "benchmark", 0, 0, G_OPTION_ARG_STRING, &scenario,
+          "Scenario to run, e.g. search=QUERY", "SCENARIO[=ARG]" },
+        { NULL }
+    };
+    g_autoptr(GOptionContext) context = g_option_context_new (NULL);
+    g_option_context_add_main_entries (context, options, NULL);
+    g_option_context_set_ignore_unknown_options (context, TRUE);
+    g_option_context_set_help_enabled (context, FALSE);
+    g_autoptr(GError) error = NULL;
+    if (!g_option_context_parse (context, &argc, &argv, &error)) {
+        g_printerr ("%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    if (scenario == NULL || scenario[0] == '\0') {
+        g_printerr ("Usage: %s --benchmark=SCENARIO[=ARG] [SNAP-STORE-OPTION...]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    g_autoptr(StoreApplication) application = store_application_new ();
+
+    g_auto(GStrv) tokens = g_strsplit (scenario, "=", 2);
+    Benchmark benchmark = { 0 };
+    benchmark.application = application;
+    benchmark.scenario = tokens[0];
+    benchmark.arg = tokens[1] != NULL ? tokens[1] : "";
+    store_trace_set_mark_callback (trace_mark_cb, &benchmark);
+
+    int status = g_application_run (G_APPLICATION (application), argc, argv);
+    store_trace_set_mark_callback (NULL, NULL);
+
+    return status;
+}
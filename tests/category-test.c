@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "store-category.h"
+
+#define N_APPS 26
+
+/* A list kept in step with a category by replaying its signals, as a view would */
+typedef struct
+{
+    StoreCategory *category;
+    GPtrArray *apps;
+    guint n_inserted;
+    guint n_moved;
+    guint n_removed;
+} Mirror;
+
+typedef struct
+{
+    GObject *apps[N_APPS];
+    Mirror mirror;
+} Fixture;
+
+static void
+app_inserted_cb (StoreCategory *category, guint position, Mirror *mirror)
+{
+    g_assert_cmpuint (position, <=, mirror->apps->len);
+    g_ptr_array_insert (mirror->apps, position, g_ptr_array_index (store_category_get_apps (category), position));
+    mirror->n_inserted++;
+}
+
+static void
+app_moved_cb (StoreCategory *category G_GNUC_UNUSED, guint from, guint to, Mirror *mirror)
+{
+    g_assert_cmpuint (from, <, mirror->apps->len);
+    g_assert_cmpuint (to, <, mirror->apps->len);
+    g_assert_cmpuint (from, !=, to);
+    gpointer app = g_ptr_array_index (mirror->apps, from);
+    g_ptr_array_remove_index (mirror->apps, from);
+    g_ptr_array_insert (mirror->apps, to, app);
+    mirror->n_moved++;
+}
+
+static void
+app_removed_cb (StoreCategory *category G_GNUC_UNUSED, guint position, Mirror *mirror)
+{
+    g_assert_cmpuint (position, <, mirror->apps->len);
+    g_ptr_array_remove_index (mirror->apps, position);
+    mirror->n_removed++;
+}
+
+static void
+fixture_set_up (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    for (int i = 0; i < N_APPS; i++)
+        fixture->apps[i] = g_object_new (G_TYPE_OBJECT, NULL);
+
+    fixture->mirror.category = store_category_new ();
+    fixture->mirror.apps = g_ptr_array_new ();
+    g_signal_connect (fixture->mirror.category, "app-inserted", G_CALLBACK (app_inserted_cb), &fixture->mirror);
+    g_signal_connect (fixture->mirror.category, "app-moved", G_CALLBACK (app_moved_cb), &fixture->mirror);
+    g_signal_connect (fixture->mirror.category, "app-removed", G_CALLBACK (app_removed_cb), &fixture->mirror);
+}
+
+static void
+fixture_tear_down (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    g_clear_object (&fixture->mirror.category);
+    g_clear_pointer (&fixture->mirror.apps, g_ptr_array_unref);
+    for (int i = 0; i < N_APPS; i++)
+        g_clear_object (&fixture->apps[i]);
+}
+
+/* Apps from a string of letters, "abc" is the first three apps */
+static GPtrArray *
+make_apps (Fixture *fixture, const gchar *names)
+{
+    GPtrArray *apps = g_ptr_array_new_with_free_func (g_object_unref);
+    for (const gchar *c = names; *c != '\0'; c++) {
+        g_assert_cmpint (*c - 'a', <, N_APPS);
+        g_ptr_array_add (apps, g_object_ref (fixture->apps[*c - 'a']));
+    }
+    return apps;
+}
+
+static void
+assert_apps (GPtrArray *apps, GPtrArray *expected)
+{
+    g_assert_cmpuint (apps->len, ==, expected->len);
+    for (guint i = 0; i < apps->len; i++)
+        g_assert_true (g_ptr_array_index (apps, i) == g_ptr_array_index (expected, i));
+}
+
+/* Sets the apps, checks the mirror ends up the same and returns how many moves it took */
+static guint
+set_apps (Fixture *fixture, GPtrArray *apps)
+{
+    fixture->mirror.n_inserted = fixture->mirror.n_moved = fixture->mirror.n_removed = 0;
+    store_category_set_apps (fixture->mirror.category, apps);
+    assert_apps (store_category_get_apps (fixture->mirror.category), apps);
+    assert_apps (fixture->mirror.apps, apps);
+    return fixture->mirror.n_moved;
+}
+
+static void
+set_names (Fixture *fixture, const gchar *names)
+{
+    g_autoptr(GPtrArray) apps = make_apps (fixture, names);
+    set_apps (fixture, apps);
+}
+
+static void
+test_initial (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    set_names (fixture, "abc");
+    g_assert_cmpuint (fixture->mirror.n_inserted, ==, 3);
+    g_assert_cmpuint (fixture->mirror.n_moved, ==, 0);
+    g_assert_cmpuint (fixture->mirror.n_removed, ==, 0);
+}
+
+static void
+test_unchanged (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    set_names (fixture, "abcde");
+
+    /* A different array with the same apps changes nothing */
+    set_names (fixture, "abcde");
+    g_assert_cmpuint (fixture->mirror.n_inserted, ==, 0);
+    g_assert_cmpuint (fixture->mirror.n_moved, ==, 0);
+    g_assert_cmpuint (fixture->mirror.n_removed, ==, 0);
+}
+
+static void
+test_clear (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    set_names (fixture, "abcde");
+
+    store_category_set_apps (fixture->mirror.category, NULL);
+    g_assert_cmpuint (store_category_get_apps (fixture->mirror.category)->len, ==, 0);
+    g_assert_cmpuint (fixture->mirror.apps->len, ==, 0);
+}
+
+static void
+test_insert_remove (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    set_names (fixture, "abcd");
+
+    /* Apps that keep their order aren't moved */
+    set_names (fixture, "xbdy");
+    g_assert_cmpuint (fixture->mirror.n_inserted, ==, 2);
+    g_assert_cmpuint (fixture->mirror.n_moved, ==, 0);
+    g_assert_cmpuint (fixture->mirror.n_removed, ==, 2);
+}
+
+static void
+test_move (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    set_names (fixture, "abcdefgh");
+
+    /* Only the app that changed position moves, not the ones it passes */
+    set_names (fixture, "bcdefaght");
+    g_assert_cmpuint (fixture->mirror.n_inserted, ==, 1);
+    g_assert_cmpuint (fixture->mirror.n_moved, ==, 1);
+    g_assert_cmpuint (fixture->mirror.n_removed, ==, 0);
+
+    set_names (fixture, "hbcdefagt");
+    g_assert_cmpuint (fixture->mirror.n_moved, ==, 1);
+}
+
+static void
+test_reverse (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    set_names (fixture, "abcdef");
+
+    /* All but one have to move */
+    set_names (fixture, "fedcba");
+    g_assert_cmpuint (fixture->mirror.n_moved, ==, 5);
+}
+
+static void
+test_duplicates (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    set_names (fixture, "abc");
+
+    /* Can't be diffed, but still has to end up right */
+    set_names (fixture, "abca");
+    set_names (fixture, "cab");
+}
+
+/* Longest increasing run of old positions in the new list, the most apps that can stay where they are */
+static guint
+count_stationary (GPtrArray *old_apps, GPtrArray *new_apps)
+{
+    g_autoptr(GArray) positions = g_array_new (FALSE, FALSE, sizeof (guint));
+    for (guint i = 0; i < new_apps->len; i++) {
+        guint position;
+        if (g_ptr_array_find (old_apps, g_ptr_array_index (new_apps, i), &position))
+            g_array_append_val (positions, position);
+    }
+
+    g_autofree guint *lengths = g_new0 (guint, positions->len + 1);
+    guint longest = 0;
+    for (guint i = 0; i < positions->len; i++) {
+        lengths[i] = 1;
+        for (guint j = 0; j < i; j++) {
+            if (g_array_index (positions, guint, j) < g_array_index (positions, guint, i))
+                lengths[i] = MAX (lengths[i], lengths[j] + 1);
+        }
+        longest = MAX (longest, lengths[i]);
+    }
+
+    return longest;
+}
+
+static void
+test_random (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    for (int iteration = 0; iteration < 1000; iteration++) {
+        /* A random selection of the apps in a random order */
+        g_autoptr(GPtrArray) apps = g_ptr_array_new_with_free_func (g_object_unref);
+        for (int i = 0; i < N_APPS; i++) {
+            if (g_test_rand_bit ())
+                g_ptr_array_insert (apps, g_test_rand_int_range (0, apps->len + 1), g_object_ref (fixture->apps[i]));
+        }
+
+        g_autoptr(GPtrArray) old_apps = g_ptr_array_new ();
+        GPtrArray *current_apps = store_category_get_apps (fixture->mirror.category);
+        for (guint i = 0; i < current_apps->len; i++)
+            g_ptr_array_add (old_apps, g_ptr_array_index (current_apps, i));
+        guint n_moved = set_apps (fixture, apps);
+
+        /* Every app that moved had to */
+        guint n_common = apps->len - fixture->mirror.n_inserted;
+        g_assert_cmpuint (n_moved, ==, n_common - count_stationary (old_apps, apps));
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add ("/category/initial", Fixture, NULL, fixture_set_up, test_initial, fixture_tear_down);
+    g_test_add ("/category/unchanged", Fixture, NULL, fixture_set_up, test_unchanged, fixture_tear_down);
+    g_test_add ("/category/clear", Fixture, NULL, fixture_set_up, test_clear, fixture_tear_down);
+    g_test_add ("/category/insert-remove", Fixture, NULL, fixture_set_up, test_insert_remove, fixture_tear_down);
+    g_test_add ("/category/move", Fixture, NULL, fixture_set_up, test_move, fixture_tear_down);
+    g_test_add ("/category/reverse", Fixture, NULL, fixture_set_up, test_reverse, fixture_tear_down);
+    g_test_add ("/category/duplicates", Fixture, NULL, fixture_set_up, test_duplicates, fixture_tear_down);
+    g_test_add ("/category/random", Fixture, NULL, fixture_set_up, test_random, fixture_tear_down);
+
+    return g_test_run ();
+}
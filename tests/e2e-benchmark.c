@@ -0,0 +1,336 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <json-glib/json-glib.h>
+
+#include "benchmark-baseline.h"
+#include "mock-catalog.h"
+
+/* Longest a scenario can take before snap-store is considered hung */
+#define SCENARIO_TIMEOUT (60 * G_TIME_SPAN_SECOND)
+
+/* Broadway display to run on, chosen to not clash with a desktop session */
+#define BROADWAY_DISPLAY 42
+
+/* Exit code meson treats as skipped */
+#define EXIT_SKIP 77
+
+typedef struct
+{
+    const gchar *name;
+    const gchar *scenario;
+    gboolean clear_cache;
+} Scenario;
+
+/* Run in order, later scenarios use the cache the earlier ones filled.
+ * The app scenario opens the most popular snap in the generated catalog */
+static const Scenario scenarios[] = {
+    { "cold-start", "start", TRUE },
+    { "warm-start", "start", FALSE },
+    { "search", "search=editor", FALSE },
+    { "category-open", "category=development", FALSE },
+    { "app-page-open", "app", FALSE },
+    { "category-scroll", "scroll=development", FALSE },
+};
+
+static gchar *snap_store_path = NULL;
+static gchar *alloc_counter_path = NULL;
+static gchar **snapd_args = NULL;
+static gchar **odrs_args = NULL;
+static gchar *temp_dir = NULL;
+static gchar **environment = NULL;
+
+/* Results of an earlier run, keyed by scenario name */
+static GHashTable *baseline = NULL;
+
+static void
+remove_directory (const gchar *path)
+{
+    g_autoptr(GDir) dir = g_dir_open (path, 0, NULL);
+    if (dir == NULL)
+        return;
+
+    const gchar *name;
+    while ((name = g_dir_read_name (dir)) != NULL) {
+        g_autofree gchar *child_path = g_build_filename (path, name, NULL);
+        if (g_file_test (child_path, G_FILE_TEST_IS_DIR) && !g_file_test (child_path, G_FILE_TEST_IS_SYMLINK))
+            remove_directory (child_path);
+        else
+            g_unlink (child_path);
+    }
+    g_rmdir (path);
+}
+
+/* Start a mock and read the line it prints once it is ready */
+static GSubprocess *
+start_mock (const gchar *path, gchar **args, const gchar *prefix, gchar **value, GError **error)
+{
+    g_autoptr(GPtrArray) argv = g_ptr_array_new ();
+    g_ptr_array_add (argv, (gpointer) path);
+    for (int i = 0; args != NULL && args[i] != NULL; i++)
+        g_ptr_array_add (argv, args[i]);
+    g_ptr_array_add (argv, NULL);
+    g_autoptr(GSubprocess) subprocess = g_subprocess_newv ((const gchar * const *) argv->pdata, G_SUBPROCESS_FLAGS_STDERR_PIPE, error);
+    if (subprocess == NULL)
+        return NULL;
+
+    g_autoptr(GDataInputStream) stream = g_data_input_stream_new (g_subprocess_get_stderr_pipe (subprocess));
+    g_filter_input_stream_set_close_base_stream (G_FILTER_INPUT_STREAM (stream), FALSE);
+    while (TRUE) {
+        g_autofree gchar *line = g_data_input_stream_read_line_utf8 (stream, NULL, NULL, error);
+        if (line == NULL) {
+            if (error != NULL && *error == NULL)
+                g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "%s exited before it was ready", path);
+            return NULL;
+        }
+        if (g_str_has_prefix (line, prefix)) {
+            *value = g_strdup (line + strlen (prefix));
+            return g_steal_pointer (&subprocess);
+        }
+    }
+}
+
+/* Use a private Broadway display so no windows appear and results don't depend on the desktop */
+static GSubprocess *
+start_display (GError **error)
+{
+    g_autofree gchar *display = g_strdup_printf (":%d", BROADWAY_DISPLAY);
+    g_autoptr(GSubprocess) subprocess = g_subprocess_new (G_SUBPROCESS_FLAGS_STDOUT_SILENCE | G_SUBPROCESS_FLAGS_STDERR_SILENCE, error, "broadwayd", display, NULL);
+    if (subprocess == NULL)
+        return NULL;
+
+    /* Wait for the socket GTK connects to */
+    g_autofree gchar *socket_name = g_strdup_printf ("broadway%d.socket", BROADWAY_DISPLAY + 1);
+    g_autofree gchar *socket_path = g_build_filename (g_get_user_runtime_dir (), socket_name, NULL);
+    for (int i = 0; i < 500 && !g_file_test (socket_path, G_FILE_TEST_EXISTS); i++)
+        g_usleep (10000);
+
+    environment = g_environ_setenv (environment, "GDK_BACKEND", "broadway", TRUE);
+    environment = g_environ_setenv (environment, "BROADWAY_DISPLAY", display, TRUE);
+
+    return g_steal_pointer (&subprocess);
+}
+
+static gint64
+timeval_to_ns (struct timeval *value)
+{
+    return (gint64) value->tv_sec * 1000000000 + (gint64) value->tv_usec * 1000;
+}
+
+static gint64
+get_mark_time (JsonArray *events, const gchar *name)
+{
+    for (guint i = 0; i < json_array_get_length (events); i++) {
+        JsonObject *event = json_array_get_object_element (events, i);
+        if (g_strcmp0 (json_object_get_string_member (event, "name"), name) == 0)
+            return json_object_get_int_member (event, "ts");
+    }
+
+    return -1;
+}
+
+/* Time from the scenario starting (or the process starting) to its result being painted */
+static gint64
+get_scenario_time (const gchar *trace_path)
+{
+    g_autoptr(JsonParser) parser = json_parser_new ();
+    if (!json_parser_load_from_file (parser, trace_path, NULL))
+        return -1;
+    JsonNode *root = json_parser_get_root (parser);
+    if (root == NULL || json_node_get_node_type (root) != JSON_NODE_OBJECT)
+        return -1;
+    JsonArray *events = json_object_get_array_member (json_node_get_object (root), "traceEvents");
+    if (events == NULL)
+        return -1;
+
+    gint64 done_time = get_mark_time (events, "benchmark-done");
+    if (done_time < 0)
+        return -1;
+    gint64 start_time = get_mark_time (events, "benchmark-start");
+
+    return (done_time - MAX (start_time, 0)) * 1000;
+}
+
+static gint64
+get_allocations (const gchar *path)
+{
+    g_autofree gchar *contents = NULL;
+    if (!g_file_get_contents (path, &contents, NULL, NULL))
+        return -1;
+    return g_ascii_strtoll (contents, NULL, 10);
+}
+
+static gboolean
+run_scenario (const Scenario *scenario, const gchar *snapd_socket_path, const gchar *odrs_uri)
+{
+    g_autofree gchar *cache_dir = g_build_filename (temp_dir, "cache", NULL);
+    if (scenario->clear_cache)
+        remove_directory (cache_dir);
+
+    g_autofree gchar *trace_path = g_build_filename (temp_dir, "trace.json", NULL);
+    g_autofree gchar *allocations_path = g_build_filename (temp_dir, "allocations", NULL);
+    g_unlink (trace_path);
+    g_unlink (allocations_path);
+
+    g_auto(GStrv) envp = g_strdupv (environment);
+    envp = g_environ_setenv (envp, "XDG_CACHE_HOME", cache_dir, TRUE);
+    if (alloc_counter_path != NULL) {
+        envp = g_environ_setenv (envp, "LD_PRELOAD", alloc_counter_path, TRUE);
+        envp = g_environ_setenv (envp, "ALLOC_COUNTER_OUTPUT", allocations_path, TRUE);
+    }
+
+    g_autofree gchar *benchmark_arg = NULL;
+    if (g_strcmp0 (scenario->scenario, "app") == 0) {
+        g_autoptr(MockCatalogSnap) snap = mock_catalog_snap_new (0, 0, 0);
+        benchmark_arg = g_strdup_printf ("--benchmark=app=%s", snap->name);
+    }
+    else
+        benchmark_arg = g_strdup_printf ("--benchmark=%s", scenario->scenario);
+    g_autofree gchar *trace_arg = g_strdup_printf ("--trace-startup=%s", trace_path);
+    g_autofree gchar *snapd_arg = g_strdup_printf ("--snapd-socket-path=%s", snapd_socket_path);
+    g_autofree gchar *odrs_arg = g_strdup_printf ("--odrs-server=%s", odrs_uri);
+    gchar *argv[] = { snap_store_path, benchmark_arg, trace_arg, snapd_arg, odrs_arg, NULL };
+
+    gint64 start_time = g_get_monotonic_time ();
+    GPid pid;
+    g_autoptr(GError) error = NULL;
+    if (!g_spawn_async (NULL, argv, envp, G_SPAWN_DO_NOT_REAP_CHILD, NULL, NULL, &pid, &error)) {
+        g_printerr ("Failed to run %s: %s\n", snap_store_path, error->message);
+        return FALSE;
+    }
+
+    /* Poll rather than block so a hung snap-store can be killed */
+    int status;
+    struct rusage usage;
+    while (wait4 (pid, &status, WNOHANG, &usage) == 0) {
+        if (g_get_monotonic_time () - start_time > SCENARIO_TIMEOUT) {
+            g_printerr ("Scenario %s timed out\n", scenario->name);
+            kill (pid, SIGKILL);
+            wait4 (pid, &status, 0, &usage);
+            return FALSE;
+        }
+        g_usleep (1000);
+    }
+    gint64 wall_time = g_get_monotonic_time () - start_time;
+    g_spawn_close_pid (pid);
+
+    if (!WIFEXITED (status) || WEXITSTATUS (status) != 0) {
+        g_printerr ("Scenario %s failed, snap-store exited with status %d\n", scenario->name, status);
+        return FALSE;
+    }
+
+    gint64 scenario_time = get_scenario_time (trace_path);
+    if (scenario_time < 0) {
+        g_printerr ("Scenario %s did not complete\n", scenario->name);
+        return FALSE;
+    }
+
+    g_autoptr(GString) text = g_string_new (NULL);
+    g_string_append_printf (text, "{\"benchmark\": \"%s\", \"ns\": %" G_GINT64_FORMAT ", \"wall-ns\": %" G_GINT64_FORMAT ", \"user-cpu-ns\": %" G_GINT64_FORMAT ", \"system-cpu-ns\": %" G_GINT64_FORMAT ", \"allocations\": %" G_GINT64_FORMAT ", \"peak-rss-bytes\": %" G_GINT64_FORMAT,
+                            scenario->name,
+                            scenario_time,
+                            wall_time * 1000,
+                            timeval_to_ns (&usage.ru_utime),
+                            timeval_to_ns (&usage.ru_stime),
+                            alloc_counter_path != NULL ? get_allocations (allocations_path) : -1,
+                            (gint64) usage.ru_maxrss * 1024);
+    const gchar *members[] = { "ns", "wall-ns", "user-cpu-ns", "system-cpu-ns", "allocations", "peak-rss-bytes", NULL };
+    benchmark_baseline_append (baseline, scenario->name, members, text);
+    g_string_append (text, "}\n");
+    g_print ("%s", text->str);
+
+    return TRUE;
+}
+
+int
+main (int argc, char **argv)
+{
+    g_autofree gchar *baseline_path = NULL;
+    const GOptionEntry options[] = {
+        { "alloc-counter", 0, 0, G_OPTION_ARG_FILENAME, &alloc_counter_path,
+          "Library to count allocations with", "PATH" },
+        { "baseline", 0, 0, G_OPTION_ARG_FILENAME, &baseline_path,
+          "Output of an earlier run to report alongside the results", "FILE" },
+        { "snapd-arg", 0, 0, G_OPTION_ARG_STRING_ARRAY, &snapd_args,
+          "Argument to pass to mock-snapd, e.g. --network=latency=200", "ARG" },
+        { "odrs-arg", 0, 0, G_OPTION_ARG_STRING_ARRAY, &odrs_args,
+          "Argument to pass to mock-odrs", "ARG" },
+        { NULL }
+    };
+    g_autoptr(GOptionContext) context = g_option_context_new ("SNAP-STORE-BENCHMARK MOCK-SNAPD MOCK-ODRS");
+    g_option_context_add_main_entries (context, options, NULL);
+    g_autoptr(GError) error = NULL;
+    if (!g_option_context_parse (context, &argc, &argv, &error)) {
+        g_printerr ("%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    if (argc < 4) {
+        g_printerr ("Usage: %s SNAP-STORE-BENCHMARK MOCK-SNAPD MOCK-ODRS\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (baseline_path != NULL && (baseline = benchmark_baseline_load (baseline_path, &error)) == NULL) {
+        g_printerr ("Failed to load baseline: %s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    snap_store_path = argv[1];
+
+    temp_dir = g_dir_make_tmp ("snap-store-benchmark-XXXXXX", &error);
+    if (temp_dir == NULL) {
+        g_printerr ("Failed to make temporary directory: %s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    environment = g_get_environ ();
+
+    g_autoptr(GSubprocess) display = start_display (&error);
+    if (display == NULL) {
+        g_printerr ("Skipping, failed to start broadwayd: %s\n", error->message);
+        remove_directory (temp_dir);
+        return EXIT_SKIP;
+    }
+
+    /* Keep off the session bus so an already running snap-store isn't used */
+    g_autoptr(GTestDBus) bus = g_test_dbus_new (G_TEST_DBUS_NONE);
+    g_test_dbus_up (bus);
+    environment = g_environ_setenv (environment, "DBUS_SESSION_BUS_ADDRESS", g_test_dbus_get_bus_address (bus), TRUE);
+
+    g_autofree gchar *snapd_socket_path = NULL;
+    g_autoptr(GSubprocess) snapd = start_mock (argv[2], snapd_args, "Listening on socket ", &snapd_socket_path, &error);
+    if (snapd == NULL) {
+        g_printerr ("Failed to start mock snapd: %s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    g_autofree gchar *odrs_port = NULL;
+    g_autoptr(GSubprocess) odrs = start_mock (argv[3], odrs_args, "Listening on port ", &odrs_port, &error);
+    if (odrs == NULL) {
+        g_printerr ("Failed to start mock ODRS: %s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    g_autofree gchar *odrs_uri = g_strdup_printf ("http://127.0.0.1:%s", odrs_port);
+
+    gboolean result = TRUE;
+    for (gsize i = 0; i < G_N_ELEMENTS (scenarios); i++)
+        if (!run_scenario (&scenarios[i], snapd_socket_path, odrs_uri))
+            result = FALSE;
+
+    g_subprocess_force_exit (odrs);
+    g_subprocess_force_exit (snapd);
+    g_subprocess_force_exit (display);
+    g_test_dbus_down (bus);
+    remove_directory (temp_dir);
+    g_clear_pointer (&baseline, g_hash_table_unref);
+
+    return result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "mock-catalog.h"
+
+/* Same sections as the Snap Store, featured is added as well as the main section */
+static const gchar *sections[] = {
+    "featured",
+    "art-and-design",
+    "books-and-reference",
+    "development",
+    "devices-and-iot",
+    "education",
+    "entertainment",
+    "finance",
+    "games",
+    "health-and-fitness",
+    "music-and-audio",
+    "news-and-weather",
+    "personalisation",
+    "photo-and-video",
+    "productivity",
+    "science",
+    "security",
+    "server-and-cloud",
+    "social",
+    "utilities",
+    NULL
+};
+
+static const gchar *adjectives[] = {
+    "quick", "bright", "open", "tiny", "deep", "smart", "simple", "super",
+    "pocket", "cloud", "little", "mighty", "shiny", "retro", "cosmic", "zen"
+};
+
+static const gchar *nouns[] = {
+    "editor", "player", "viewer", "manager", "browser", "terminal", "notes", "paint",
+    "chat", "mail", "studio", "tracker", "monitor", "reader", "scanner", "builder"
+};
+
+static const gchar *words[] = {
+    "a", "the", "and", "with", "for", "your", "fast", "files", "open", "source",
+    "desktop", "application", "simple", "powerful", "lightweight", "support", "edit", "view", "share", "cloud",
+    "secure", "private", "plugins", "themes", "keyboard", "shortcuts", "images", "video", "music", "documents",
+    "projects", "work", "offline", "sync", "across", "devices", "built", "community", "free", "features",
+    "easy", "use", "manage", "create", "modern", "interface", "settings", "backup", "export", "import",
+    "formats", "many", "more", "every", "day", "tool", "developers", "designers", "everyone", "snap"
+};
+
+static const gchar *licenses[] = { "GPL-3.0", "MIT", "Apache-2.0", "BSD-3-Clause", "Proprietary" };
+
+static const gchar *risks[] = { "stable", "candidate", "beta", "edge" };
+
+static const gchar *
+pick (GRand *rand, const gchar **values, gsize n_values)
+{
+    return values[g_rand_int_range (rand, 0, n_values)];
+}
+
+/* Sentences of random words, with paragraph breaks */
+static gchar *
+make_text (GRand *rand, guint min_length, guint max_length)
+{
+    guint length = g_rand_int_range (rand, min_length, max_length + 1);
+    GString *text = g_string_new (NULL);
+    gboolean start = TRUE;
+    while (text->len < length) {
+        const gchar *word = pick (rand, words, G_N_ELEMENTS (words));
+        if (start) {
+            g_string_append_c (text, g_ascii_toupper (word[0]));
+            g_string_append (text, word + 1);
+            start = FALSE;
+        }
+        else {
+            g_string_append_c (text, ' ');
+            g_string_append (text, word);
+        }
+
+        if (g_rand_int_range (rand, 0, 12) == 0) {
+            g_string_append (text, g_rand_int_range (rand, 0, 4) == 0 ? ".\n\n" : ".");
+            start = TRUE;
+        }
+    }
+    if (!start)
+        g_string_append_c (text, '.');
+
+    return g_strchomp (g_string_free (text, FALSE));
+}
+
+static gchar *
+make_date (GRand *rand)
+{
+    return g_strdup_printf ("2019-%02d-%02dT%02d:00:00Z", g_rand_int_range (rand, 1, 13), g_rand_int_range (rand, 1, 29), g_rand_int_range (rand, 0, 24));
+}
+
+static MockCatalogChannel *
+make_channel (GRand *rand, const gchar *track, const gchar *risk)
+{
+    MockCatalogChannel *channel = g_new0 (MockCatalogChannel, 1);
+    channel->track = g_strdup (track);
+    channel->risk = g_strdup (risk);
+    channel->version = g_strdup_printf ("%d.%d.%d", g_rand_int_range (rand, 0, 10), g_rand_int_range (rand, 0, 30), g_rand_int_range (rand, 0, 100));
+    channel->revision = g_strdup_printf ("%d", g_rand_int_range (rand, 1, 5000));
+    channel->released_at = make_date (rand);
+    channel->size = g_rand_int_range (rand, 1000000, 500000000);
+    return channel;
+}
+
+static void
+mock_catalog_channel_free (MockCatalogChannel *channel)
+{
+    g_free (channel->track);
+    g_free (channel->risk);
+    g_free (channel->version);
+    g_free (channel->revision);
+    g_free (channel->released_at);
+    g_free (channel);
+}
+
+const gchar * const *
+mock_catalog_get_sections (void)
+{
+    return sections;
+}
+
+/* Each snap only depends on the seed and its index, so any subset can be generated */
+MockCatalogSnap *
+mock_catalog_snap_new (guint32 seed, guint index, guint max_reviews)
+{
+    guint32 seeds[] = { seed, index };
+    g_autoptr(GRand) rand = g_rand_new_with_seed_array (seeds, G_N_ELEMENTS (seeds));
+
+    MockCatalogSnap *snap = g_new0 (MockCatalogSnap, 1);
+    const gchar *adjective = pick (rand, adjectives, G_N_ELEMENTS (adjectives));
+    const gchar *noun = pick (rand, nouns, G_N_ELEMENTS (nouns));
+    snap->name = g_strdup_printf ("%s-%s%u", adjective, noun, index);
+    snap->id = g_compute_checksum_for_string (G_CHECKSUM_MD5, snap->name, -1);
+    snap->appstream_id = g_strdup_printf ("io.snapcraft.%s-%s", snap->name, snap->id);
+    snap->title = g_strdup_printf ("%c%s %c%s %u", g_ascii_toupper (adjective[0]), adjective + 1, g_ascii_toupper (noun[0]), noun + 1, index);
+    snap->summary = make_text (rand, 20, 80);
+    snap->description = make_text (rand, 500, 4000);
+    snap->publisher = g_strdup_printf ("Publisher %d", g_rand_int_range (rand, 0, 200));
+    snap->license = g_strdup (pick (rand, licenses, G_N_ELEMENTS (licenses)));
+    snap->section = g_strdup (sections[g_rand_int_range (rand, 1, G_N_ELEMENTS (sections) - 1)]);
+    snap->featured = g_rand_int_range (rand, 0, 20) == 0;
+
+    /* Nothing serves these, they are only to have realistic metadata */
+    snap->icon_url = g_strdup_printf ("https://media.invalid/%s/icon.png", snap->name);
+    if (g_rand_int_range (rand, 0, 4) == 0)
+        snap->banner_url = g_strdup_printf ("https://media.invalid/%s/banner.png", snap->name);
+    snap->screenshot_urls = g_ptr_array_new_with_free_func (g_free);
+    gint n_screenshots = g_rand_int_range (rand, 0, 6);
+    for (gint i = 0; i < n_screenshots; i++)
+        g_ptr_array_add (snap->screenshot_urls, g_strdup_printf ("https://media.invalid/%s/screenshot%d.png", snap->name, i));
+
+    snap->channels = g_ptr_array_new_with_free_func ((GDestroyNotify) mock_catalog_channel_free);
+    gint n_tracks = g_rand_int_range (rand, 1, 4);
+    for (gint i = 0; i < n_tracks; i++) {
+        g_autofree gchar *track = i == 0 ? g_strdup ("latest") : g_strdup_printf ("%d.0", i);
+        for (gsize j = 0; j < G_N_ELEMENTS (risks); j++)
+            if (j == 0 || g_rand_boolean (rand))
+                g_ptr_array_add (snap->channels, make_channel (rand, track, risks[j]));
+    }
+
+    /* Popularity falls off with the index, mostly positive like real ratings */
+    gint64 n_ratings = 100000 / (index + 1) + g_rand_int_range (rand, 0, 50);
+    const gdouble weights[] = { 0.02, 0.05, 0.05, 0.13, 0.30, 0.45 };
+    for (gsize i = 0; i < G_N_ELEMENTS (weights); i++)
+        snap->star_counts[i] = n_ratings * weights[i] * g_rand_double_range (rand, 0.5, 1.5);
+    snap->n_reviews = max_reviews / (index + 1) + g_rand_int_range (rand, 0, 4);
+
+    return snap;
+}
+
+void
+mock_catalog_snap_free (MockCatalogSnap *snap)
+{
+    g_free (snap->name);
+    g_free (snap->id);
+    g_free (snap->appstream_id);
+    g_free (snap->title);
+    g_free (snap->summary);
+    g_free (snap->description);
+    g_free (snap->publisher);
+    g_free (snap->license);
+    g_free (snap->section);
+    g_free (snap->icon_url);
+    g_free (snap->banner_url);
+    g_ptr_array_unref (snap->screenshot_urls);
+    g_ptr_array_unref (snap->channels);
+    g_free (snap);
+}
+
+MockCatalogReview *
+mock_catalog_review_new (guint32 seed, guint snap_index, guint review_index)
+{
+    guint32 seeds[] = { seed, snap_index, review_index, 1 };
+    g_autoptr(GRand) rand = g_rand_new_with_seed_array (seeds, G_N_ELEMENTS (seeds));
+
+    MockCatalogReview *review = g_new0 (MockCatalogReview, 1);
+    review->user_display = g_strdup_printf ("User %d", g_rand_int_range (rand, 0, 100000));
+    review->summary = make_text (rand, 10, 60);
+    review->description = make_text (rand, 50, 1500);
+    review->version = g_strdup_printf ("%d.%d", g_rand_int_range (rand, 0, 10), g_rand_int_range (rand, 0, 30));
+    review->date_created = 1546300800 + g_rand_int_range (rand, 0, 365 * 24 * 60 * 60);
+    review->rating = g_rand_int_range (rand, 1, 6) * 20;
+
+    return review;
+}
+
+void
+mock_catalog_review_free (MockCatalogReview *review)
+{
+    g_free (review->user_display);
+    g_free (review->summary);
+    g_free (review->description);
+    g_free (review->version);
+    g_free (review);
+}
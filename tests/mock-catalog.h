@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct
+{
+    gchar *track;
+    gchar *risk;
+    gchar *version;
+    gchar *revision;
+    gchar *released_at;
+    gint size;
+} MockCatalogChannel;
+
+typedef struct
+{
+    gchar *name;
+    gchar *id;
+    gchar *appstream_id;
+    gchar *title;
+    gchar *summary;
+    gchar *description;
+    gchar *publisher;
+    gchar *license;
+    gchar *section;
+    gboolean featured;
+    gchar *icon_url;
+    gchar *banner_url;
+    GPtrArray *screenshot_urls;
+    GPtrArray *channels;
+    gint64 star_counts[6];
+    guint n_reviews;
+} MockCatalogSnap;
+
+typedef struct
+{
+    gchar *user_display;
+    gchar *summary;
+    gchar *description;
+    gchar *version;
+    gint64 date_created;
+    gint64 rating;
+} MockCatalogReview;
+
+const gchar * const *mock_catalog_get_sections (void);
+
+MockCatalogSnap     *mock_catalog_snap_new     (guint32 seed, guint index, guint max_reviews);
+
+void                 mock_catalog_snap_free    (MockCatalogSnap *snap);
+
+MockCatalogReview   *mock_catalog_review_new   (guint32 seed, guint snap_index, guint review_index);
+
+void                 mock_catalog_review_free  (MockCatalogReview *review);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (MockCatalogSnap, mock_catalog_snap_free)
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (MockCatalogReview, mock_catalog_review_free)
+
+G_END_DECLS
@@ -0,0 +1,326 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mock-network.h"
+
+/* How often throttled responses are sent another chunk */
+#define THROTTLE_INTERVAL 10
+
+typedef struct
+{
+    gchar *path;
+    guint latency;
+    guint bandwidth;
+    gdouble error_rate;
+    gdouble reset_rate;
+    gdouble stall_rate;
+} Rule;
+
+typedef struct
+{
+    SoupServer *server;
+    SoupMessage *message;
+    GBytes *body;
+    gsize offset;
+    guint bandwidth;
+    GSource *source;
+    gulong finished_id;
+} Response;
+
+struct _MockNetwork
+{
+    GObject parent_instance;
+
+    GRand *rand;
+    GPtrArray *rules;
+};
+
+G_DEFINE_TYPE (MockNetwork, mock_network, G_TYPE_OBJECT)
+
+static void
+rule_free (Rule *rule)
+{
+    g_free (rule->path);
+    g_free (rule);
+}
+
+static void
+response_free (Response *response)
+{
+    if (response->source != NULL)
+        g_source_destroy (response->source);
+    g_clear_pointer (&response->source, g_source_unref);
+    g_signal_handler_disconnect (response->message, response->finished_id);
+    g_clear_object (&response->server);
+    g_clear_object (&response->message);
+    g_clear_pointer (&response->body, g_bytes_unref);
+    g_free (response);
+}
+
+static void
+start_timeout (Response *response, guint interval, GSourceFunc callback)
+{
+    if (response->source != NULL)
+        g_source_destroy (response->source);
+    g_clear_pointer (&response->source, g_source_unref);
+    response->source = g_timeout_source_new (interval);
+    g_source_set_callback (response->source, callback, response, NULL);
+    g_source_attach (response->source, g_main_context_get_thread_default ());
+}
+
+static gboolean
+send_chunk_cb (gpointer user_data)
+{
+    Response *response = user_data;
+
+    gsize size = g_bytes_get_size (response->body);
+    gsize length = MIN (MAX ((gsize) response->bandwidth * THROTTLE_INTERVAL / 1000, 1), size - response->offset);
+    const guint8 *data = g_bytes_get_data (response->body, NULL);
+    soup_message_body_append (response->message->response_body, SOUP_MEMORY_COPY, data + response->offset, length);
+    response->offset += length;
+    soup_server_unpause_message (response->server, response->message);
+
+    if (response->offset < size)
+        return G_SOURCE_CONTINUE;
+
+    response_free (response);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+latency_cb (gpointer user_data)
+{
+    Response *response = user_data;
+
+    if (response->body != NULL) {
+        start_timeout (response, THROTTLE_INTERVAL, send_chunk_cb);
+        return G_SOURCE_REMOVE;
+    }
+
+    soup_server_unpause_message (response->server, response->message);
+    response_free (response);
+    return G_SOURCE_REMOVE;
+}
+
+/* Rules without a path apply to everything, otherwise the longest matching path wins */
+static Rule *
+find_rule (MockNetwork *self, const gchar *path)
+{
+    Rule *match = NULL;
+    for (guint i = 0; i < self->rules->len; i++) {
+        Rule *rule = g_ptr_array_index (self->rules, i);
+        if (!g_str_has_prefix (path, rule->path))
+            continue;
+        if (match == NULL || strlen (rule->path) >= strlen (match->path))
+            match = rule;
+    }
+
+    return match;
+}
+
+static gboolean
+parse_rate (const gchar *value, gdouble *rate, GError **error)
+{
+    gchar *end;
+    gdouble v = g_ascii_strtod (value, &end);
+    if (*end != '\0' || v < 0 || v > 1) {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT, "Invalid rate %s, must be between 0 and 1", value);
+        return FALSE;
+    }
+
+    *rate = v;
+    return TRUE;
+}
+
+static gboolean
+parse_uint (const gchar *value, guint *number, GError **error)
+{
+    guint64 v;
+    if (!g_ascii_string_to_unsigned (value, 10, 0, G_MAXUINT, &v, error))
+        return FALSE;
+
+    *number = v;
+    return TRUE;
+}
+
+static void
+mock_network_dispose (GObject *object)
+{
+    MockNetwork *self = MOCK_NETWORK (object);
+
+    g_clear_pointer (&self->rand, g_rand_free);
+    g_clear_pointer (&self->rules, g_ptr_array_unref);
+
+    G_OBJECT_CLASS (mock_network_parent_class)->dispose (object);
+}
+
+static void
+mock_network_class_init (MockNetworkClass *klass)
+{
+    G_OBJECT_CLASS (klass)->dispose = mock_network_dispose;
+}
+
+static void
+mock_network_init (MockNetwork *self)
+{
+    self->rand = g_rand_new_with_seed (0);
+    self->rules = g_ptr_array_new_with_free_func ((GDestroyNotify) rule_free);
+}
+
+MockNetwork *
+mock_network_new (void)
+{
+    return g_object_new (mock_network_get_type (), NULL);
+}
+
+/* Faults are random but repeatable for a given seed */
+void
+mock_network_set_seed (MockNetwork *self, guint32 seed)
+{
+    g_return_if_fail (MOCK_IS_NETWORK (self));
+    g_rand_set_seed (self->rand, seed);
+}
+
+/* Rules are in the form [PATH:]NAME=VALUE,... with the following names:
+ *   latency     delay before responding in milliseconds
+ *   bandwidth   bytes per second to send the response body at
+ *   error-rate  fraction of requests that get a 5xx response
+ *   reset-rate  fraction of requests that have the connection closed
+ *   stall-rate  fraction of requests that never get a response */
+gboolean
+mock_network_add_rule (MockNetwork *self, const gchar *rule_text, GError **error)
+{
+    g_return_val_if_fail (MOCK_IS_NETWORK (self), FALSE);
+
+    g_autofree gchar *path = NULL;
+    const gchar *settings = rule_text;
+    if (rule_text[0] == '/') {
+        const gchar *divider = strchr (rule_text, ':');
+        if (divider == NULL) {
+            g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT, "Missing settings for path in rule %s", rule_text);
+            return FALSE;
+        }
+        path = g_strndup (rule_text, divider - rule_text);
+        settings = divider + 1;
+    }
+    else
+        path = g_strdup ("");
+
+    Rule *rule = g_new0 (Rule, 1);
+    rule->path = g_steal_pointer (&path);
+    g_auto(GStrv) tokens = g_strsplit (settings, ",", -1);
+    for (int i = 0; tokens[i] != NULL; i++) {
+        g_auto(GStrv) setting = g_strsplit (tokens[i], "=", 2);
+        const gchar *name = setting[0];
+        const gchar *value = setting[1];
+        gboolean result;
+        if (value == NULL) {
+            g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT, "Missing value for %s", name);
+            result = FALSE;
+        }
+        else if (strcmp (name, "latency") == 0)
+            result = parse_uint (value, &rule->latency, error);
+        else if (strcmp (name, "bandwidth") == 0)
+            result = parse_uint (value, &rule->bandwidth, error);
+        else if (strcmp (name, "error-rate") == 0)
+            result = parse_rate (value, &rule->error_rate, error);
+        else if (strcmp (name, "reset-rate") == 0)
+            result = parse_rate (value, &rule->reset_rate, error);
+        else if (strcmp (name, "stall-rate") == 0)
+            result = parse_rate (value, &rule->stall_rate, error);
+        else {
+            g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT, "Unknown network setting %s", name);
+            result = FALSE;
+        }
+
+        if (!result) {
+            rule_free (rule);
+            return FALSE;
+        }
+    }
+    g_ptr_array_add (self->rules, rule);
+
+    return TRUE;
+}
+
+/* Call before handling a request, returns FALSE if the connection was reset */
+gboolean
+mock_network_begin_request (MockNetwork *self, SoupMessage *message G_GNUC_UNUSED, const gchar *path, SoupClientContext *client)
+{
+    g_return_val_if_fail (MOCK_IS_NETWORK (self), TRUE);
+
+    Rule *rule = find_rule (self, path);
+    if (rule == NULL || g_rand_double (self->rand) >= rule->reset_rate)
+        return TRUE;
+
+    g_autoptr(GIOStream) stream = soup_client_context_steal_connection (client);
+    g_autoptr(GError) error = NULL;
+    if (!g_io_stream_close (stream, NULL, &error))
+        g_warning ("Failed to close stream: %s", error->message);
+
+    return FALSE;
+}
+
+/* Call once the response is set, delays, throttles or replaces it */
+void
+mock_network_finish_request (MockNetwork *self, SoupServer *server, SoupMessage *message, const gchar *path)
+{
+    mock_network_finish_request_with_latency (self, server, message, path, 0);
+}
+
+/* As above, with latency the caller already knows about (e.g. a recorded response time) added to any rule */
+void
+mock_network_finish_request_with_latency (MockNetwork *self, SoupServer *server, SoupMessage *message, const gchar *path, guint latency)
+{
+    g_return_if_fail (MOCK_IS_NETWORK (self));
+
+    guint bandwidth = 0;
+    Rule *rule = find_rule (self, path);
+    if (rule != NULL) {
+        /* Never resumed, the client has to time out */
+        if (g_rand_double (self->rand) < rule->stall_rate) {
+            soup_server_pause_message (server, message);
+            return;
+        }
+
+        if (g_rand_double (self->rand) < rule->error_rate) {
+            const guint status_codes[] = { SOUP_STATUS_INTERNAL_SERVER_ERROR, SOUP_STATUS_BAD_GATEWAY, SOUP_STATUS_SERVICE_UNAVAILABLE };
+            soup_message_set_status (message, status_codes[g_rand_int_range (self->rand, 0, G_N_ELEMENTS (status_codes))]);
+            const gchar *text = "Injected fault\n";
+            soup_message_set_response (message, "text/plain", SOUP_MEMORY_STATIC, text, strlen (text));
+        }
+
+        latency += rule->latency;
+        bandwidth = rule->bandwidth;
+    }
+
+    if (latency == 0 && bandwidth == 0)
+        return;
+
+    Response *response = g_new0 (Response, 1);
+    response->server = g_object_ref (server);
+    response->message = g_object_ref (message);
+    response->bandwidth = bandwidth;
+    response->finished_id = g_signal_connect_swapped (message, "finished", G_CALLBACK (response_free), response);
+
+    /* Send the body in chunks over time */
+    if (bandwidth > 0 && message->response_body->length > 0) {
+        SoupBuffer *buffer = soup_message_body_flatten (message->response_body);
+        response->body = soup_buffer_get_as_bytes (buffer);
+        soup_buffer_free (buffer);
+        soup_message_body_truncate (message->response_body);
+        soup_message_headers_set_content_length (message->response_headers, g_bytes_get_size (response->body));
+    }
+
+    soup_server_pause_message (server, message);
+    start_timeout (response, latency, latency_cb);
+}
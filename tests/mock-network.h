@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#pragma once
+
+#include <libsoup/soup.h>
+
+G_BEGIN_DECLS
+
+G_DECLARE_FINAL_TYPE (MockNetwork, mock_network, MOCK, NETWORK, GObject)
+
+MockNetwork *mock_network_new                         (void);
+
+void         mock_network_set_seed                    (MockNetwork *network, guint32 seed);
+
+gboolean     mock_network_add_rule                    (MockNetwork *network, const gchar *rule, GError **error);
+
+gboolean     mock_network_begin_request               (MockNetwork *network, SoupMessage *message, const gchar *path, SoupClientContext *client);
+
+void         mock_network_finish_request              (MockNetwork *network, SoupServer *server, SoupMessage *message, const gchar *path);
+
+void         mock_network_finish_request_with_latency (MockNetwork *network, SoupServer *server, SoupMessage *message, const gchar *path, guint latency);
+
+G_END_DECLS
@@ -8,6 +8,7 @@
  */
 
 #include <json-glib/json-glib.h>
+#include <string.h>
 
 #include "mock-odrs-server.h"
 
@@ -16,7 +17,9 @@ struct _MockOdrsServer
     SoupServer parent_instance;
 
     GPtrArray *apps;
+    MockNetwork *network;
     guint port;
+    MockReplay *replay;
 };
 
 G_DEFINE_TYPE (MockOdrsServer, mock_odrs_server, SOUP_TYPE_SERVER)
@@ -60,6 +63,7 @@ struct _MockApp
 {
     gchar *id;
     GPtrArray *reviews;
+    gint64 star_counts[6];
 };
 
 static MockApp *
@@ -106,7 +110,8 @@ ratings_cb (SoupServer *server G_GNUC_UNUSED, SoupMessage *msg, const gchar *pat
     for (guint i = 0; i < self->apps->len; i++) {
         MockApp *app = g_ptr_array_index (self->apps, i);
 
-        gint64 count0, count1, count2 = 0, count3 = 0, count4 = 0, count5 = 0;
+        gint64 count0 = app->star_counts[0], count1 = app->star_counts[1], count2 = app->star_counts[2];
+        gint64 count3 = app->star_counts[3], count4 = app->star_counts[4], count5 = app->star_counts[5];
         for (guint j = 0; j < app->reviews->len; j++) {
             MockReview *review = g_ptr_array_index (app->reviews, j);
             if (review->rating == 0)
@@ -149,6 +154,14 @@ ratings_cb (SoupServer *server G_GNUC_UNUSED, SoupMessage *msg, const gchar *pat
     gsize json_text_length;
     g_autofree gchar *json_text = json_generator_to_data (generator, &json_text_length);
 
+    g_autofree gchar *checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, json_text, json_text_length);
+    g_autofree gchar *etag = g_strdup_printf ("\"%s\"", checksum);
+    soup_message_headers_replace (msg->response_headers, "ETag", etag);
+    if (g_strcmp0 (soup_message_headers_get_one (msg->request_headers, "If-None-Match"), etag) == 0) {
+        soup_message_set_status (msg, SOUP_STATUS_NOT_MODIFIED);
+        return;
+    }
+
     soup_message_set_status (msg, SOUP_STATUS_OK);
     soup_message_set_response (msg, "application/json; charset=utf-8", SOUP_MEMORY_TAKE, g_steal_pointer (&json_text), json_text_length);
 }
@@ -234,6 +247,9 @@ fetch_cb (SoupServer *server G_GNUC_UNUSED, SoupMessage *msg, const gchar *path
     const gchar *app_id = json_object_get_string_member (object, "app_id");
     //if (json_object_has_member (object, "compat_ids"))
     //    json_object_get_array_member (object, "compat_ids");
+    gint64 start = 0;
+    if (json_object_has_member (object, "start"))
+        start = json_object_get_int_member (object, "start");
     gint64 limit = G_MAXINT64;
     if (json_object_has_member (object, "limit"))
         limit = json_object_get_int_member (object, "limit");
@@ -244,7 +260,8 @@ fetch_cb (SoupServer *server G_GNUC_UNUSED, SoupMessage *msg, const gchar *path
 
     g_autoptr(JsonBuilder) builder = json_builder_new ();
     json_builder_begin_array (builder);
-    for (guint i = 0; app != NULL && i < app->reviews->len && i < limit; i++) {
+    start = MAX (start, 0);
+    for (gint64 i = start; app != NULL && i < app->reviews->len && i - start < limit; i++) {
         MockReview *review = g_ptr_array_index (app->reviews, i);
         json_builder_begin_object (builder);
         json_builder_set_member_name (builder, "user_skey");
@@ -263,7 +280,7 @@ fetch_cb (SoupServer *server G_GNUC_UNUSED, SoupMessage *msg, const gchar *path
         json_builder_add_string_value (builder, review->description);
         json_builder_end_object (builder);
     }
-    if (app == NULL || app->reviews->len == 0) {
+    if (app == NULL || start >= app->reviews->len) {
         json_builder_begin_object (builder);
         json_builder_set_member_name (builder, "user_skey");
         json_builder_add_string_value (builder, user_skey);
@@ -394,25 +411,57 @@ feedback_cb (SoupServer *server G_GNUC_UNUSED, SoupMessage *msg, const gchar *pa
         return;
     }
 
-    if (g_strcmp0 (path, "/upvote") == 0) {
+    if (g_str_has_suffix (path, "/upvote")) {
         review->upvote_count++;
     }
-    else if (g_strcmp0 (path, "/downvote") == 0) {
+    else if (g_str_has_suffix (path, "/downvote")) {
         review->downvote_count++;
     }
-    else if (g_strcmp0 (path, "/report") == 0) {
+    else if (g_str_has_suffix (path, "/report")) {
         review->report_count++;
     }
 
     respond (msg, TRUE, NULL);
 }
 
+static void
+handle_request (SoupServer *server, SoupMessage *msg, const gchar *path, GHashTable *query, SoupClientContext *context, gpointer user_data)
+{
+    MockOdrsServer *self = user_data;
+
+    if (!mock_network_begin_request (self->network, msg, path, context))
+        return;
+
+    if (self->replay != NULL) {
+        guint latency = mock_replay_handle_request (self->replay, msg, path);
+        mock_network_finish_request_with_latency (self->network, server, msg, path, latency);
+        return;
+    }
+
+    if (strcmp (path, "/1.0/reviews/api/ratings") == 0)
+        ratings_cb (server, msg, path, query, context, self);
+    else if (strcmp (path, "/1.0/reviews/api/fetch") == 0)
+        fetch_cb (server, msg, path, query, context, self);
+    else if (strcmp (path, "/1.0/reviews/api/submit") == 0)
+        submit_cb (server, msg, path, query, context, self);
+    else if (strcmp (path, "/1.0/reviews/api/upvote") == 0 ||
+             strcmp (path, "/1.0/reviews/api/downvote") == 0 ||
+             strcmp (path, "/1.0/reviews/api/report") == 0)
+        feedback_cb (server, msg, path, query, context, self);
+    else
+        soup_message_set_status (msg, SOUP_STATUS_NOT_FOUND);
+
+    mock_network_finish_request (self->network, server, msg, path);
+}
+
 static void
 mock_odrs_server_dispose (GObject *object)
 {
     MockOdrsServer *self = MOCK_ODRS_SERVER (object);
 
     g_clear_pointer (&self->apps, g_ptr_array_unref);
+    g_clear_object (&self->network);
+    g_clear_object (&self->replay);
 
     G_OBJECT_CLASS (mock_odrs_server_parent_class)->dispose (object);
 }
@@ -428,13 +477,10 @@ mock_odrs_server_init (MockOdrsServer *self)
 {
     self->apps = g_ptr_array_new_with_free_func ((GDestroyNotify) mock_app_free);
 
+    self->network = mock_network_new ();
+
     g_object_set (self, "server-header", "mock-odrs", NULL);
-    soup_server_add_handler (SOUP_SERVER (self), "/ratings", ratings_cb, self, NULL);
-    soup_server_add_handler (SOUP_SERVER (self), "/fetch", fetch_cb, self, NULL);
-    soup_server_add_handler (SOUP_SERVER (self), "/submit", submit_cb, self, NULL);
-    soup_server_add_handler (SOUP_SERVER (self), "/upvote", feedback_cb, self, NULL);
-    soup_server_add_handler (SOUP_SERVER (self), "/downvote", feedback_cb, self, NULL);
-    soup_server_add_handler (SOUP_SERVER (self), "/report", feedback_cb, self, NULL);
+    soup_server_add_handler (SOUP_SERVER (self), NULL, handle_request, self, NULL);
 }
 
 MockOdrsServer *
@@ -443,6 +489,21 @@ mock_odrs_server_new (void)
     return g_object_new (mock_odrs_server_get_type (), NULL);
 }
 
+MockNetwork *
+mock_odrs_server_get_network (MockOdrsServer *self)
+{
+    g_return_val_if_fail (MOCK_IS_ODRS_SERVER (self), NULL);
+    return self->network;
+}
+
+/* Serve recorded responses instead of the mock apps */
+void
+mock_odrs_server_set_replay (MockOdrsServer *self, MockReplay *replay)
+{
+    g_return_if_fail (MOCK_IS_ODRS_SERVER (self));
+    g_set_object (&self->replay, replay);
+}
+
 void
 mock_odrs_server_set_port (MockOdrsServer *self, guint port)
 {
@@ -508,6 +569,13 @@ mock_odrs_server_find_app (MockOdrsServer *self, const gchar *id)
     return NULL;
 }
 
+void
+mock_app_set_star_count (MockApp *app, gint64 stars, gint64 count)
+{
+    g_return_if_fail (stars >= 0 && stars <= 5);
+    app->star_counts[stars] = count;
+}
+
 MockReview *
 mock_app_add_review (MockApp *app)
 {
@@ -582,25 +650,20 @@ mock_review_set_rating (MockReview *review, gint64 rating)
     review->rating = rating;
 }
 
-int
-main (int argc, char **argv)
+gint64
+mock_review_get_upvote_count (MockReview *review)
 {
-    g_autoptr(GMainLoop) loop = g_main_loop_new (NULL, FALSE);
-
-    guint port = 0;
-    if (argc > 1)
-        port = atoi (argv[1]);
-
-    g_autoptr(MockOdrsServer) server = mock_odrs_server_new ();
-    mock_odrs_server_set_port (server, port);
-    g_autoptr(GError) error = NULL;
-    if (!mock_odrs_server_start (server, &error)) {
-        g_printerr ("Failed to start server: %s\n", error->message);
-        return EXIT_FAILURE;
-    }
-    g_printerr ("Listening on port %u\n", mock_odrs_server_get_port (server));
+    return review->upvote_count;
+}
 
-    g_main_loop_run (loop);
+gint64
+mock_review_get_downvote_count (MockReview *review)
+{
+    return review->downvote_count;
+}
 
-    return EXIT_SUCCESS;
+gint64
+mock_review_get_report_count (MockReview *review)
+{
+    return review->report_count;
 }
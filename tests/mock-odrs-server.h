@@ -11,6 +11,9 @@
 
 #include <libsoup/soup.h>
 
+#include "mock-network.h"
+#include "mock-replay.h"
+
 G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (MockOdrsServer, mock_odrs_server, MOCK, ODRS_SERVER, SoupServer)
@@ -18,34 +21,48 @@ G_DECLARE_FINAL_TYPE (MockOdrsServer, mock_odrs_server, MOCK, ODRS_SERVER, SoupS
 typedef struct _MockApp MockApp;
 typedef struct _MockReview MockReview;
 
-MockOdrsServer *mock_odrs_server_new         (void);
+MockOdrsServer *mock_odrs_server_new           (void);
+
+MockNetwork    *mock_odrs_server_get_network   (MockOdrsServer *server);
+
+void            mock_odrs_server_set_replay    (MockOdrsServer *server, MockReplay *replay);
+
+void            mock_odrs_server_set_port      (MockOdrsServer *server, guint port);
+
+guint           mock_odrs_server_get_port      (MockOdrsServer *server);
+
+gboolean        mock_odrs_server_start         (MockOdrsServer *server, GError **error);
+
+MockApp        *mock_odrs_server_add_app       (MockOdrsServer *server, const gchar *id);
+
+MockApp        *mock_odrs_server_find_app      (MockOdrsServer *server, const gchar *id);
 
-void            mock_odrs_server_set_port    (MockOdrsServer *server, guint port);
+void            mock_app_set_star_count        (MockApp *app, gint64 stars, gint64 count);
 
-guint           mock_odrs_server_get_port    (MockOdrsServer *server);
+MockReview     *mock_app_add_review            (MockApp *app);
 
-MockApp        *mock_odrs_server_add_app     (MockOdrsServer *server, const gchar *id);
+MockReview     *mock_app_find_review           (MockApp *app, gint64 id);
 
-MockApp        *mock_odrs_server_find_app    (MockOdrsServer *server, const gchar *id);
+void            mock_review_set_locale         (MockReview *review, const gchar *locale);
 
-MockReview     *mock_app_add_review          (MockApp *app);
+void            mock_review_set_distro         (MockReview *review, const gchar *distro);
 
-MockReview     *mock_app_find_review         (MockApp *app, gint64 id);
+void            mock_review_set_version        (MockReview *review, const gchar *version);
 
-void            mock_review_set_locale       (MockReview *review, const gchar *locale);
+void            mock_review_set_date_created   (MockReview *review, gint64 date_created);
 
-void            mock_review_set_distro       (MockReview *review, const gchar *distro);
+void            mock_review_set_user_display   (MockReview *review, const gchar *user_display);
 
-void            mock_review_set_version      (MockReview *review, const gchar *version);
+void            mock_review_set_summary        (MockReview *review, const gchar *summary);
 
-void            mock_review_set_date_created (MockReview *review, gint64 date_created);
+void            mock_review_set_description    (MockReview *review, const gchar *description);
 
-void            mock_review_set_user_display (MockReview *review, const gchar *user_display);
+void            mock_review_set_rating         (MockReview *review, gint64 rating);
 
-void            mock_review_set_summary      (MockReview *review, const gchar *summary);
+gint64          mock_review_get_upvote_count   (MockReview *review);
 
-void            mock_review_set_description  (MockReview *review, const gchar *description);
+gint64          mock_review_get_downvote_count (MockReview *review);
 
-void            mock_review_set_rating       (MockReview *review, gint64 rating);
+gint64          mock_review_get_report_count   (MockReview *review);
 
 G_END_DECLS
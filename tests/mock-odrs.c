@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <stdlib.h>
+
+#include "mock-catalog.h"
+#include "mock-odrs-server.h"
+
+/* Ratings and reviews for the same generated snaps as mock-snapd, with other apps to fill out the ratings feed */
+static void
+add_catalog (MockOdrsServer *server, guint32 seed, guint n_snaps, guint n_ratings, guint max_reviews)
+{
+    for (guint i = 0; i < n_snaps; i++) {
+        g_autoptr(MockCatalogSnap) catalog_snap = mock_catalog_snap_new (seed, i, max_reviews);
+
+        MockApp *app = mock_odrs_server_add_app (server, catalog_snap->appstream_id);
+        for (gsize j = 0; j < G_N_ELEMENTS (catalog_snap->star_counts); j++)
+            mock_app_set_star_count (app, j, catalog_snap->star_counts[j]);
+        for (guint j = 0; j < catalog_snap->n_reviews; j++) {
+            g_autoptr(MockCatalogReview) catalog_review = mock_catalog_review_new (seed, i, j);
+            MockReview *review = mock_app_add_review (app);
+            mock_review_set_user_display (review, catalog_review->user_display);
+            mock_review_set_summary (review, catalog_review->summary);
+            mock_review_set_description (review, catalog_review->description);
+            mock_review_set_version (review, catalog_review->version);
+            mock_review_set_date_created (review, catalog_review->date_created);
+            mock_review_set_rating (review, catalog_review->rating);
+        }
+    }
+
+    for (guint i = n_snaps; i < n_ratings; i++) {
+        g_autoptr(MockCatalogSnap) catalog_snap = mock_catalog_snap_new (seed, i, 0);
+        g_autofree gchar *id = g_strdup_printf ("org.example.App%u.desktop", i);
+        MockApp *app = mock_odrs_server_add_app (server, id);
+        for (gsize j = 0; j < G_N_ELEMENTS (catalog_snap->star_counts); j++)
+            mock_app_set_star_count (app, j, catalog_snap->star_counts[j]);
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+    g_autoptr(GMainLoop) loop = g_main_loop_new (NULL, FALSE);
+
+    g_auto(GStrv) network_rules = NULL;
+    gint seed = 0;
+    gint n_snaps = 1000;
+    gint n_ratings = 0;
+    gint max_reviews = 50;
+    g_autofree gchar *replay_path = NULL;
+    gdouble replay_timing = 1.0;
+    const GOptionEntry options[] = {
+        { "snaps", 0, 0, G_OPTION_ARG_INT, &n_snaps,
+          "Number of snaps to have ratings and reviews for, matching mock-snapd", "COUNT" },
+        { "ratings", 0, 0, G_OPTION_ARG_INT, &n_ratings,
+          "Total number of apps in the ratings feed", "COUNT" },
+        { "reviews", 0, 0, G_OPTION_ARG_INT, &max_reviews,
+          "Number of reviews on the most popular snap", "COUNT" },
+        { "network", 0, 0, G_OPTION_ARG_STRING_ARRAY, &network_rules,
+          "Simulate network conditions, e.g. /1.0/reviews/api/ratings:bandwidth=100000,reset-rate=0.2", "[PATH:]NAME=VALUE,..." },
+        { "seed", 0, 0, G_OPTION_ARG_INT, &seed,
+          "Seed for the catalog and random faults", "SEED" },
+        { "replay", 0, 0, G_OPTION_ARG_FILENAME, &replay_path,
+          "Serve the HTTP responses recorded with snap-store --record", "FILE" },
+        { "replay-timing", 0, 0, G_OPTION_ARG_DOUBLE, &replay_timing,
+          "Scale recorded response times, 0 to respond immediately", "SCALE" },
+        { NULL }
+    };
+    g_autoptr(GOptionContext) context = g_option_context_new ("[PORT]");
+    g_option_context_add_main_entries (context, options, NULL);
+    g_autoptr(GError) error = NULL;
+    if (!g_option_context_parse (context, &argc, &argv, &error)) {
+        g_printerr ("%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+
+    guint port = 0;
+    if (argc > 1)
+        port = atoi (argv[1]);
+
+    g_autoptr(MockOdrsServer) server = mock_odrs_server_new ();
+    mock_odrs_server_set_port (server, port);
+    if (replay_path != NULL) {
+        g_autoptr(MockReplay) replay = mock_replay_new ();
+        mock_replay_set_timing (replay, replay_timing);
+        if (!mock_replay_load (replay, replay_path, "http", &error)) {
+            g_printerr ("Failed to load recording: %s\n", error->message);
+            return EXIT_FAILURE;
+        }
+        mock_odrs_server_set_replay (server, replay);
+    }
+    else
+        add_catalog (server, seed, MAX (n_snaps, 0), MAX (n_ratings, 0), MAX (max_reviews, 0));
+    MockNetwork *network = mock_odrs_server_get_network (server);
+    mock_network_set_seed (network, seed);
+    for (int i = 0; network_rules != NULL && network_rules[i] != NULL; i++) {
+        if (!mock_network_add_rule (network, network_rules[i], &error)) {
+            g_printerr ("Invalid network rule: %s\n", error->message);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!mock_odrs_server_start (server, &error)) {
+        g_printerr ("Failed to start server: %s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    g_printerr ("Listening on port %u\n", mock_odrs_server_get_port (server));
+
+    g_main_loop_run (loop);
+
+    return EXIT_SUCCESS;
+}
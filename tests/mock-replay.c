@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <json-glib/json-glib.h>
+#include <string.h>
+
+#include "mock-replay.h"
+
+typedef struct
+{
+    GBytes *request_body;
+    gint64 duration;
+    guint status;
+    JsonObject *headers;
+    GBytes *body;
+    gboolean used;
+} Exchange;
+
+struct _MockReplay
+{
+    GObject parent_instance;
+
+    GHashTable *exchanges;
+    gdouble timing_scale;
+};
+
+G_DEFINE_TYPE (MockReplay, mock_replay, G_TYPE_OBJECT)
+
+static void
+exchange_free (Exchange *exchange)
+{
+    g_clear_pointer (&exchange->request_body, g_bytes_unref);
+    g_clear_pointer (&exchange->headers, json_object_unref);
+    g_clear_pointer (&exchange->body, g_bytes_unref);
+    g_free (exchange);
+}
+
+static gchar *
+make_key (const gchar *method, const gchar *path, const gchar *query)
+{
+    if (query != NULL)
+        return g_strdup_printf ("%s %s?%s", method, path, query);
+    else
+        return g_strdup_printf ("%s %s", method, path);
+}
+
+static const gchar *
+get_string_member (JsonObject *object, const gchar *name, const gchar *default_value)
+{
+    return json_object_has_member (object, name) ? json_object_get_string_member (object, name) : default_value;
+}
+
+static gint64
+get_int_member (JsonObject *object, const gchar *name, gint64 default_value)
+{
+    return json_object_has_member (object, name) ? json_object_get_int_member (object, name) : default_value;
+}
+
+static GBytes *
+get_bytes_member (JsonObject *object, const gchar *name)
+{
+    const gchar *text = get_string_member (object, name, "");
+    gsize length;
+    guchar *data = g_base64_decode (text, &length);
+    return g_bytes_new_take (data, length);
+}
+
+static void
+set_header (JsonObject *object G_GNUC_UNUSED, const gchar *name, JsonNode *node, gpointer user_data)
+{
+    SoupMessage *message = user_data;
+    soup_message_headers_append (message->response_headers, name, json_node_get_string (node));
+}
+
+/* Repeated requests get the recorded responses in order, preferring one with the same body.
+ * Once they run out the last one is used again */
+static Exchange *
+find_exchange (GPtrArray *exchanges, GBytes *request_body)
+{
+    Exchange *next = NULL;
+    for (guint i = 0; i < exchanges->len; i++) {
+        Exchange *exchange = g_ptr_array_index (exchanges, i);
+        if (exchange->used)
+            continue;
+        if (g_bytes_equal (exchange->request_body, request_body))
+            return exchange;
+        if (next == NULL)
+            next = exchange;
+    }
+
+    if (next != NULL)
+        return next;
+    return g_ptr_array_index (exchanges, exchanges->len - 1);
+}
+
+static void
+mock_replay_dispose (GObject *object)
+{
+    MockReplay *self = MOCK_REPLAY (object);
+
+    g_clear_pointer (&self->exchanges, g_hash_table_unref);
+
+    G_OBJECT_CLASS (mock_replay_parent_class)->dispose (object);
+}
+
+static void
+mock_replay_class_init (MockReplayClass *klass)
+{
+    G_OBJECT_CLASS (klass)->dispose = mock_replay_dispose;
+}
+
+static void
+mock_replay_init (MockReplay *self)
+{
+    self->exchanges = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+    self->timing_scale = 1.0;
+}
+
+MockReplay *
+mock_replay_new (void)
+{
+    return g_object_new (mock_replay_get_type (), NULL);
+}
+
+/* Loads the exchanges from a file written by snap-store --record that came from source ("snapd" or "http") */
+gboolean
+mock_replay_load (MockReplay *self, const gchar *path, const gchar *source, GError **error)
+{
+    g_return_val_if_fail (MOCK_IS_REPLAY (self), FALSE);
+
+    g_autofree gchar *contents = NULL;
+    if (!g_file_get_contents (path, &contents, NULL, error))
+        return FALSE;
+
+    g_auto(GStrv) lines = g_strsplit (contents, "\n", -1);
+    for (int i = 0; lines[i] != NULL; i++) {
+        if (lines[i][0] == '\0')
+            continue;
+
+        g_autoptr(JsonParser) parser = json_parser_new ();
+        if (!json_parser_load_from_data (parser, lines[i], -1, error)) {
+            g_prefix_error (error, "Line %d: ", i + 1);
+            return FALSE;
+        }
+        JsonNode *root = json_parser_get_root (parser);
+        if (!JSON_NODE_HOLDS_OBJECT (root)) {
+            g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Line %d: Expected object", i + 1);
+            return FALSE;
+        }
+        JsonObject *object = json_node_get_object (root);
+        if (g_strcmp0 (get_string_member (object, "source", NULL), source) != 0)
+            continue;
+
+        const gchar *method = get_string_member (object, "method", "GET");
+        const gchar *exchange_path = get_string_member (object, "path", "/");
+        const gchar *query = get_string_member (object, "query", NULL);
+        g_autofree gchar *key = make_key (method, exchange_path, query);
+        GPtrArray *exchanges = g_hash_table_lookup (self->exchanges, key);
+        if (exchanges == NULL) {
+            exchanges = g_ptr_array_new_with_free_func ((GDestroyNotify) exchange_free);
+            g_hash_table_insert (self->exchanges, g_steal_pointer (&key), exchanges);
+        }
+
+        Exchange *exchange = g_new0 (Exchange, 1);
+        exchange->request_body = get_bytes_member (object, "request-body");
+        exchange->duration = get_int_member (object, "duration", 0);
+        exchange->status = get_int_member (object, "status", SOUP_STATUS_OK);
+        JsonObject *headers = json_object_has_member (object, "headers") ? json_object_get_object_member (object, "headers") : NULL;
+        exchange->headers = headers != NULL ? json_object_ref (headers) : json_object_new ();
+        exchange->body = get_bytes_member (object, "body");
+        g_ptr_array_add (exchanges, exchange);
+    }
+
+    return TRUE;
+}
+
+/* Scales the recorded response times, 1.0 for the original timing and 0.0 to respond immediately */
+void
+mock_replay_set_timing (MockReplay *self, gdouble scale)
+{
+    g_return_if_fail (MOCK_IS_REPLAY (self));
+    self->timing_scale = MAX (scale, 0.0);
+}
+
+/* Sets the recorded response, returns how long in milliseconds to delay it */
+guint
+mock_replay_handle_request (MockReplay *self, SoupMessage *message, const gchar *path)
+{
+    g_return_val_if_fail (MOCK_IS_REPLAY (self), 0);
+
+    g_autofree gchar *key = make_key (message->method, path, soup_uri_get_query (soup_message_get_uri (message)));
+    GPtrArray *exchanges = g_hash_table_lookup (self->exchanges, key);
+    if (exchanges == NULL) {
+        g_printerr ("No recorded response for %s\n", key);
+        soup_message_set_status (message, SOUP_STATUS_NOT_FOUND);
+        return 0;
+    }
+
+    SoupBuffer *buffer = soup_message_body_flatten (message->request_body);
+    g_autoptr(GBytes) request_body = soup_buffer_get_as_bytes (buffer);
+    soup_buffer_free (buffer);
+    Exchange *exchange = find_exchange (exchanges, request_body);
+    exchange->used = TRUE;
+
+    soup_message_set_status (message, exchange->status);
+    json_object_foreach_member (exchange->headers, set_header, message);
+    soup_message_body_append_bytes (message->response_body, exchange->body);
+
+    return exchange->duration * self->timing_scale / 1000;
+}
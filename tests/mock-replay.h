@@ -0,0 +1,26 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#pragma once
+
+#include <libsoup/soup.h>
+
+G_BEGIN_DECLS
+
+G_DECLARE_FINAL_TYPE (MockReplay, mock_replay, MOCK, REPLAY, GObject)
+
+MockReplay *mock_replay_new            (void);
+
+gboolean    mock_replay_load           (MockReplay *replay, const gchar *path, const gchar *source, GError **error);
+
+void        mock_replay_set_timing     (MockReplay *replay, gdouble scale);
+
+guint       mock_replay_handle_request (MockReplay *replay, SoupMessage *message, const gchar *path);
+
+G_END_DECLS
@@ -18,6 +18,7 @@
 #include <libsoup/soup.h>
 #include <json-glib/json-glib.h>
 
+#include "mock-catalog.h"
 #include "mock-snapd.h"
 
 struct _MockSnapd
@@ -61,6 +62,8 @@ struct _MockSnapd
     gchar *spawn_time;
     gchar *ready_time;
     SoupMessageHeaders *last_request_headers;
+    MockNetwork *network;
+    MockReplay *replay;
 };
 
 G_DEFINE_TYPE (MockSnapd, mock_snapd, G_TYPE_OBJECT)
@@ -3303,7 +3306,7 @@ handle_sections (MockSnapd *snapd, SoupMessage *message)
 }
 
 static void
-handle_request (SoupServer *server G_GNUC_UNUSED, SoupMessage *message, const gchar *path, GHashTable *query, SoupClientContext *client, gpointer user_data)
+handle_request (SoupServer *server, SoupMessage *message, const gchar *path, GHashTable *query, SoupClientContext *client, gpointer user_data)
 {
     MockSnapd *snapd = MOCK_SNAPD (user_data);
 
@@ -3318,9 +3321,18 @@ handle_request (SoupServer *server G_GNUC_UNUSED, SoupMessage *message, const gc
         return;
     }
 
+    if (!mock_network_begin_request (snapd->network, message, path, client))
+        return;
+
     g_clear_pointer (&snapd->last_request_headers, soup_message_headers_free);
     snapd->last_request_headers = g_boxed_copy (SOUP_TYPE_MESSAGE_HEADERS, message->request_headers);
 
+    if (snapd->replay != NULL) {
+        guint latency = mock_replay_handle_request (snapd->replay, message, path);
+        mock_network_finish_request_with_latency (snapd->network, server, message, path, latency);
+        return;
+    }
+
     if (strcmp (path, "/v2/system-info") == 0)
         handle_system_info (snapd, message);
     else if (strcmp (path, "/v2/snaps") == 0)
@@ -3349,6 +3361,8 @@ handle_request (SoupServer *server G_GNUC_UNUSED, SoupMessage *message, const gc
         handle_sections (snapd, message);
     else
         send_error_not_found (snapd, message, "not found", NULL);
+
+    mock_network_finish_request (snapd->network, server, message, path);
 }
 
 static gboolean
@@ -3406,6 +3420,8 @@ mock_snapd_finalize (GObject *object)
     g_clear_pointer (&snapd->spawn_time, g_free);
     g_clear_pointer (&snapd->ready_time, g_free);
     g_clear_pointer (&snapd->last_request_headers, soup_message_headers_free);
+    g_clear_object (&snapd->network);
+    g_clear_object (&snapd->replay);
     g_clear_pointer (&snapd->context, g_main_context_unref);
     g_clear_pointer (&snapd->loop, g_main_loop_unref);
 
@@ -3477,6 +3493,22 @@ mock_snapd_init_thread (gpointer user_data)
     return NULL;
 }
 
+MockNetwork *
+mock_snapd_get_network (MockSnapd *snapd)
+{
+    g_return_val_if_fail (MOCK_IS_SNAPD (snapd), NULL);
+    return snapd->network;
+}
+
+/* Serve recorded responses instead of the mock store */
+void
+mock_snapd_set_replay (MockSnapd *snapd, MockReplay *replay)
+{
+    g_return_if_fail (MOCK_IS_SNAPD (snapd));
+    g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&snapd->mutex);
+    g_set_object (&snapd->replay, replay);
+}
+
 gboolean
 mock_snapd_start (MockSnapd *snapd, GError **dest_error)
 {
@@ -3549,15 +3581,103 @@ mock_snapd_init (MockSnapd *snapd)
         g_warning ("Failed to make temporary directory: %s", error->message);
     g_clear_error (&error);
     snapd->socket_path = g_build_filename (snapd->dir_path, "snapd.socket", NULL);
+    snapd->network = mock_network_new ();
+}
+
+/* Deterministic catalog of generated store snaps */
+static void
+add_catalog (MockSnapd *snapd, guint32 seed, guint n_snaps)
+{
+    const gchar * const *sections = mock_catalog_get_sections ();
+    for (int i = 0; sections[i] != NULL; i++)
+        mock_snapd_add_store_section (snapd, sections[i]);
+
+    for (guint i = 0; i < n_snaps; i++) {
+        g_autoptr(MockCatalogSnap) catalog_snap = mock_catalog_snap_new (seed, i, 0);
+
+        MockSnap *snap = mock_snapd_add_store_snap (snapd, catalog_snap->name);
+        mock_snap_set_id (snap, catalog_snap->id);
+        mock_snap_set_title (snap, catalog_snap->title);
+        mock_snap_set_summary (snap, catalog_snap->summary);
+        mock_snap_set_description (snap, catalog_snap->description);
+        mock_snap_set_publisher_display_name (snap, catalog_snap->publisher);
+        mock_snap_set_license (snap, catalog_snap->license);
+        mock_snap_add_store_section (snap, catalog_snap->section);
+        if (catalog_snap->featured)
+            mock_snap_add_store_section (snap, "featured");
+
+        mock_snap_add_media (snap, "icon", catalog_snap->icon_url, 256, 256);
+        if (catalog_snap->banner_url != NULL)
+            mock_snap_add_media (snap, "banner", catalog_snap->banner_url, 1920, 640);
+        for (guint j = 0; j < catalog_snap->screenshot_urls->len; j++)
+            mock_snap_add_media (snap, "screenshot", g_ptr_array_index (catalog_snap->screenshot_urls, j), 1280, 720);
+
+        for (guint j = 0; j < catalog_snap->channels->len; j++) {
+            MockCatalogChannel *catalog_channel = g_ptr_array_index (catalog_snap->channels, j);
+            MockTrack *track = mock_snap_add_track (snap, catalog_channel->track);
+            MockChannel *channel = mock_track_add_channel (track, catalog_channel->risk, NULL);
+            mock_channel_set_version (channel, catalog_channel->version);
+            mock_channel_set_revision (channel, catalog_channel->revision);
+            mock_channel_set_released_at (channel, catalog_channel->released_at);
+            mock_channel_set_size (channel, catalog_channel->size);
+        }
+        MockCatalogChannel *stable_channel = g_ptr_array_index (catalog_snap->channels, 0);
+        mock_snap_set_version (snap, stable_channel->version);
+        mock_snap_set_revision (snap, stable_channel->revision);
+    }
 }
 
 int
-main (int argc G_GNUC_UNUSED, char **argv G_GNUC_UNUSED)
+main (int argc, char **argv)
 {
     g_autoptr(GMainLoop) loop = g_main_loop_new (NULL, FALSE);
 
-    g_autoptr(MockSnapd) server = mock_snapd_new ();
+    g_auto(GStrv) network_rules = NULL;
+    gint seed = 0;
+    gint n_snaps = 1000;
+    g_autofree gchar *replay_path = NULL;
+    gdouble replay_timing = 1.0;
+    const GOptionEntry options[] = {
+        { "snaps", 0, 0, G_OPTION_ARG_INT, &n_snaps,
+          "Number of snaps in the store", "COUNT" },
+        { "network", 0, 0, G_OPTION_ARG_STRING_ARRAY, &network_rules,
+          "Simulate network conditions, e.g. /v2/find:latency=500,error-rate=0.1", "[PATH:]NAME=VALUE,..." },
+        { "seed", 0, 0, G_OPTION_ARG_INT, &seed,
+          "Seed for the catalog and random faults", "SEED" },
+        { "replay", 0, 0, G_OPTION_ARG_FILENAME, &replay_path,
+          "Serve the snapd responses recorded with snap-store --record", "FILE" },
+        { "replay-timing", 0, 0, G_OPTION_ARG_DOUBLE, &replay_timing,
+          "Scale recorded response times, 0 to respond immediately", "SCALE" },
+        { NULL }
+    };
+    g_autoptr(GOptionContext) context = g_option_context_new (NULL);
+    g_option_context_add_main_entries (context, options, NULL);
     g_autoptr(GError) error = NULL;
+    if (!g_option_context_parse (context, &argc, &argv, &error)) {
+        g_printerr ("%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+
+    g_autoptr(MockSnapd) server = mock_snapd_new ();
+    if (replay_path != NULL) {
+        g_autoptr(MockReplay) replay = mock_replay_new ();
+        mock_replay_set_timing (replay, replay_timing);
+        if (!mock_replay_load (replay, replay_path, "snapd", &error)) {
+            g_printerr ("Failed to load recording: %s\n", error->message);
+            return EXIT_FAILURE;
+        }
+        mock_snapd_set_replay (server, replay);
+    }
+    else
+        add_catalog (server, seed, MAX (n_snaps, 0));
+    MockNetwork *network = mock_snapd_get_network (server);
+    mock_network_set_seed (network, seed);
+    for (int i = 0; network_rules != NULL && network_rules[i] != NULL; i++) {
+        if (!mock_network_add_rule (network, network_rules[i], &error)) {
+            g_printerr ("Invalid network rule: %s\n", error->message);
+            return EXIT_FAILURE;
+        }
+    }
     if (!mock_snapd_start (server, &error)) {
         g_printerr ("Failed to start server: %s\n", error->message);
         return EXIT_FAILURE;
@@ -12,6 +12,9 @@
 #include <glib-object.h>
 #include <gio/gio.h>
 
+#include "mock-network.h"
+#include "mock-replay.h"
+
 G_BEGIN_DECLS
 
 #define MOCK_TYPE_SNAPD  (mock_snapd_get_type ())
@@ -44,6 +47,10 @@ void           mock_snapd_set_close_on_request       (MockSnapd *snapd, gboolean
 
 void           mock_snapd_set_decline_auth           (MockSnapd *snapd, gboolean decline_auth);
 
+MockNetwork   *mock_snapd_get_network                (MockSnapd *snapd);
+
+void           mock_snapd_set_replay                 (MockSnapd *snapd, MockReplay *replay);
+
 gboolean       mock_snapd_start                      (MockSnapd *snapd, GError **error);
 
 void           mock_snapd_stop                       (MockSnapd *snapd);
@@ -0,0 +1,366 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <stdlib.h>
+#include <json-glib/json-glib.h>
+#include <snapd-glib/snapd-glib.h>
+
+#ifdef HAVE_ALLOC_COUNTER
+#include "alloc-counter.h"
+#endif
+#include "benchmark-baseline.h"
+#include "mock-catalog.h"
+#include "store-model.h"
+#include "store-odrs-ratings.h"
+#include "store-snap-app.h"
+#include "temp-dir.h"
+
+#define N_RESULTS 1000
+#define N_RATINGS 5000
+#define N_RATINGS_ITERATIONS 20
+#define N_ICON_ITERATIONS 200
+#define N_SCREENSHOT_ITERATIONS 20
+
+typedef struct
+{
+    gint64 time;
+    gint64 allocations;
+} Measurement;
+
+/* Results of an earlier run, keyed by benchmark name */
+static GHashTable *baseline = NULL;
+
+static gint64
+get_allocation_count (void)
+{
+#ifdef HAVE_ALLOC_COUNTER
+    return alloc_counter_get_count ();
+#else
+    return -1;
+#endif
+}
+
+static void
+begin (Measurement *measurement)
+{
+    measurement->allocations = get_allocation_count ();
+    measurement->time = g_get_monotonic_time ();
+}
+
+/* Allocations are counted before anything is printed as that allocates too */
+static void
+report (const gchar *benchmark, guint n_ops, Measurement *start, gint notifies)
+{
+    gint64 duration = g_get_monotonic_time () - start->time;
+    gint64 allocations = get_allocation_count () - start->allocations;
+
+    g_autoptr(GString) text = g_string_new (NULL);
+    g_string_append_printf (text, "{\"benchmark\": \"%s\", \"ops\": %u, \"ns-per-op\": %.0f", benchmark, n_ops, (gdouble) duration * 1000 / n_ops);
+    if (start->allocations >= 0)
+        g_string_append_printf (text, ", \"allocs-per-op\": %.2f", (gdouble) allocations / n_ops);
+    else
+        g_string_append (text, ", \"allocs-per-op\": null");
+    if (notifies >= 0)
+        g_string_append_printf (text, ", \"notifies-per-op\": %.2f", (gdouble) notifies / n_ops);
+    const gchar *members[] = { "ns-per-op", "allocs-per-op", "notifies-per-op", NULL };
+    benchmark_baseline_append (baseline, benchmark, members, text);
+    g_string_append (text, "}\n");
+    g_print ("%s", text->str);
+}
+
+static void
+notify_cb (gint *count)
+{
+    (*count)++;
+}
+
+static SnapdMedia *
+make_media (const gchar *type, const gchar *url, guint width, guint height)
+{
+    return g_object_new (SNAPD_TYPE_MEDIA,
+                         "type", type,
+                         "url", url,
+                         "width", width,
+                         "height", height,
+                         NULL);
+}
+
+static SnapdChannel *
+make_channel (MockCatalogChannel *catalog_channel)
+{
+    g_autofree gchar *name = NULL;
+    if (g_strcmp0 (catalog_channel->track, "latest") == 0)
+        name = g_strdup (catalog_channel->risk);
+    else
+        name = g_strdup_printf ("%s/%s", catalog_channel->track, catalog_channel->risk);
+    g_autoptr(GDateTime) released_at = g_date_time_new_from_iso8601 (catalog_channel->released_at, NULL);
+
+    return g_object_new (SNAPD_TYPE_CHANNEL,
+                         "name", name,
+                         "track", catalog_channel->track,
+                         "risk", catalog_channel->risk,
+                         "version", catalog_channel->version,
+                         "revision", catalog_channel->revision,
+                         "size", (gint64) catalog_channel->size,
+                         "released-at", released_at,
+                         NULL);
+}
+
+/* Same snaps as the mock servers, search results don't have channels */
+static SnapdSnap *
+make_snap (guint index, gboolean with_channels)
+{
+    g_autoptr(MockCatalogSnap) catalog_snap = mock_catalog_snap_new (0, index, 0);
+
+    g_autoptr(GPtrArray) media = g_ptr_array_new_with_free_func (g_object_unref);
+    g_ptr_array_add (media, make_media ("icon", catalog_snap->icon_url, 256, 256));
+    if (catalog_snap->banner_url != NULL)
+        g_ptr_array_add (media, make_media ("banner", catalog_snap->banner_url, 1920, 640));
+    for (guint i = 0; i < catalog_snap->screenshot_urls->len; i++)
+        g_ptr_array_add (media, make_media ("screenshot", g_ptr_array_index (catalog_snap->screenshot_urls, i), 1280, 720));
+
+    g_autoptr(GPtrArray) channels = g_ptr_array_new_with_free_func (g_object_unref);
+    g_autoptr(GPtrArray) tracks = g_ptr_array_new ();
+    if (with_channels) {
+        for (guint i = 0; i < catalog_snap->channels->len; i++) {
+            MockCatalogChannel *catalog_channel = g_ptr_array_index (catalog_snap->channels, i);
+            g_ptr_array_add (channels, make_channel (catalog_channel));
+            if (!g_ptr_array_find_with_equal_func (tracks, catalog_channel->track, g_str_equal, NULL))
+                g_ptr_array_add (tracks, catalog_channel->track);
+        }
+    }
+    g_ptr_array_add (tracks, NULL);
+    MockCatalogChannel *stable_channel = g_ptr_array_index (catalog_snap->channels, 0);
+
+    return g_object_new (SNAPD_TYPE_SNAP,
+                         "name", catalog_snap->name,
+                         "id", catalog_snap->id,
+                         "title", catalog_snap->title,
+                         "summary", catalog_snap->summary,
+                         "description", catalog_snap->description,
+                         "version", stable_channel->version,
+                         "license", catalog_snap->license,
+                         "publisher-display-name", catalog_snap->publisher,
+                         "publisher-username", "publisher",
+                         "publisher-validation", SNAPD_PUBLISHER_VALIDATION_VERIFIED,
+                         "contact", "mailto:publisher@example.com",
+                         "channels", channels,
+                         "tracks", tracks->pdata,
+                         "media", media,
+                         NULL);
+}
+
+static GPtrArray *
+make_apps (gint *notifies)
+{
+    GPtrArray *apps = g_ptr_array_new_with_free_func (g_object_unref);
+    for (guint i = 0; i < N_RESULTS; i++) {
+        StoreSnapApp *app = store_snap_app_new ();
+        if (notifies != NULL)
+            g_signal_connect_swapped (app, "notify", G_CALLBACK (notify_cb), notifies);
+        g_ptr_array_add (apps, app);
+    }
+    return apps;
+}
+
+/* Counts property notifications per search result, which is what drives the
+ * number of binding callbacks in the app tiles */
+static void
+benchmark_update_from_search (void)
+{
+    g_autoptr(GPtrArray) snaps = g_ptr_array_new_with_free_func (g_object_unref);
+    for (guint i = 0; i < N_RESULTS; i++)
+        g_ptr_array_add (snaps, make_snap (i, FALSE));
+    gint notifies = 0;
+    g_autoptr(GPtrArray) apps = make_apps (&notifies);
+
+    Measurement start;
+    begin (&start);
+    for (guint i = 0; i < N_RESULTS; i++)
+        store_snap_app_update_from_search (g_ptr_array_index (apps, i), g_ptr_array_index (snaps, i));
+    report ("update-from-search-new", N_RESULTS, &start, notifies);
+
+    /* Same results again, as happens when a search or category is refreshed */
+    notifies = 0;
+    begin (&start);
+    for (guint i = 0; i < N_RESULTS; i++)
+        store_snap_app_update_from_search (g_ptr_array_index (apps, i), g_ptr_array_index (snaps, i));
+    report ("update-from-search-unchanged", N_RESULTS, &start, notifies);
+}
+
+/* Details for a single snap include the channel map, which is sorted with compare_channel */
+static void
+benchmark_update_from_details (void)
+{
+    g_autoptr(GPtrArray) snaps = g_ptr_array_new_with_free_func (g_object_unref);
+    for (guint i = 0; i < N_RESULTS; i++)
+        g_ptr_array_add (snaps, make_snap (i, TRUE));
+    g_autoptr(GPtrArray) apps = make_apps (NULL);
+
+    Measurement start;
+    begin (&start);
+    for (guint i = 0; i < N_RESULTS; i++)
+        store_snap_app_update_from_search (g_ptr_array_index (apps, i), g_ptr_array_index (snaps, i));
+    report ("update-from-details", N_RESULTS, &start, -1);
+}
+
+static void
+benchmark_cache (void)
+{
+    g_autoptr(StoreCache) cache = store_cache_new ();
+    g_autoptr(GPtrArray) apps = make_apps (NULL);
+    for (guint i = 0; i < N_RESULTS; i++) {
+        g_autoptr(SnapdSnap) snap = make_snap (i, TRUE);
+        store_snap_app_update_from_search (g_ptr_array_index (apps, i), snap);
+    }
+
+    Measurement start;
+    begin (&start);
+    for (guint i = 0; i < N_RESULTS; i++)
+        store_app_save_to_cache (g_ptr_array_index (apps, i), cache);
+    report ("save-to-cache", N_RESULTS, &start, -1);
+
+    g_autoptr(GPtrArray) cached_apps = make_apps (NULL);
+    for (guint i = 0; i < N_RESULTS; i++)
+        store_app_set_name (g_ptr_array_index (cached_apps, i), store_app_get_name (g_ptr_array_index (apps, i)));
+
+    begin (&start);
+    for (guint i = 0; i < N_RESULTS; i++)
+        store_app_update_from_cache (g_ptr_array_index (cached_apps, i), cache);
+    report ("update-from-cache", N_RESULTS, &start, -1);
+}
+
+/* Fed in the same size chunks as the ODRS client reads them */
+static void
+benchmark_ratings (void)
+{
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+    json_builder_begin_object (builder);
+    for (guint i = 0; i < N_RATINGS; i++) {
+        g_autoptr(MockCatalogSnap) catalog_snap = mock_catalog_snap_new (0, i, 0);
+        json_builder_set_member_name (builder, catalog_snap->appstream_id);
+        json_builder_begin_object (builder);
+        gint64 total = 0;
+        for (gsize j = 0; j < G_N_ELEMENTS (catalog_snap->star_counts); j++) {
+            g_autofree gchar *name = g_strdup_printf ("star%zu", j);
+            json_builder_set_member_name (builder, name);
+            json_builder_add_int_value (builder, catalog_snap->star_counts[j]);
+            total += catalog_snap->star_counts[j];
+        }
+        json_builder_set_member_name (builder, "total");
+        json_builder_add_int_value (builder, total);
+        json_builder_end_object (builder);
+    }
+    json_builder_end_object (builder);
+    g_autoptr(JsonGenerator) generator = json_generator_new ();
+    g_autoptr(JsonNode) root = json_builder_get_root (builder);
+    json_generator_set_root (generator, root);
+    gsize length;
+    g_autofree gchar *data = json_generator_to_data (generator, &length);
+
+    Measurement start;
+    begin (&start);
+    for (guint i = 0; i < N_RATINGS_ITERATIONS; i++) {
+        g_autoptr(StoreOdrsRatings) ratings = store_odrs_ratings_new ();
+        for (gsize offset = 0; offset < length; offset += 65535)
+            store_odrs_ratings_feed (ratings, data + offset, MIN (length - offset, 65535), NULL);
+        g_autoptr(GError) error = NULL;
+        if (!store_odrs_ratings_complete (ratings, &error))
+            g_printerr ("Failed to parse ratings: %s\n", error->message);
+    }
+    report ("ratings-parse-per-app", N_RATINGS_ITERATIONS * N_RATINGS, &start, -1);
+}
+
+/* A gradient with noise, so it compresses more like a real image than a flat colour */
+static GBytes *
+make_png (gint width, gint height)
+{
+    g_autoptr(GdkPixbuf) pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, width, height);
+    g_autoptr(GRand) rand = g_rand_new_with_seed (0);
+    guint8 *pixels = gdk_pixbuf_get_pixels (pixbuf);
+    gint rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+    for (gint y = 0; y < height; y++) {
+        for (gint x = 0; x < width; x++) {
+            guint8 *pixel = pixels + y * rowstride + x * 4;
+            pixel[0] = x * 255 / width;
+            pixel[1] = y * 255 / height;
+            pixel[2] = g_rand_int_range (rand, 0, 32);
+            pixel[3] = 255;
+        }
+    }
+
+    gchar *buffer;
+    gsize buffer_length;
+    g_autoptr(GError) error = NULL;
+    if (!gdk_pixbuf_save_to_buffer (pixbuf, &buffer, &buffer_length, "png", &error, NULL)) {
+        g_printerr ("Failed to make image: %s\n", error->message);
+        return NULL;
+    }
+
+    return g_bytes_new_take (buffer, buffer_length);
+}
+
+static void
+benchmark_decode_image (const gchar *benchmark, gint width, gint height, gint scaled_width, gint scaled_height, guint n_iterations)
+{
+    g_autoptr(GBytes) data = make_png (width, height);
+    if (data == NULL)
+        return;
+
+    Measurement start;
+    begin (&start);
+    for (guint i = 0; i < n_iterations; i++) {
+        g_autoptr(GError) error = NULL;
+        g_autoptr(GdkPixbuf) pixbuf = store_model_decode_image (data, scaled_width, scaled_height, NULL, NULL, &error);
+        if (pixbuf == NULL)
+            g_printerr ("Failed to decode image: %s\n", error->message);
+    }
+    report (benchmark, n_iterations, &start, -1);
+}
+
+int
+main (int argc, char **argv)
+{
+    g_autofree gchar *baseline_path = NULL;
+    const GOptionEntry options[] = {
+        { "baseline", 0, 0, G_OPTION_ARG_FILENAME, &baseline_path,
+          "Output of an earlier run to report alongside the results", "FILE" },
+        { NULL }
+    };
+    g_autoptr(GOptionContext) context = g_option_context_new (NULL);
+    g_option_context_add_main_entries (context, options, NULL);
+    g_autoptr(GError) error = NULL;
+    if (!g_option_context_parse (context, &argc, &argv, &error)) {
+        g_printerr ("%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    if (baseline_path != NULL && (baseline = benchmark_baseline_load (baseline_path, &error)) == NULL) {
+        g_printerr ("Failed to load baseline: %s\n", error->message);
+        return EXIT_FAILURE;
+    }
+
+    /* Keep the cache benchmarks away from the real cache */
+    g_autofree gchar *cache_dir = temp_dir_new_cache (&error);
+    if (cache_dir == NULL) {
+        g_printerr ("Failed to make temporary directory: %s\n", error->message);
+        return EXIT_FAILURE;
+    }
+
+    benchmark_update_from_search ();
+    benchmark_update_from_details ();
+    benchmark_cache ();
+    benchmark_ratings ();
+    benchmark_decode_image ("decode-icon", 512, 512, 64, 64, N_ICON_ITERATIONS);
+    benchmark_decode_image ("decode-screenshot", 1920, 1080, 800, 450, N_SCREENSHOT_ITERATIONS);
+
+    temp_dir_remove (cache_dir);
+    g_clear_pointer (&baseline, g_hash_table_unref);
+
+    return EXIT_SUCCESS;
+}
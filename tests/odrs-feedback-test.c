@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "mock-odrs-server.h"
+#include "store-cache.h"
+#include "store-http.h"
+#include "store-odrs-client.h"
+#include "temp-dir.h"
+
+#define APP_ID "io.snapcraft.test"
+
+/* Nothing listens here, so connections are refused */
+#define UNREACHABLE_URI "http://127.0.0.1:1"
+
+typedef struct
+{
+    StoreCache *cache;
+    StoreHttp *http;
+    MockOdrsServer *server;
+    MockReview *review;
+    gchar *server_uri;
+} Fixture;
+
+typedef struct
+{
+    gboolean done;
+    GError *error;
+} Result;
+
+static void
+save_queue (Fixture *fixture, const gchar *json)
+{
+    g_autoptr(GError) error = NULL;
+    g_autoptr(JsonNode) node = json_from_string (json, &error);
+    g_assert_no_error (error);
+    store_cache_insert_json (fixture->cache, "odrs", "feedback", FALSE, node, NULL, &error);
+    g_assert_no_error (error);
+}
+
+/* Returns G_MAXUINT until the client has saved a queue */
+static guint
+get_queue_length (Fixture *fixture)
+{
+    g_autoptr(JsonNode) node = store_cache_lookup_json (fixture->cache, "odrs", "feedback", FALSE, NULL, NULL);
+    g_assert_nonnull (node);
+    if (json_node_get_node_type (node) != JSON_NODE_ARRAY)
+        return G_MAXUINT;
+    return json_array_get_length (json_node_get_array (node));
+}
+
+/* The queue is saved in a thread, so wait for it to be written */
+static void
+wait_for_queue_length (Fixture *fixture, guint length)
+{
+    while (get_queue_length (fixture) != length)
+        g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+fixture_set_up (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    fixture->cache = store_cache_new ();
+    save_queue (fixture, "null");
+
+    fixture->http = store_http_new ();
+
+    fixture->server = mock_odrs_server_new ();
+    MockApp *app = mock_odrs_server_add_app (fixture->server, APP_ID);
+    fixture->review = mock_app_add_review (app);
+    g_autoptr(GError) error = NULL;
+    mock_odrs_server_start (fixture->server, &error);
+    g_assert_no_error (error);
+    fixture->server_uri = g_strdup_printf ("http://127.0.0.1:%u", mock_odrs_server_get_port (fixture->server));
+}
+
+static void
+fixture_tear_down (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    g_clear_object (&fixture->cache);
+    g_clear_object (&fixture->http);
+    g_clear_object (&fixture->server);
+    g_clear_pointer (&fixture->server_uri, g_free);
+}
+
+static StoreOdrsClient *
+new_client (Fixture *fixture, const gchar *server_uri, StoreCache *cache)
+{
+    StoreOdrsClient *client = store_odrs_client_new ();
+    store_odrs_client_set_http (client, fixture->http);
+    store_odrs_client_set_server_uri (client, server_uri);
+    store_odrs_client_set_cache (client, cache);
+    return client;
+}
+
+static void
+upvote_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    Result *r = user_data;
+    store_odrs_client_upvote_finish (STORE_ODRS_CLIENT (object), result, &r->error);
+    r->done = TRUE;
+}
+
+static void
+downvote_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    Result *r = user_data;
+    store_odrs_client_downvote_finish (STORE_ODRS_CLIENT (object), result, &r->error);
+    r->done = TRUE;
+}
+
+/* Feedback is sent after a short delay, so this takes a couple of seconds */
+static void
+wait_for_result (Result *result)
+{
+    while (!result->done)
+        g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+test_send (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    g_autoptr(StoreOdrsClient) client = new_client (fixture, fixture->server_uri, fixture->cache);
+
+    Result result = { 0 };
+    store_odrs_client_upvote_async (client, "skey", APP_ID, 0, NULL, upvote_cb, &result);
+
+    /* Saved straight away in case snap-store exits before it is sent */
+    wait_for_queue_length (fixture, 1);
+
+    wait_for_result (&result);
+    g_assert_no_error (result.error);
+    g_assert_cmpint (mock_review_get_upvote_count (fixture->review), ==, 1);
+    wait_for_queue_length (fixture, 0);
+}
+
+static void
+test_supersede (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    g_autoptr(StoreOdrsClient) client = new_client (fixture, fixture->server_uri, fixture->cache);
+
+    /* Changing a vote before it is sent only sends the last one */
+    Result upvote_result = { 0 }, downvote_result = { 0 };
+    store_odrs_client_upvote_async (client, "skey", APP_ID, 0, NULL, upvote_cb, &upvote_result);
+    store_odrs_client_downvote_async (client, "skey", APP_ID, 0, NULL, downvote_cb, &downvote_result);
+    wait_for_queue_length (fixture, 1);
+
+    wait_for_result (&upvote_result);
+    wait_for_result (&downvote_result);
+    g_assert_no_error (upvote_result.error);
+    g_assert_no_error (downvote_result.error);
+    g_assert_cmpint (mock_review_get_upvote_count (fixture->review), ==, 0);
+    g_assert_cmpint (mock_review_get_downvote_count (fixture->review), ==, 1);
+    wait_for_queue_length (fixture, 0);
+}
+
+static void
+test_send_failed (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    g_autoptr(StoreOdrsClient) client = new_client (fixture, UNREACHABLE_URI, fixture->cache);
+
+    g_test_expect_message (NULL, G_LOG_LEVEL_WARNING, "Failed to send ODRS upvote*");
+    Result result = { 0 };
+    store_odrs_client_upvote_async (client, "skey", APP_ID, 0, NULL, upvote_cb, &result);
+    wait_for_result (&result);
+    g_test_assert_expected_messages ();
+
+    /* The caller is told, but it stays queued to be sent later */
+    g_assert_nonnull (result.error);
+    g_clear_error (&result.error);
+    wait_for_queue_length (fixture, 1);
+}
+
+static void
+test_server_error (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    g_autoptr(GError) error = NULL;
+    mock_network_add_rule (mock_odrs_server_get_network (fixture->server), "error-rate=1", &error);
+    g_assert_no_error (error);
+
+    g_autoptr(StoreOdrsClient) client = new_client (fixture, fixture->server_uri, fixture->cache);
+
+    g_test_expect_message (NULL, G_LOG_LEVEL_WARNING, "Failed to send ODRS upvote*");
+    Result result = { 0 };
+    store_odrs_client_upvote_async (client, "skey", APP_ID, 0, NULL, upvote_cb, &result);
+    wait_for_result (&result);
+    g_test_assert_expected_messages ();
+
+    /* The server failed, so it stays queued to be sent later */
+    g_assert_error (result.error, G_IO_ERROR, G_IO_ERROR_FAILED);
+    g_clear_error (&result.error);
+    wait_for_queue_length (fixture, 1);
+}
+
+static void
+test_rejected (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    g_autoptr(StoreOdrsClient) client = new_client (fixture, fixture->server_uri, fixture->cache);
+
+    g_test_expect_message (NULL, G_LOG_LEVEL_WARNING, "Dropping ODRS upvote*");
+    Result result = { 0 };
+    store_odrs_client_upvote_async (client, "skey", APP_ID, 99, NULL, upvote_cb, &result);
+    wait_for_result (&result);
+    g_test_assert_expected_messages ();
+
+    /* No such review, sending it again would get the same answer */
+    g_assert_error (result.error, G_IO_ERROR, G_IO_ERROR_FAILED);
+    g_clear_error (&result.error);
+    wait_for_queue_length (fixture, 0);
+}
+
+static void
+test_invalid_uri (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    g_autoptr(StoreOdrsClient) client = new_client (fixture, "invalid", fixture->cache);
+
+    g_test_expect_message (NULL, G_LOG_LEVEL_WARNING, "Dropping ODRS upvote*");
+    Result result = { 0 };
+    store_odrs_client_upvote_async (client, "skey", APP_ID, 0, NULL, upvote_cb, &result);
+    wait_for_result (&result);
+    g_test_assert_expected_messages ();
+
+    /* Can never be sent, so isn't kept */
+    g_assert_error (result.error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT);
+    g_clear_error (&result.error);
+    wait_for_queue_length (fixture, 0);
+}
+
+static gchar *
+make_saved_upvote (Fixture *fixture)
+{
+    return g_strdup_printf ("[{\"server-uri\": \"%s\", \"method\": \"upvote\","
+                            " \"request\": {\"user_hash\": \"hash\", \"user_skey\": \"skey\", \"app_id\": \"%s\", \"review_id\": 0}}]",
+                            fixture->server_uri, APP_ID);
+}
+
+static void
+test_resend_saved (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    /* Left over from a previous run */
+    g_autofree gchar *saved = make_saved_upvote (fixture);
+    save_queue (fixture, saved);
+
+    g_autoptr(StoreOdrsClient) client = new_client (fixture, fixture->server_uri, fixture->cache);
+    wait_for_queue_length (fixture, 0);
+
+    g_assert_cmpint (mock_review_get_upvote_count (fixture->review), ==, 1);
+}
+
+static void
+test_saved_already_queued (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    g_autofree gchar *saved = make_saved_upvote (fixture);
+    save_queue (fixture, saved);
+
+    /* Queued before the saved queue is loaded, the saved copy isn't sent as well */
+    g_autoptr(StoreOdrsClient) client = new_client (fixture, fixture->server_uri, NULL);
+    Result result = { 0 };
+    store_odrs_client_upvote_async (client, "skey", APP_ID, 0, NULL, upvote_cb, &result);
+    store_odrs_client_set_cache (client, fixture->cache);
+
+    wait_for_result (&result);
+    g_assert_no_error (result.error);
+    wait_for_queue_length (fixture, 0);
+    g_assert_cmpint (mock_review_get_upvote_count (fixture->review), ==, 1);
+}
+
+int
+main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    /* Feedback is sent with a hash of the machine ID, 77 tells meson the test was skipped */
+    if (!g_file_test ("/etc/machine-id", G_FILE_TEST_EXISTS)) {
+        g_printerr ("No /etc/machine-id, skipping\n");
+        return 77;
+    }
+
+    g_autoptr(GError) error = NULL;
+    g_autofree gchar *cache_dir = temp_dir_new_cache (&error);
+    g_assert_no_error (error);
+
+    g_test_add ("/odrs-feedback/send", Fixture, NULL, fixture_set_up, test_send, fixture_tear_down);
+    g_test_add ("/odrs-feedback/supersede", Fixture, NULL, fixture_set_up, test_supersede, fixture_tear_down);
+    g_test_add ("/odrs-feedback/send-failed", Fixture, NULL, fixture_set_up, test_send_failed, fixture_tear_down);
+    g_test_add ("/odrs-feedback/server-error", Fixture, NULL, fixture_set_up, test_server_error, fixture_tear_down);
+    g_test_add ("/odrs-feedback/rejected", Fixture, NULL, fixture_set_up, test_rejected, fixture_tear_down);
+    g_test_add ("/odrs-feedback/invalid-uri", Fixture, NULL, fixture_set_up, test_invalid_uri, fixture_tear_down);
+    g_test_add ("/odrs-feedback/resend-saved", Fixture, NULL, fixture_set_up, test_resend_saved, fixture_tear_down);
+    g_test_add ("/odrs-feedback/saved-already-queued", Fixture, NULL, fixture_set_up, test_saved_already_queued, fixture_tear_down);
+
+    int result = g_test_run ();
+    temp_dir_remove (cache_dir);
+
+    return result;
+}
@@ -0,0 +1,229 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <string.h>
+
+#include "store-odrs-ratings.h"
+
+/* Apps out of order, with members and values the parser has to skip over */
+static const gchar *FEED =
+    "{\n"
+    "  \"zoom.desktop\": {\"star0\": 7, \"star1\": 1, \"star2\": 2, \"star3\": 3, \"star4\": 4, \"star5\": 5, \"total\": 15},\n"
+    "  \"caf\\u00e9.desktop\": {\"star\\u0031\": 10, \"star5\": 2.7, \"extra\": [1, {\"star1\": 99}, \"}\"], \"flag\": true, \"none\": null},\n"
+    "  \"smile\\ud83d\\ude00.desktop\": {\"star4\": -3, \"star5\": 1e12},\n"
+    "  \"escaped\\\"quote\\\\.desktop\": {\"star2\": 8},\n"
+    "  \"not-an-app\": 42,\n"
+    "  \"apple.desktop\": {}\n"
+    "}\n";
+
+static void
+assert_counts (StoreOdrsRatings *ratings, const gchar *app_id, guint32 star1, guint32 star2, guint32 star3, guint32 star4, guint32 star5)
+{
+    const guint32 *counts = store_odrs_ratings_lookup (ratings, app_id);
+    g_assert_nonnull (counts);
+    g_assert_cmpuint (counts[0], ==, star1);
+    g_assert_cmpuint (counts[1], ==, star2);
+    g_assert_cmpuint (counts[2], ==, star3);
+    g_assert_cmpuint (counts[3], ==, star4);
+    g_assert_cmpuint (counts[4], ==, star5);
+}
+
+static void
+assert_feed_ratings (StoreOdrsRatings *ratings)
+{
+    g_assert_cmpuint (store_odrs_ratings_get_length (ratings), ==, 5);
+
+    /* star0 is reviews without a rating, so isn't kept */
+    assert_counts (ratings, "zoom.desktop", 1, 2, 3, 4, 5);
+
+    /* Fractions are dropped and nested members ignored */
+    assert_counts (ratings, "caf\xc3\xa9.desktop", 10, 0, 0, 0, 2);
+
+    /* Counts are clamped to what fits */
+    assert_counts (ratings, "smile\xf0\x9f\x98\x80.desktop", 0, 0, 0, 0, G_MAXUINT32);
+
+    assert_counts (ratings, "escaped\"quote\\.desktop", 0, 8, 0, 0, 0);
+    assert_counts (ratings, "apple.desktop", 0, 0, 0, 0, 0);
+
+    g_assert_null (store_odrs_ratings_lookup (ratings, "not-an-app"));
+    g_assert_null (store_odrs_ratings_lookup (ratings, "missing.desktop"));
+    g_assert_null (store_odrs_ratings_lookup (ratings, ""));
+}
+
+static StoreOdrsRatings *
+parse (const gchar *data, gsize chunk_size)
+{
+    StoreOdrsRatings *ratings = store_odrs_ratings_new ();
+
+    g_autoptr(GError) error = NULL;
+    gsize length = strlen (data);
+    for (gsize offset = 0; offset < length; offset += chunk_size) {
+        store_odrs_ratings_feed (ratings, data + offset, MIN (chunk_size, length - offset), &error);
+        g_assert_no_error (error);
+    }
+    store_odrs_ratings_complete (ratings, &error);
+    g_assert_no_error (error);
+
+    return ratings;
+}
+
+static void
+test_parse (void)
+{
+    g_autoptr(StoreOdrsRatings) ratings = parse (FEED, strlen (FEED));
+    assert_feed_ratings (ratings);
+}
+
+static void
+test_parse_chunks (void)
+{
+    /* Tokens split across every possible boundary */
+    for (gsize chunk_size = 1; chunk_size < 8; chunk_size++) {
+        g_autoptr(StoreOdrsRatings) ratings = parse (FEED, chunk_size);
+        assert_feed_ratings (ratings);
+    }
+}
+
+static void
+test_parse_empty (void)
+{
+    g_autoptr(StoreOdrsRatings) ratings = parse (" {} ", 4);
+    g_assert_cmpuint (store_odrs_ratings_get_length (ratings), ==, 0);
+    g_assert_null (store_odrs_ratings_lookup (ratings, "zoom.desktop"));
+}
+
+static void
+test_parse_duplicates (void)
+{
+    /* The last entry for an app wins */
+    g_autoptr(StoreOdrsRatings) ratings = parse ("{\"b\": {\"star1\": 1}, \"a\": {\"star1\": 2}, \"b\": {\"star1\": 3}}", 64);
+    g_assert_cmpuint (store_odrs_ratings_get_length (ratings), ==, 2);
+    assert_counts (ratings, "a", 2, 0, 0, 0, 0);
+    assert_counts (ratings, "b", 3, 0, 0, 0, 0);
+}
+
+static void
+test_parse_invalid (void)
+{
+    const gchar *invalid[] = {
+        "",
+        "1",
+        ",",
+        "[]",
+        "{",
+        "{}}",
+        "{}{}",
+        "{1: {}}",
+        "{\"a\": @}",
+        "{\"a\": nope}",
+        "{\"a\": {\"star1\": 1}",
+        "{\"a\": [}]}",
+        "{\"a\\u12G4\": {}}",
+        "{\"a\": {}",
+        NULL
+    };
+
+    for (int i = 0; invalid[i] != NULL; i++) {
+        g_autoptr(StoreOdrsRatings) ratings = store_odrs_ratings_new ();
+        g_autoptr(GError) error = NULL;
+        if (store_odrs_ratings_feed (ratings, invalid[i], strlen (invalid[i]), &error))
+            store_odrs_ratings_complete (ratings, &error);
+        g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+    }
+}
+
+static void
+test_bytes (void)
+{
+    g_autoptr(StoreOdrsRatings) ratings = parse (FEED, strlen (FEED));
+    store_odrs_ratings_set_etag (ratings, "\"abc123\"");
+    store_odrs_ratings_set_last_modified (ratings, "Tue, 15 Nov 1994 12:45:26 GMT");
+
+    g_autoptr(GBytes) data = store_odrs_ratings_to_bytes (ratings);
+    g_autoptr(GError) error = NULL;
+    g_autoptr(StoreOdrsRatings) loaded = store_odrs_ratings_new_from_bytes (data, &error);
+    g_assert_no_error (error);
+    g_assert_nonnull (loaded);
+
+    assert_feed_ratings (loaded);
+    g_assert_cmpstr (store_odrs_ratings_get_etag (loaded), ==, "\"abc123\"");
+    g_assert_cmpstr (store_odrs_ratings_get_last_modified (loaded), ==, "Tue, 15 Nov 1994 12:45:26 GMT");
+}
+
+static void
+test_bytes_empty (void)
+{
+    g_autoptr(StoreOdrsRatings) ratings = parse ("{}", 2);
+
+    g_autoptr(GBytes) data = store_odrs_ratings_to_bytes (ratings);
+    g_autoptr(GError) error = NULL;
+    g_autoptr(StoreOdrsRatings) loaded = store_odrs_ratings_new_from_bytes (data, &error);
+    g_assert_no_error (error);
+    g_assert_nonnull (loaded);
+
+    g_assert_cmpuint (store_odrs_ratings_get_length (loaded), ==, 0);
+    g_assert_null (store_odrs_ratings_get_etag (loaded));
+    g_assert_null (store_odrs_ratings_get_last_modified (loaded));
+}
+
+static void
+assert_invalid_bytes (const guint8 *data, gsize length)
+{
+    g_autoptr(GBytes) bytes = g_bytes_new (data, length);
+    g_autoptr(GError) error = NULL;
+    g_autoptr(StoreOdrsRatings) loaded = store_odrs_ratings_new_from_bytes (bytes, &error);
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+    g_assert_null (loaded);
+}
+
+static void
+test_bytes_invalid (void)
+{
+    g_autoptr(StoreOdrsRatings) ratings = parse (FEED, strlen (FEED));
+    g_autoptr(GBytes) data = store_odrs_ratings_to_bytes (ratings);
+    gsize length;
+    const guint8 *contents = g_bytes_get_data (data, &length);
+    g_autofree guint8 *copy = g_malloc (length);
+    memcpy (copy, contents, length);
+
+    /* Truncated, in the header and in the table */
+    assert_invalid_bytes (copy, 4);
+    assert_invalid_bytes (copy, length - 1);
+
+    /* Trailing data */
+    g_autofree guint8 *extended = g_malloc0 (length + 1);
+    memcpy (extended, contents, length);
+    assert_invalid_bytes (extended, length + 1);
+
+    /* Unterminated IDs */
+    copy[length - 1] = 'x';
+    assert_invalid_bytes (copy, length);
+    copy[length - 1] = '\0';
+
+    /* Unknown format */
+    copy[0] = 'X';
+    assert_invalid_bytes (copy, length);
+}
+
+int
+main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/odrs-ratings/parse", test_parse);
+    g_test_add_func ("/odrs-ratings/parse-chunks", test_parse_chunks);
+    g_test_add_func ("/odrs-ratings/parse-empty", test_parse_empty);
+    g_test_add_func ("/odrs-ratings/parse-duplicates", test_parse_duplicates);
+    g_test_add_func ("/odrs-ratings/parse-invalid", test_parse_invalid);
+    g_test_add_func ("/odrs-ratings/bytes", test_bytes);
+    g_test_add_func ("/odrs-ratings/bytes-empty", test_bytes_empty);
+    g_test_add_func ("/odrs-ratings/bytes-invalid", test_bytes_invalid);
+
+    return g_test_run ();
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "mock-odrs-server.h"
+#include "store-http.h"
+#include "store-odrs-client.h"
+
+#define APP_ID "io.snapcraft.test"
+
+typedef struct
+{
+    StoreHttp *http;
+    MockOdrsServer *server;
+    MockApp *app;
+    StoreOdrsClient *client;
+} Fixture;
+
+static StoreOdrsClient *
+new_client (Fixture *fixture)
+{
+    g_autofree gchar *server_uri = g_strdup_printf ("http://127.0.0.1:%u", mock_odrs_server_get_port (fixture->server));
+    StoreOdrsClient *client = store_odrs_client_new ();
+    store_odrs_client_set_http (client, fixture->http);
+    store_odrs_client_set_server_uri (client, server_uri);
+    return client;
+}
+
+static void
+fixture_set_up (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    fixture->http = store_http_new ();
+
+    fixture->server = mock_odrs_server_new ();
+    fixture->app = mock_odrs_server_add_app (fixture->server, APP_ID);
+    mock_app_set_star_count (fixture->app, 5, 10);
+    g_autoptr(GError) error = NULL;
+    mock_odrs_server_start (fixture->server, &error);
+    g_assert_no_error (error);
+
+    fixture->client = new_client (fixture);
+}
+
+static void
+fixture_tear_down (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    g_clear_object (&fixture->client);
+    g_clear_object (&fixture->http);
+    g_clear_object (&fixture->server);
+}
+
+static void
+update_ratings_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    gboolean *done = user_data;
+
+    g_autoptr(GError) error = NULL;
+    store_odrs_client_update_ratings_finish (STORE_ODRS_CLIENT (object), result, &error);
+    g_assert_no_error (error);
+    *done = TRUE;
+}
+
+static StoreOdrsRatings *
+update_ratings (Fixture *fixture)
+{
+    gboolean done = FALSE;
+    store_odrs_client_update_ratings_async (fixture->client, NULL, update_ratings_cb, &done);
+    while (!done)
+        g_main_context_iteration (NULL, TRUE);
+
+    StoreOdrsRatings *ratings = store_odrs_client_get_ratings_table (fixture->client);
+    g_assert_nonnull (ratings);
+    return ratings;
+}
+
+static void
+assert_five_stars (Fixture *fixture, guint32 count)
+{
+    const guint32 *counts = store_odrs_client_get_ratings (fixture->client, APP_ID);
+    g_assert_nonnull (counts);
+    g_assert_cmpuint (counts[4], ==, count);
+}
+
+static void
+test_update (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    StoreOdrsRatings *ratings = update_ratings (fixture);
+    assert_five_stars (fixture, 10);
+
+    /* Kept so the next update can be conditional */
+    g_assert_nonnull (store_odrs_ratings_get_etag (ratings));
+}
+
+static void
+test_not_modified (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    StoreOdrsRatings *ratings = update_ratings (fixture);
+
+    /* The server returns 304, so the existing table is kept rather than downloaded again */
+    g_assert_true (update_ratings (fixture) == ratings);
+    assert_five_stars (fixture, 10);
+}
+
+static void
+test_modified (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    g_autoptr(StoreOdrsRatings) ratings = g_object_ref (update_ratings (fixture));
+    g_autofree gchar *etag = g_strdup (store_odrs_ratings_get_etag (ratings));
+
+    mock_app_set_star_count (fixture->app, 5, 11);
+    StoreOdrsRatings *updated_ratings = update_ratings (fixture);
+    g_assert_true (updated_ratings != ratings);
+    g_assert_cmpstr (store_odrs_ratings_get_etag (updated_ratings), !=, etag);
+    assert_five_stars (fixture, 11);
+}
+
+static void
+test_cached (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    g_autoptr(StoreOdrsRatings) ratings = g_object_ref (update_ratings (fixture));
+
+    /* A table loaded from the cache on the next run is revalidated the same way */
+    g_autoptr(GBytes) data = store_odrs_ratings_to_bytes (ratings);
+    g_autoptr(GError) error = NULL;
+    g_autoptr(StoreOdrsRatings) loaded = store_odrs_ratings_new_from_bytes (data, &error);
+    g_assert_no_error (error);
+
+    g_clear_object (&fixture->client);
+    fixture->client = new_client (fixture);
+    store_odrs_client_set_ratings_table (fixture->client, loaded);
+
+    g_assert_true (update_ratings (fixture) == loaded);
+    assert_five_stars (fixture, 10);
+}
+
+int
+main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    /* The client hashes the machine ID, 77 tells meson the test was skipped */
+    if (!g_file_test ("/etc/machine-id", G_FILE_TEST_EXISTS)) {
+        g_printerr ("No /etc/machine-id, skipping\n");
+        return 77;
+    }
+
+    g_test_add ("/odrs-ratings-update/update", Fixture, NULL, fixture_set_up, test_update, fixture_tear_down);
+    g_test_add ("/odrs-ratings-update/not-modified", Fixture, NULL, fixture_set_up, test_not_modified, fixture_tear_down);
+    g_test_add ("/odrs-ratings-update/modified", Fixture, NULL, fixture_set_up, test_modified, fixture_tear_down);
+    g_test_add ("/odrs-ratings-update/cached", Fixture, NULL, fixture_set_up, test_cached, fixture_tear_down);
+
+    return g_test_run ();
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <stdlib.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include <json-glib/json-glib.h>
+
+#include "mock-odrs-server.h"
+#include "store-odrs-client.h"
+#include "store-odrs-ratings.h"
+
+#define N_APPS 50000
+
+static gint64
+get_heap_size (void)
+{
+#ifdef __GLIBC__
+#if __GLIBC_PREREQ (2, 33)
+    return mallinfo2 ().uordblks;
+#endif
+#endif
+    return -1;
+}
+
+static void
+report (const gchar *benchmark, gint64 duration, gint64 retained)
+{
+    g_print ("{\"benchmark\": \"%s\", \"apps\": %d, \"ns\": %" G_GINT64_FORMAT ", \"retained-bytes\": %" G_GINT64_FORMAT "}\n",
+             benchmark, N_APPS, duration * 1000, retained);
+}
+
+static void
+feed_cb (SoupSession *session G_GNUC_UNUSED, SoupMessage *msg G_GNUC_UNUSED, gpointer user_data)
+{
+    g_main_loop_quit (user_data);
+}
+
+static void
+ratings_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GError) error = NULL;
+    if (!store_odrs_client_update_ratings_finish (STORE_ODRS_CLIENT (object), result, &error))
+        g_printerr ("Failed to get ratings: %s\n", error->message);
+    g_main_loop_quit (user_data);
+}
+
+/* The way ratings were loaded before StoreOdrsRatings, kept as a baseline */
+static GHashTable *
+parse_dom (const gchar *data, gsize length)
+{
+    g_autoptr(JsonParser) parser = json_parser_new ();
+    if (!json_parser_load_from_data (parser, data, length, NULL))
+        return NULL;
+
+    GHashTable *ratings = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    JsonObjectIter iter;
+    json_object_iter_init (&iter, json_node_get_object (json_parser_get_root (parser)));
+    const gchar *app_id;
+    JsonNode *node;
+    while (json_object_iter_next (&iter, &app_id, &node)) {
+        JsonObject *o = json_node_get_object (node);
+        gint64 *values = g_new0 (gint64, 5);
+        values[0] = json_object_get_int_member (o, "star1");
+        values[1] = json_object_get_int_member (o, "star2");
+        values[2] = json_object_get_int_member (o, "star3");
+        values[3] = json_object_get_int_member (o, "star4");
+        values[4] = json_object_get_int_member (o, "star5");
+        g_hash_table_insert (ratings, g_strdup (app_id), values);
+    }
+
+    return ratings;
+}
+
+static StoreOdrsRatings *
+parse_stream (const gchar *data, gsize length)
+{
+    g_autoptr(StoreOdrsRatings) ratings = store_odrs_ratings_new ();
+    for (gsize offset = 0; offset < length; offset += 65535)
+        if (!store_odrs_ratings_feed (ratings, data + offset, MIN (length - offset, 65535), NULL))
+            return NULL;
+    if (!store_odrs_ratings_complete (ratings, NULL))
+        return NULL;
+    return g_steal_pointer (&ratings);
+}
+
+int
+main (int argc G_GNUC_UNUSED, char **argv G_GNUC_UNUSED)
+{
+    g_autoptr(GMainLoop) loop = g_main_loop_new (NULL, FALSE);
+
+    /* Synthetic feed with a similar size and shape to odrs.gnome.org */
+    g_autoptr(MockOdrsServer) server = mock_odrs_server_new ();
+    g_autoptr(GRand) rand = g_rand_new_with_seed (42);
+    for (guint i = 0; i < N_APPS; i++) {
+        g_autofree gchar *id = g_strdup_printf ("io.snapcraft.app%05u-%08x", i, g_rand_int (rand));
+        MockApp *app = mock_odrs_server_add_app (server, id);
+        for (gint stars = 0; stars <= 5; stars++)
+            mock_app_set_star_count (app, stars, g_rand_int_range (rand, 0, 1000));
+    }
+    g_autoptr(GError) error = NULL;
+    if (!mock_odrs_server_start (server, &error)) {
+        g_printerr ("Failed to start server: %s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    g_autofree gchar *server_uri = g_strdup_printf ("http://127.0.0.1:%u", mock_odrs_server_get_port (server));
+
+    g_autoptr(SoupSession) session = soup_session_new ();
+    g_autofree gchar *feed_uri = g_strdup_printf ("%s/1.0/reviews/api/ratings", server_uri);
+    g_autoptr(SoupMessage) message = soup_message_new ("GET", feed_uri);
+    soup_session_queue_message (session, g_object_ref (message), feed_cb, loop);
+    g_main_loop_run (loop);
+    if (message->status_code != SOUP_STATUS_OK) {
+        g_printerr ("Failed to get ratings feed: %d\n", message->status_code);
+        return EXIT_FAILURE;
+    }
+    const gchar *data = message->response_body->data;
+    gsize length = message->response_body->length;
+
+    gint64 heap_start = get_heap_size ();
+    gint64 start = g_get_monotonic_time ();
+    g_autoptr(GHashTable) dom_ratings = parse_dom (data, length);
+    gint64 duration = g_get_monotonic_time () - start;
+    report ("ratings-parse-dom", duration, heap_start >= 0 ? get_heap_size () - heap_start : -1);
+    if (dom_ratings == NULL || g_hash_table_size (dom_ratings) != N_APPS)
+        return EXIT_FAILURE;
+
+    heap_start = get_heap_size ();
+    start = g_get_monotonic_time ();
+    g_autoptr(StoreOdrsRatings) ratings = parse_stream (data, length);
+    duration = g_get_monotonic_time () - start;
+    report ("ratings-parse-stream", duration, heap_start >= 0 ? get_heap_size () - heap_start : -1);
+    if (ratings == NULL || store_odrs_ratings_get_length (ratings) != N_APPS)
+        return EXIT_FAILURE;
+
+    /* Full download and parse through the client */
+    g_autoptr(StoreHttp) http = store_http_new ();
+    g_autoptr(StoreOdrsClient) client = store_odrs_client_new ();
+    store_odrs_client_set_http (client, http);
+    store_odrs_client_set_server_uri (client, server_uri);
+    start = g_get_monotonic_time ();
+    store_odrs_client_update_ratings_async (client, NULL, ratings_cb, loop);
+    g_main_loop_run (loop);
+    report ("ratings-update", g_get_monotonic_time () - start, -1);
+
+    return EXIT_SUCCESS;
+}
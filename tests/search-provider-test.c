@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <json-glib/json-glib.h>
+
+#include "store-search-provider.h"
+#include "temp-dir.h"
+
+#define OBJECT_PATH "/io/snapcraft/Store/SearchProvider"
+#define INTERFACE_NAME "org.gnome.Shell.SearchProvider2"
+
+typedef struct
+{
+    GTestDBus *bus;
+    GDBusConnection *connection;
+    StoreCache *cache;
+    StoreSearchProvider *provider;
+} Fixture;
+
+static void
+add_snap (StoreCache *cache, const gchar *name, const gchar *json)
+{
+    g_autoptr(GError) error = NULL;
+    g_autoptr(JsonNode) node = json_from_string (json, &error);
+    g_assert_no_error (error);
+    store_cache_insert_json (cache, "snaps", name, FALSE, node, NULL, &error);
+    g_assert_no_error (error);
+}
+
+static void
+fixture_set_up (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    fixture->bus = g_test_dbus_new (G_TEST_DBUS_NONE);
+    g_test_dbus_up (fixture->bus);
+
+    g_autoptr(GError) error = NULL;
+    fixture->connection = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, &error);
+    g_assert_no_error (error);
+
+    fixture->cache = store_cache_new ();
+    add_snap (fixture->cache, "gimp",
+              "{\"title\": \"GIMP\", \"summary\": \"GNU Image Manipulation Program\", \"publisher\": \"Snapcrafters\","
+              " \"icon\": {\"uri\": \"https://example.com/gimp.png\"}}");
+    add_snap (fixture->cache, "inkscape",
+              "{\"title\": \"Inkscape\", \"summary\": \"Vector graphics editor\", \"publisher\": \"Inkscape Project\"}");
+    add_snap (fixture->cache, "image-viewer",
+              "{\"title\": \"Viewer\", \"summary\": \"Look at image files\", \"publisher\": \"Snapcrafters\"}");
+    g_autoptr(GBytes) icon = g_bytes_new_static ("PNG", 3);
+    store_cache_insert (fixture->cache, "images", "https://example.com/gimp.png", TRUE, icon, NULL, &error);
+    g_assert_no_error (error);
+
+    fixture->provider = store_search_provider_new ();
+    store_search_provider_set_cache (fixture->provider, fixture->cache);
+    store_search_provider_register (fixture->provider, fixture->connection, OBJECT_PATH, &error);
+    g_assert_no_error (error);
+}
+
+static void
+fixture_tear_down (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    g_clear_object (&fixture->provider);
+    g_clear_object (&fixture->cache);
+    g_clear_object (&fixture->connection);
+    g_test_dbus_down (fixture->bus);
+    g_clear_object (&fixture->bus);
+}
+
+static void
+call_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    GVariant **reply = user_data;
+
+    g_autoptr(GError) error = NULL;
+    *reply = g_dbus_connection_call_finish (G_DBUS_CONNECTION (object), result, &error);
+    g_assert_no_error (error);
+}
+
+/* The provider answers from this thread's main context, so wait for the reply there */
+static GVariant *
+call (Fixture *fixture, const gchar *method_name, GVariant *parameters, const gchar *reply_type)
+{
+    GVariant *reply = NULL;
+    g_dbus_connection_call (fixture->connection, g_dbus_connection_get_unique_name (fixture->connection),
+                            OBJECT_PATH, INTERFACE_NAME, method_name, parameters, G_VARIANT_TYPE (reply_type),
+                            G_DBUS_CALL_FLAGS_NONE, -1, NULL, call_cb, &reply);
+    while (reply == NULL)
+        g_main_context_iteration (NULL, TRUE);
+
+    return reply;
+}
+
+static GVariant *
+get_initial_result_set (Fixture *fixture, const gchar * const *terms)
+{
+    return call (fixture, "GetInitialResultSet", g_variant_new ("(^as)", terms), "(as)");
+}
+
+static void
+assert_results (GVariant *reply, const gchar * const *expected)
+{
+    g_autofree const gchar **results = NULL;
+    g_variant_get (reply, "(^a&s)", &results);
+    for (int i = 0; results[i] != NULL || expected[i] != NULL; i++)
+        g_assert_cmpstr (results[i], ==, expected[i]);
+}
+
+static void
+test_initial_result_set (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    /* Matches name, title, summary and publisher, case insensitively, with name prefix matches first */
+    const gchar *image_terms[] = { "IMAGE", NULL };
+    const gchar *image_results[] = { "image-viewer", "gimp", NULL };
+    g_autoptr(GVariant) image_reply = get_initial_result_set (fixture, image_terms);
+    assert_results (image_reply, image_results);
+
+    /* All terms must match */
+    const gchar *snapcrafters_terms[] = { "snapcrafters", "gnu", NULL };
+    const gchar *snapcrafters_results[] = { "gimp", NULL };
+    g_autoptr(GVariant) snapcrafters_reply = get_initial_result_set (fixture, snapcrafters_terms);
+    assert_results (snapcrafters_reply, snapcrafters_results);
+
+    const gchar *missing_terms[] = { "spreadsheet", NULL };
+    const gchar *missing_results[] = { NULL };
+    g_autoptr(GVariant) missing_reply = get_initial_result_set (fixture, missing_terms);
+    assert_results (missing_reply, missing_results);
+}
+
+static void
+test_subsearch_result_set (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    /* Unknown IDs are dropped and the previous order is kept */
+    const gchar *previous_results[] = { "gimp", "unknown", "image-viewer", "inkscape", NULL };
+    const gchar *terms[] = { "image", NULL };
+    const gchar *results[] = { "gimp", "image-viewer", NULL };
+    g_autoptr(GVariant) reply = call (fixture, "GetSubsearchResultSet", g_variant_new ("(^as^as)", previous_results, terms), "(as)");
+    assert_results (reply, results);
+}
+
+static void
+test_result_metas (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    /* Build the index first, metas are only returned for indexed snaps */
+    const gchar *terms[] = { "i", NULL };
+    g_autoptr(GVariant) result_set = get_initial_result_set (fixture, terms);
+
+    const gchar *identifiers[] = { "gimp", "unknown", "inkscape", NULL };
+    g_autoptr(GVariant) reply = call (fixture, "GetResultMetas", g_variant_new ("(^as)", identifiers), "(aa{sv})");
+    g_autoptr(GVariant) metas = g_variant_get_child_value (reply, 0);
+    g_assert_cmpint (g_variant_n_children (metas), ==, 2);
+
+    g_autoptr(GVariant) gimp_meta = g_variant_get_child_value (metas, 0);
+    g_autoptr(GVariantDict) gimp = g_variant_dict_new (gimp_meta);
+    const gchar *value;
+    g_assert_true (g_variant_dict_lookup (gimp, "id", "&s", &value));
+    g_assert_cmpstr (value, ==, "gimp");
+    g_assert_true (g_variant_dict_lookup (gimp, "name", "&s", &value));
+    g_assert_cmpstr (value, ==, "GIMP");
+    g_assert_true (g_variant_dict_lookup (gimp, "description", "&s", &value));
+    g_assert_cmpstr (value, ==, "GNU Image Manipulation Program");
+
+    /* The cached icon is sent as data, otherwise a generic icon is used */
+    g_autoptr(GVariant) gimp_icon_data = g_variant_dict_lookup_value (gimp, "icon", NULL);
+    g_assert_nonnull (gimp_icon_data);
+    g_autoptr(GIcon) gimp_icon = g_icon_deserialize (gimp_icon_data);
+    g_assert_true (G_IS_BYTES_ICON (gimp_icon));
+
+    g_autoptr(GVariant) inkscape_meta = g_variant_get_child_value (metas, 1);
+    g_autoptr(GVariantDict) inkscape = g_variant_dict_new (inkscape_meta);
+    g_assert_true (g_variant_dict_lookup (inkscape, "id", "&s", &value));
+    g_assert_cmpstr (value, ==, "inkscape");
+    g_autoptr(GVariant) inkscape_icon_data = g_variant_dict_lookup_value (inkscape, "icon", NULL);
+    g_assert_nonnull (inkscape_icon_data);
+    g_autoptr(GIcon) inkscape_icon = g_icon_deserialize (inkscape_icon_data);
+    g_assert_true (G_IS_THEMED_ICON (inkscape_icon));
+}
+
+static void
+test_no_cache (Fixture *fixture, gconstpointer user_data G_GNUC_UNUSED)
+{
+    store_search_provider_set_cache (fixture->provider, NULL);
+
+    const gchar *terms[] = { "gimp", NULL };
+    const gchar *results[] = { NULL };
+    g_autoptr(GVariant) reply = get_initial_result_set (fixture, terms);
+    assert_results (reply, results);
+}
+
+int
+main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_autoptr(GError) error = NULL;
+    g_autofree gchar *cache_dir = temp_dir_new_cache (&error);
+    g_assert_no_error (error);
+
+    g_test_add ("/search-provider/initial-result-set", Fixture, NULL, fixture_set_up, test_initial_result_set, fixture_tear_down);
+    g_test_add ("/search-provider/subsearch-result-set", Fixture, NULL, fixture_set_up, test_subsearch_result_set, fixture_tear_down);
+    g_test_add ("/search-provider/result-metas", Fixture, NULL, fixture_set_up, test_result_metas, fixture_tear_down);
+    g_test_add ("/search-provider/no-cache", Fixture, NULL, fixture_set_up, test_no_cache, fixture_tear_down);
+
+    int result = g_test_run ();
+    temp_dir_remove (cache_dir);
+
+    return result;
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <glib/gstdio.h>
+
+#include "temp-dir.h"
+
+/* Points XDG_CACHE_HOME at a new directory so the real cache is never touched */
+gchar *
+temp_dir_new_cache (GError **error)
+{
+    g_autofree gchar *path = g_dir_make_tmp ("snap-store-test-XXXXXX", error);
+    if (path == NULL)
+        return NULL;
+
+    g_setenv ("XDG_CACHE_HOME", path, TRUE);
+
+    return g_steal_pointer (&path);
+}
+
+void
+temp_dir_remove (const gchar *path)
+{
+    g_autoptr(GDir) dir = g_dir_open (path, 0, NULL);
+    if (dir != NULL) {
+        const gchar *name;
+        while ((name = g_dir_read_name (dir)) != NULL) {
+            g_autofree gchar *child_path = g_build_filename (path, name, NULL);
+            if (g_file_test (child_path, G_FILE_TEST_IS_DIR))
+                temp_dir_remove (child_path);
+            else
+                g_unlink (child_path);
+        }
+    }
+    g_rmdir (path);
+}